@@ -0,0 +1,173 @@
+#include "Culling.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CULLING_AVX
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CULLING_SSE
+#endif
+
+Frustum extractFrustum(const glm::mat4& projViewMatrix)
+{
+	// rows of the (column major) matrix
+	const glm::mat4& m = projViewMatrix;
+	glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	Frustum frustum;
+	frustum.planes[0] = row3 + row0;	// left
+	frustum.planes[1] = row3 - row0;	// right
+	frustum.planes[2] = row3 + row1;	// bottom
+	frustum.planes[3] = row3 - row1;	// top
+	frustum.planes[4] = row3 + row2;	// near
+	frustum.planes[5] = row3 - row2;	// far
+
+	// normalise so that plane distances are in world units
+	for (int i = 0; i < 6; i++)
+	{
+		glm::vec4& p = frustum.planes[i];
+		p = p / glm::length(glm::vec3(p));
+	}
+
+	return frustum;
+}
+
+FrustumCuller::FrustumCuller()
+{}
+
+FrustumCuller::~FrustumCuller()
+{}
+
+void FrustumCuller::clear()
+{
+	mCenterX.clear();
+	mCenterY.clear();
+	mCenterZ.clear();
+	mRadius.clear();
+}
+
+int FrustumCuller::add(const glm::vec3& center, float radius)
+{
+	mCenterX.push_back(center.x);
+	mCenterY.push_back(center.y);
+	mCenterZ.push_back(center.z);
+	mRadius.push_back(radius);
+	return static_cast<int>(mRadius.size()) - 1;
+}
+
+int FrustumCuller::add(const glm::vec3& center, float radius, const glm::mat4& modelMatrix)
+{
+	add(glm::vec3(0.0f), 0.0f);
+	update(getCount() - 1, center, radius, modelMatrix);
+	return getCount() - 1;
+}
+
+void FrustumCuller::update(int index, const glm::vec3& center, float radius, const glm::mat4& modelMatrix)
+{
+	// scale the radius by the largest axis scale of the model matrix
+	float scale = glm::max(glm::length(glm::vec3(modelMatrix[0])),
+		glm::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+
+	glm::vec3 worldCenter = glm::vec3(modelMatrix * glm::vec4(center, 1.0f));
+	mCenterX[index] = worldCenter.x;
+	mCenterY[index] = worldCenter.y;
+	mCenterZ[index] = worldCenter.z;
+	mRadius[index] = radius * scale;
+}
+
+int FrustumCuller::cull(const Frustum& frustum, std::vector<uint8_t>& visible) const
+{
+	const int count = getCount();
+	visible.resize(count);
+
+	int numVisible = 0;
+	int i = 0;
+
+#if defined(CULLING_AVX)
+	__m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (int p = 0; p < 6; p++)
+	{
+		planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+		planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+		planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+		planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+	}
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 x = _mm256_loadu_ps(&mCenterX[i]);
+		__m256 y = _mm256_loadu_ps(&mCenterY[i]);
+		__m256 z = _mm256_loadu_ps(&mCenterZ[i]);
+		__m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&mRadius[i]));
+
+		// a sphere is outside if it lies entirely behind any plane
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (int p = 0; p < 6; p++)
+		{
+			__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y)),
+				_mm256_add_ps(_mm256_mul_ps(planeZ[p], z), planeW[p]));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, negRadius, _CMP_GE_OQ));
+		}
+
+		int mask = _mm256_movemask_ps(inside);
+		for (int lane = 0; lane < 8; lane++)
+		{
+			visible[i + lane] = (mask >> lane) & 1;
+			numVisible += (mask >> lane) & 1;
+		}
+	}
+#elif defined(CULLING_SSE)
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (int p = 0; p < 6; p++)
+	{
+		planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+		planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+		planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+		planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+	}
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(&mCenterX[i]);
+		__m128 y = _mm_loadu_ps(&mCenterY[i]);
+		__m128 z = _mm_loadu_ps(&mCenterZ[i]);
+		__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&mRadius[i]));
+
+		// a sphere is outside if it lies entirely behind any plane
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p = 0; p < 6; p++)
+		{
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+				_mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, negRadius));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for (int lane = 0; lane < 4; lane++)
+		{
+			visible[i + lane] = (mask >> lane) & 1;
+			numVisible += (mask >> lane) & 1;
+		}
+	}
+#endif
+
+	// remaining spheres
+	for (; i < count; i++)
+	{
+		bool inside = true;
+		for (int p = 0; p < 6 && inside; p++)
+		{
+			const glm::vec4& plane = frustum.planes[p];
+			float dist = plane.x * mCenterX[i] + plane.y * mCenterY[i] + plane.z * mCenterZ[i] + plane.w;
+			inside = (dist >= -mRadius[i]);
+		}
+
+		visible[i] = inside ? 1 : 0;
+		numVisible += inside ? 1 : 0;
+	}
+
+	return numVisible;
+}
@@ -0,0 +1,99 @@
+#include "FrameHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+FrameHistogram::FrameHistogram()
+{
+	clear();
+}
+
+void FrameHistogram::record(uint64_t value)
+{
+	mCounts[bucketIndex(value)]++;
+	mTotalCount++;
+	mSum += value;
+}
+
+void FrameHistogram::remove(uint64_t value)
+{
+	int bucket = bucketIndex(value);
+	if (mCounts[bucket] == 0)
+		return;
+
+	mCounts[bucket]--;
+	mTotalCount--;
+	mSum -= value;
+}
+
+void FrameHistogram::clear()
+{
+	std::memset(mCounts, 0, sizeof(mCounts));
+	mTotalCount = 0;
+	mSum = 0;
+}
+
+double FrameHistogram::getMean() const
+{
+	return mTotalCount ? static_cast<double>(mSum) / mTotalCount : 0.0;
+}
+
+uint64_t FrameHistogram::getPercentile(double percentile) const
+{
+	if (mTotalCount == 0)
+		return 0;
+
+	// the smallest value at or below which the percentile of the values lie
+	double fraction = std::min(std::max(percentile, 0.0), 100.0) / 100.0;
+	uint64_t target = static_cast<uint64_t>(std::ceil(fraction * mTotalCount));
+	if (target == 0)
+		target = 1;
+
+	uint64_t seen = 0;
+	for (int bucket = 0; bucket < kBucketCount; bucket++)
+	{
+		seen += mCounts[bucket];
+		if (seen >= target)
+			return getHighestValue(bucket);
+	}
+	return getHighestValue(kBucketCount - 1);
+}
+
+uint64_t FrameHistogram::getLowestValue(int bucket)
+{
+	if (bucket < kSubBuckets)
+		return static_cast<uint64_t>(bucket);
+
+	// mantissa of kSubBucketBits bits with its top bit set, shifted by the exponent
+	int offset = bucket - kSubBuckets;
+	int exponent = kSubBucketBits + offset / (kSubBuckets / 2);
+	uint64_t mantissa = kSubBuckets / 2 + offset % (kSubBuckets / 2);
+	return mantissa << (exponent - kSubBucketBits + 1);
+}
+
+uint64_t FrameHistogram::getHighestValue(int bucket)
+{
+	if (bucket < kSubBuckets)
+		return static_cast<uint64_t>(bucket);
+
+	int offset = bucket - kSubBuckets;
+	int exponent = kSubBucketBits + offset / (kSubBuckets / 2);
+	return getLowestValue(bucket) + (1ull << (exponent - kSubBucketBits + 1)) - 1;
+}
+
+int FrameHistogram::bucketIndex(uint64_t value)
+{
+	if (value < static_cast<uint64_t>(kSubBuckets))
+		return static_cast<int>(value);
+	if (value >> kMaxExponent)
+		return kBucketCount - 1;
+
+	int exponent = 63;
+	while (!(value >> exponent))
+		exponent--;
+
+	int shift = exponent - kSubBucketBits + 1;
+	int mantissa = static_cast<int>(value >> shift);
+	return kSubBuckets + (exponent - kSubBucketBits) * (kSubBuckets / 2) + (mantissa - kSubBuckets / 2);
+}
@@ -0,0 +1,136 @@
+#include "FrameTimeRecorder.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace
+{
+	const double kPercentiles[] = { 50.0, 90.0, 99.0, 99.9 };
+	const char* const kPercentileNames[] = { "p50", "p90", "p99", "p99.9" };
+	const int kPercentileCount = 4;
+}
+
+FrameTimeRecorder::FrameTimeRecorder(const std::string& name, size_t windowFrames)
+	: mName(name), mWindow(std::max(windowFrames, static_cast<size_t>(1)))
+{}
+
+void FrameTimeRecorder::record(float milliseconds)
+{
+	uint64_t value = static_cast<uint64_t>(std::llround(std::max(milliseconds, 0.0f) * 1000.0));
+	bool hitch = milliseconds > mBudget;
+
+	mTotal.record(value);
+	mMax = std::max(mMax, value);
+	if (hitch)
+		mHitches++;
+
+	// the oldest frame leaves the window once it is full
+	WindowFrame& frame = mWindow[mWindowNext];
+	if (mWindowHistogram.getCount() == mWindow.size())
+	{
+		mWindowHistogram.remove(frame.value);
+		if (frame.hitch)
+			mWindowHitches--;
+	}
+
+	frame.value = value;
+	frame.hitch = hitch;
+	mWindowHistogram.record(value);
+	if (hitch)
+		mWindowHitches++;
+	mWindowNext = (mWindowNext + 1) % mWindow.size();
+}
+
+void FrameTimeRecorder::clear()
+{
+	mTotal.clear();
+	mMax = 0;
+	mHitches = 0;
+
+	mWindowHistogram.clear();
+	mWindowNext = 0;
+	mWindowHitches = 0;
+}
+
+float FrameTimeRecorder::getPercentile(double percentile) const
+{
+	// a bucket's highest value may lie above anything recorded
+	return toMilliseconds(std::min(mTotal.getPercentile(percentile), mMax));
+}
+
+float FrameTimeRecorder::getWindowPercentile(double percentile) const
+{
+	return std::min(toMilliseconds(mWindowHistogram.getPercentile(percentile)), getWindowMax());
+}
+
+float FrameTimeRecorder::getWindowMax() const
+{
+	uint64_t max = 0;
+	size_t count = static_cast<size_t>(mWindowHistogram.getCount());
+	for (size_t i = 0; i < count; i++)
+		max = std::max(max, mWindow[i].value);
+	return toMilliseconds(max);
+}
+
+void FrameTimeRecorder::writeCsvHeader(std::ostream& out)
+{
+	out << "series,scope,frames,hitches,mean_ms";
+	for (int p = 0; p < kPercentileCount; p++)
+		out << "," << kPercentileNames[p] << "_ms";
+	out << ",max_ms\n";
+}
+
+void FrameTimeRecorder::writeCsv(std::ostream& out) const
+{
+	out << std::fixed << std::setprecision(3);
+
+	out << mName << ",total," << mTotal.getCount() << "," << mHitches << "," << mTotal.getMean() * 1.0e-3;
+	for (int p = 0; p < kPercentileCount; p++)
+		out << "," << getPercentile(kPercentiles[p]);
+	out << "," << getMax() << "\n";
+
+	out << mName << ",window," << mWindowHistogram.getCount() << "," << mWindowHitches << "," << mWindowHistogram.getMean() * 1.0e-3;
+	for (int p = 0; p < kPercentileCount; p++)
+		out << "," << getWindowPercentile(kPercentiles[p]);
+	out << "," << getWindowMax() << "\n";
+}
+
+void FrameTimeRecorder::writeJson(std::ostream& out) const
+{
+	out << std::fixed << std::setprecision(3);
+	out << "{\"name\": ";
+	Profiler::writeJsonString(out, mName);
+	out << ", \"budgetMs\": " << mBudget << ", \"windowFrames\": " << mWindow.size() << ",\n";
+	writeSummary(out, "total", mTotal, mHitches, getMax());
+	out << ",\n";
+	writeSummary(out, "window", mWindowHistogram, mWindowHitches, getWindowMax());
+
+	// [lowest ms, highest ms, frames] of every bucket of the whole run that holds frames
+	out << ",\n\t\"buckets\": [";
+	bool first = true;
+	for (int bucket = 0; bucket < FrameHistogram::kBucketCount; bucket++)
+	{
+		uint32_t count = mTotal.getBucketCount(bucket);
+		if (count == 0)
+			continue;
+
+		out << (first ? "" : ", ") << "[" << toMilliseconds(FrameHistogram::getLowestValue(bucket)) << ", "
+			<< toMilliseconds(FrameHistogram::getHighestValue(bucket)) << ", " << count << "]";
+		first = false;
+	}
+	out << "]}";
+}
+
+void FrameTimeRecorder::writeSummary(std::ostream& out, const char* scope, const FrameHistogram& histogram, uint64_t hitches, float max) const
+{
+	out << "\t\"" << scope << "\": {\"frames\": " << histogram.getCount() << ", \"hitches\": " << hitches
+		<< ", \"meanMs\": " << histogram.getMean() * 1.0e-3;
+	for (int p = 0; p < kPercentileCount; p++)
+	{
+		uint64_t value = histogram.getPercentile(kPercentiles[p]);
+		out << ", \"" << kPercentileNames[p] << "Ms\": " << std::min(toMilliseconds(value), max);
+	}
+	out << ", \"maxMs\": " << max << "}";
+}
@@ -0,0 +1,292 @@
+#include "GLState.h"
+#include "RenderStats.h"
+
+#include <cstring>
+
+namespace
+{
+	const GLuint kUnknown = ~0u;
+
+	// texture targets with cached bindings, others are always passed on
+	const GLenum kTargets[] = { GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BUFFER };
+	const int kTargetCount = 3;
+
+	// cached values, kUnknown (or -1 for flags) when not known
+	struct State
+	{
+		GLuint program;
+		GLuint vertexArray;
+		GLuint activeUnit;
+		GLuint textures[GLState::kMaxTextureUnits][kTargetCount];
+		int depthTest;
+		GLuint depthFunc;
+		int depthMask;
+		int colorMask;
+		int blend;
+		GLuint blendSource;
+		GLuint blendDestination;
+		int cullFace;
+		GLuint cullFaceMode;
+
+		int issued;
+		int skipped;
+	};
+
+	int targetIndex(GLenum target)
+	{
+		for (int i = 0; i < kTargetCount; i++)
+		{
+			if (kTargets[i] == target)
+				return i;
+		}
+		return -1;
+	}
+
+	void forget(State& cache)
+	{
+		cache.program = kUnknown;
+		cache.vertexArray = kUnknown;
+		cache.activeUnit = kUnknown;
+		for (int unit = 0; unit < GLState::kMaxTextureUnits; unit++)
+		{
+			for (int t = 0; t < kTargetCount; t++)
+				cache.textures[unit][t] = kUnknown;
+		}
+		cache.depthTest = -1;
+		cache.depthFunc = kUnknown;
+		cache.depthMask = -1;
+		cache.colorMask = -1;
+		cache.blend = -1;
+		cache.blendSource = kUnknown;
+		cache.blendDestination = kUnknown;
+		cache.cullFace = -1;
+		cache.cullFaceMode = kUnknown;
+	}
+
+	State unknownState()
+	{
+		State cache = {};
+		forget(cache);
+		return cache;
+	}
+
+	State state = unknownState();
+	bool filtering = true;
+
+	// true if the call has to be made, updating the cached value and the counters
+	template<typename T>
+	bool changes(T& cached, T value)
+	{
+		if (filtering && cached == value)
+		{
+			state.skipped++;
+			return false;
+		}
+
+		cached = value;
+		state.issued++;
+		return true;
+	}
+
+	void setCapability(int& cached, GLenum capability, bool enabled)
+	{
+		if (changes(cached, enabled ? 1 : 0))
+		{
+			if (enabled)
+				glEnable(capability);
+			else
+				glDisable(capability);
+		}
+	}
+}
+
+void GLState::useProgram(GLuint program)
+{
+	if (changes(state.program, program))
+	{
+		glUseProgram(program);
+		RenderStats::add(STAT_PROGRAM_SWITCHES);
+	}
+}
+
+void GLState::bindVertexArray(GLuint vertexArray)
+{
+	if (changes(state.vertexArray, vertexArray))
+	{
+		glBindVertexArray(vertexArray);
+		RenderStats::add(STAT_VERTEX_ARRAY_BINDS);
+	}
+}
+
+void GLState::activeTexture(int unit)
+{
+	if (changes(state.activeUnit, static_cast<GLuint>(unit)))
+		glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture)
+{
+	// untracked targets, or a bind before any unit was made active, are always passed on
+	int t = targetIndex(target);
+	if (t < 0 || state.activeUnit >= static_cast<GLuint>(kMaxTextureUnits))
+	{
+		state.issued++;
+		glBindTexture(target, texture);
+		RenderStats::add(STAT_TEXTURE_BINDS);
+		return;
+	}
+
+	if (changes(state.textures[state.activeUnit][t], texture))
+	{
+		glBindTexture(target, texture);
+		RenderStats::add(STAT_TEXTURE_BINDS);
+	}
+}
+
+void GLState::bindTexture(int unit, GLenum target, GLuint texture)
+{
+	int t = targetIndex(target);
+	if (filtering && t >= 0 && unit < kMaxTextureUnits && state.textures[unit][t] == texture)
+	{
+		state.skipped++;
+		return;
+	}
+
+	activeTexture(unit);
+	bindTexture(target, texture);
+}
+
+void GLState::setDepthTest(bool enabled)
+{
+	setCapability(state.depthTest, GL_DEPTH_TEST, enabled);
+}
+
+void GLState::setDepthFunc(GLenum func)
+{
+	if (changes(state.depthFunc, static_cast<GLuint>(func)))
+		glDepthFunc(func);
+}
+
+void GLState::setDepthMask(bool write)
+{
+	if (changes(state.depthMask, write ? 1 : 0))
+		glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void GLState::setColorMask(bool write)
+{
+	if (changes(state.colorMask, write ? 1 : 0))
+	{
+		GLboolean mask = write ? GL_TRUE : GL_FALSE;
+		glColorMask(mask, mask, mask, mask);
+	}
+}
+
+void GLState::setBlend(bool enabled)
+{
+	setCapability(state.blend, GL_BLEND, enabled);
+}
+
+void GLState::setBlendFunc(GLenum sourceFactor, GLenum destinationFactor)
+{
+	if (filtering && state.blendSource == sourceFactor && state.blendDestination == destinationFactor)
+	{
+		state.skipped++;
+		return;
+	}
+
+	state.blendSource = sourceFactor;
+	state.blendDestination = destinationFactor;
+	state.issued++;
+	glBlendFunc(sourceFactor, destinationFactor);
+}
+
+void GLState::setCullFace(bool enabled)
+{
+	setCapability(state.cullFace, GL_CULL_FACE, enabled);
+}
+
+void GLState::setCullFaceMode(GLenum mode)
+{
+	if (changes(state.cullFaceMode, static_cast<GLuint>(mode)))
+		glCullFace(mode);
+}
+
+void GLState::programDeleted(GLuint program)
+{
+	// a deleted program stays in use until another one is, so only its name is forgotten
+	if (state.program == program)
+		state.program = kUnknown;
+}
+
+void GLState::vertexArrayDeleted(GLuint vertexArray)
+{
+	if (state.vertexArray == vertexArray)
+		state.vertexArray = 0;
+}
+
+void GLState::textureDeleted(GLuint texture)
+{
+	for (int unit = 0; unit < kMaxTextureUnits; unit++)
+	{
+		for (int t = 0; t < kTargetCount; t++)
+		{
+			if (state.textures[unit][t] == texture)
+				state.textures[unit][t] = 0;
+		}
+	}
+}
+
+void GLState::invalidate()
+{
+	forget(state);
+}
+
+void GLState::setFiltering(bool enabled)
+{
+	filtering = enabled;
+}
+
+bool GLState::getFiltering()
+{
+	return filtering;
+}
+
+void GLState::resetCounters()
+{
+	state.issued = 0;
+	state.skipped = 0;
+}
+
+int GLState::getIssuedCount()
+{
+	return state.issued;
+}
+
+int GLState::getSkippedCount()
+{
+	return state.skipped;
+}
+
+bool GLState::isVersionAtLeast(int major, int minor)
+{
+	GLint contextMajor = 0;
+	GLint contextMinor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+	glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+	return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
+
+bool GLState::isExtensionSupported(const char* name)
+{
+	// core profiles only list extensions one at a time
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; i++)
+	{
+		const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+		if (extension != nullptr && strcmp(extension, name) == 0)
+			return true;
+	}
+	return false;
+}
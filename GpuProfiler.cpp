@@ -0,0 +1,257 @@
+#include "GpuProfiler.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	struct FrameZone
+	{
+		const char* name;
+		bool ended;
+	};
+
+	// queries of one frame in flight; zone i begins at query 2i and ends at query 2i + 1
+	struct Frame
+	{
+		GLuint queries[GpuProfiler::kMaxZones * 2];
+		std::vector<FrameZone> zones;
+		GLuint lastQuery = 0;		// issued last, so the frame is ready once it is
+		int64_t clockOffset = 0;	// profiler clock minus GPU clock in nanoseconds
+		bool pending = false;
+	};
+
+	struct Zone
+	{
+		const char* name;
+		float frames[GpuProfiler::kRollingFrames];	// milliseconds per frame
+		float total;
+	};
+
+	struct State
+	{
+		bool enabled = true;
+		bool timing = false;		// zones of the current frame are timed
+		bool created = false;		// query objects generated
+		Frame frames[GpuProfiler::kFrames];
+		int frame = 0;
+
+		std::vector<Zone> zones;
+		std::unordered_map<const char*, size_t> zonesByPointer;
+		std::map<std::string, size_t> zonesByName;
+		int frameSlot = 0;
+		int dropped = 0;
+		uint64_t framesRead = 0;
+		float frameTime = 0.0f;
+	};
+
+	State state;
+
+	size_t zoneIndex(const char* name)
+	{
+		auto found = state.zonesByPointer.find(name);
+		if (found != state.zonesByPointer.end())
+			return found->second;
+
+		// the same name may be a different literal in another translation unit
+		auto named = state.zonesByName.find(name);
+		size_t index;
+		if (named != state.zonesByName.end())
+		{
+			index = named->second;
+		}
+		else
+		{
+			Zone zone;
+			zone.name = name;
+			zone.total = 0.0f;
+			for (int i = 0; i < GpuProfiler::kRollingFrames; i++)
+				zone.frames[i] = 0.0f;
+
+			index = state.zones.size();
+			state.zones.push_back(zone);
+			state.zonesByName[name] = index;
+		}
+
+		state.zonesByPointer[name] = index;
+		return index;
+	}
+
+	uint64_t profilerTime(const Frame& frame, GLuint64 gpuTime)
+	{
+		int64_t time = static_cast<int64_t>(gpuTime) + frame.clockOffset;
+		return time > 0 ? static_cast<uint64_t>(time) : 0;
+	}
+
+	// fold the results of a frame into the rolling breakdown and the trace, dropping it if not ready
+	void readFrame(Frame& frame)
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(frame.lastQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			state.dropped++;
+			return;
+		}
+
+		// reuse the oldest frame of the rolling window
+		state.frameSlot = (state.frameSlot + 1) % GpuProfiler::kRollingFrames;
+		for (size_t z = 0; z < state.zones.size(); z++)
+		{
+			state.zones[z].total -= state.zones[z].frames[state.frameSlot];
+			state.zones[z].frames[state.frameSlot] = 0.0f;
+		}
+
+		bool tracing = Profiler::isEnabled();
+		GLuint64 frameBegin = ~0ull;
+		GLuint64 frameEnd = 0;
+		for (size_t i = 0; i < frame.zones.size(); i++)
+		{
+			if (!frame.zones[i].ended)
+				continue;
+
+			GLuint64 begin = 0;
+			GLuint64 end = 0;
+			glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+			if (end < begin)
+				end = begin;
+			frameBegin = std::min(frameBegin, begin);
+			frameEnd = std::max(frameEnd, end);
+
+			Zone& zone = state.zones[zoneIndex(frame.zones[i].name)];
+			float milliseconds = (end - begin) * 1.0e-6f;
+			zone.frames[state.frameSlot] += milliseconds;
+			zone.total += milliseconds;
+
+			if (tracing)
+				Profiler::recordGpu(frame.zones[i].name, profilerTime(frame, begin), profilerTime(frame, end));
+		}
+
+		state.framesRead++;
+		state.frameTime = frameEnd > frameBegin ? (frameEnd - frameBegin) * 1.0e-6f : 0.0f;
+	}
+}
+
+void GpuProfiler::setEnabled(bool enabled)
+{
+	state.enabled = enabled;
+}
+
+bool GpuProfiler::isEnabled()
+{
+	return state.enabled;
+}
+
+void GpuProfiler::beginFrame()
+{
+	if (!state.created)
+	{
+		for (int i = 0; i < kFrames; i++)
+			glGenQueries(kMaxZones * 2, state.frames[i].queries);
+		state.created = true;
+	}
+
+	// the set of this frame was last used kFrames frames ago
+	Frame& frame = state.frames[state.frame];
+	if (frame.pending)
+		readFrame(frame);
+
+	frame.zones.clear();
+	frame.pending = false;
+	state.timing = state.enabled;
+
+	// GPU timestamps are placed in the trace relative to this moment
+	if (state.timing)
+	{
+		GLint64 gpuTime = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+		frame.clockOffset = static_cast<int64_t>(Profiler::now()) - gpuTime;
+	}
+}
+
+void GpuProfiler::endFrame()
+{
+	Frame& frame = state.frames[state.frame];
+	frame.pending = state.timing && !frame.zones.empty();
+
+	state.timing = false;
+	state.frame = (state.frame + 1) % kFrames;
+}
+
+int GpuProfiler::beginZone(const char* name)
+{
+	Frame& frame = state.frames[state.frame];
+	if (!state.timing || frame.zones.size() >= kMaxZones)
+		return -1;
+
+	int zone = static_cast<int>(frame.zones.size());
+	FrameZone frameZone;
+	frameZone.name = name;
+	frameZone.ended = false;
+	frame.zones.push_back(frameZone);
+
+	frame.lastQuery = frame.queries[zone * 2];
+	glQueryCounter(frame.lastQuery, GL_TIMESTAMP);
+	return zone;
+}
+
+void GpuProfiler::endZone(int zone)
+{
+	Frame& frame = state.frames[state.frame];
+	if (!state.timing || zone < 0 || zone >= static_cast<int>(frame.zones.size()))
+		return;
+
+	frame.lastQuery = frame.queries[zone * 2 + 1];
+	glQueryCounter(frame.lastQuery, GL_TIMESTAMP);
+	frame.zones[zone].ended = true;
+}
+
+size_t GpuProfiler::getZoneCount()
+{
+	return state.zones.size();
+}
+
+const char* GpuProfiler::getZoneName(size_t zone)
+{
+	return state.zones[zone].name;
+}
+
+float GpuProfiler::getZoneTime(size_t zone)
+{
+	// the running total drifts by float rounding, never show it below zero
+	float total = state.zones[zone].total;
+	return total > 0.0f ? total / kRollingFrames : 0.0f;
+}
+
+float GpuProfiler::getLastTime(const char* name)
+{
+	auto found = state.zonesByPointer.find(name);
+	if (found != state.zonesByPointer.end())
+		return state.zones[found->second].frames[state.frameSlot];
+
+	auto named = state.zonesByName.find(name);
+	if (named != state.zonesByName.end())
+		return state.zones[named->second].frames[state.frameSlot];
+	return 0.0f;
+}
+
+int GpuProfiler::getDroppedFrames()
+{
+	return state.dropped;
+}
+
+uint64_t GpuProfiler::getFramesRead()
+{
+	return state.framesRead;
+}
+
+float GpuProfiler::getFrameTime()
+{
+	return state.frameTime;
+}
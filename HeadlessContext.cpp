@@ -0,0 +1,135 @@
+#include "HeadlessContext.h"
+
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#define HEADLESS_EGL
+#endif
+
+#if defined(HEADLESS_EGL)
+// display of the Mesa surfaceless platform if the client extensions offer it, else the default one
+static EGLDisplay OpenDisplay()
+{
+	const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if (extensions != nullptr && std::strstr(extensions, "EGL_MESA_platform_surfaceless") != nullptr)
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+		if (getPlatformDisplay != nullptr)
+		{
+			EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+			if (display != EGL_NO_DISPLAY)
+				return display;
+		}
+	}
+
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+#endif
+
+HeadlessContext::HeadlessContext()
+{}
+
+HeadlessContext::~HeadlessContext()
+{
+	destroy();
+}
+
+bool HeadlessContext::create(int width, int height)
+{
+#if defined(HEADLESS_EGL)
+	EGLDisplay display = OpenDisplay();
+	EGLint major = 0;
+	EGLint minor = 0;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		std::cerr << "Unable to initialise an EGL display." << std::endl;
+		return false;
+	}
+	mDisplay = display;
+
+	// same colour, depth and stencil bits as the window asks for
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_STENCIL_SIZE, 8,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint numConfigs = 0;
+	if (!eglChooseConfig(display, configAttributes, &config, 1, &numConfigs) || numConfigs == 0)
+	{
+		std::cerr << "No EGL config supports desktop OpenGL pbuffers." << std::endl;
+		destroy();
+		return false;
+	}
+
+	const EGLint surfaceAttributes[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+	EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+	if (surface == EGL_NO_SURFACE)
+	{
+		std::cerr << "Unable to create an EGL pbuffer." << std::endl;
+		destroy();
+		return false;
+	}
+	mSurface = surface;
+
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext context = eglBindAPI(EGL_OPENGL_API)
+		? eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes) : EGL_NO_CONTEXT;
+	if (context == EGL_NO_CONTEXT)
+	{
+		std::cerr << "Unable to create an OpenGL 3.3 core context with EGL." << std::endl;
+		destroy();
+		return false;
+	}
+	mContext = context;
+
+	if (!eglMakeCurrent(display, surface, surface, context))
+	{
+		std::cerr << "Unable to make the EGL context current." << std::endl;
+		destroy();
+		return false;
+	}
+
+	// nothing is presented, so a swap interval has no effect; make sure of it anyway
+	eglSwapInterval(display, 0);
+	return true;
+#else
+	std::cerr << "Headless contexts need EGL, which is not available on this platform." << std::endl;
+	return false;
+#endif
+}
+
+void HeadlessContext::destroy()
+{
+#if defined(HEADLESS_EGL)
+	if (mDisplay == nullptr)
+		return;
+
+	EGLDisplay display = static_cast<EGLDisplay>(mDisplay);
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (mContext != nullptr)
+		eglDestroyContext(display, static_cast<EGLContext>(mContext));
+	if (mSurface != nullptr)
+		eglDestroySurface(display, static_cast<EGLSurface>(mSurface));
+	eglTerminate(display);
+#endif
+
+	mDisplay = nullptr;
+	mSurface = nullptr;
+	mContext = nullptr;
+}
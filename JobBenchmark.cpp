@@ -0,0 +1,102 @@
+#include "JobBenchmark.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+static const int kEmptyJobs = 200000;
+static const int kChainLength = 20000;
+static const size_t kLoopElements = 1 << 20;
+static const size_t kLoopGrainSize = 1024;
+static const int kRepeats = 5;
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedMilliseconds(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// spawn empty jobs from the main thread and wait for all of them, in ns per job
+static double emptyJobOverhead(JobSystem& jobs)
+{
+	double best = 1e30;
+	for (int repeat = 0; repeat < kRepeats; repeat++)
+	{
+		auto start = Clock::now();
+		JobCounter counter;
+		for (int i = 0; i < kEmptyJobs; i++)
+			jobs.run([] {}, &counter);
+		jobs.wait(counter);
+		best = std::min(best, elapsedMilliseconds(start));
+	}
+	return best * 1e6 / kEmptyJobs;
+}
+
+// jobs that each start the next one once they finish, in ns per link
+static double dependencyChainLatency(JobSystem& jobs)
+{
+	double best = 1e30;
+	for (int repeat = 0; repeat < kRepeats; repeat++)
+	{
+		std::vector<JobCounter> links(kChainLength);
+
+		auto start = Clock::now();
+		JobCounter done;
+		jobs.run([] {}, &links[0]);
+		for (int i = 1; i < kChainLength; i++)
+			jobs.runAfter(links[i - 1], [] {}, &links[i]);
+		jobs.runAfter(links[kChainLength - 1], [] {}, &done);
+		jobs.wait(done);
+		best = std::min(best, elapsedMilliseconds(start));
+	}
+	return best * 1e6 / kChainLength;
+}
+
+// compute bound loop over kLoopElements, in ms
+static double parallelLoopTime(JobSystem& jobs, std::vector<float>& data)
+{
+	double best = 1e30;
+	for (int repeat = 0; repeat < kRepeats; repeat++)
+	{
+		auto start = Clock::now();
+		jobs.parallelFor(data.size(), kLoopGrainSize, [&data](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				float x = static_cast<float>(i);
+				for (int step = 0; step < 16; step++)
+					x = std::sqrt(x * 0.5f + 1.0f) + std::sin(x);
+				data[i] = x;
+			}
+		});
+		best = std::min(best, elapsedMilliseconds(start));
+	}
+	return best;
+}
+
+void RunJobBenchmarks(std::ostream& out)
+{
+	unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<float> data(kLoopElements);
+
+	out << "job system benchmarks, best of " << kRepeats << " runs, " << hardwareThreads << " hardware threads" << std::endl;
+	out << "threads\tempty job (ns)\tchain link (ns)\tparallel for (ms)\tspeedup" << std::endl;
+
+	double singleThreadTime = 0.0;
+	for (unsigned threads = 1; threads <= hardwareThreads; threads++)
+	{
+		JobSystem jobs(static_cast<int>(threads) - 1);
+
+		double overhead = emptyJobOverhead(jobs);
+		double latency = dependencyChainLatency(jobs);
+		double loopTime = parallelLoopTime(jobs, data);
+		if (threads == 1)
+			singleThreadTime = loopTime;
+
+		out << threads << "\t" << overhead << "\t" << latency << "\t" << loopTime << "\t"
+			<< singleThreadTime / loopTime << "x" << std::endl;
+	}
+}
@@ -0,0 +1,284 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+
+namespace
+{
+	// deque of the thread currently running, valid for threads of tOwner only
+	thread_local const JobSystem* tOwner = nullptr;
+	thread_local int tQueueIndex = 0;
+}
+
+JobSystem::JobSystem(int numWorkers)
+	: mMainThread(std::this_thread::get_id()), mQueuedJobs(0), mSleepingWorkers(0), mJobCount(0), mStealCount(0)
+{
+	if (numWorkers < 0)
+	{
+		unsigned hardwareThreads = std::thread::hardware_concurrency();
+		numWorkers = hardwareThreads > 1 ? static_cast<int>(hardwareThreads) - 1 : 0;
+	}
+
+	// one deque per thread, the main thread's first
+	for (int i = 0; i <= numWorkers; i++)
+		mQueues.emplace_back(new JobQueue());
+
+	tOwner = this;
+	tQueueIndex = 0;
+
+	for (int i = 0; i < numWorkers; i++)
+		mThreads.emplace_back(&JobSystem::workerLoop, this, i + 1);
+}
+
+JobSystem::~JobSystem()
+{
+	// wake all workers and wait for them to exit
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mQuit = true;
+	}
+	mWakeCondition.notify_all();
+
+	for (size_t i = 0; i < mThreads.size(); i++)
+		mThreads[i].join();
+
+	if (tOwner == this)
+		tOwner = nullptr;
+}
+
+void JobSystem::run(const std::function<void()>& job, JobCounter* counter)
+{
+	if (counter)
+		counter->mCount.fetch_add(1, std::memory_order_relaxed);
+
+	Job queued;
+	queued.function = job;
+	queued.counter = counter;
+	push(std::move(queued));
+}
+
+void JobSystem::runAfter(JobCounter& dependency, const std::function<void()>& job, JobCounter* counter)
+{
+	if (counter)
+		counter->mCount.fetch_add(1, std::memory_order_relaxed);
+
+	// the last job of the dependency takes the continuations under the same lock,
+	// so the job is either queued here or picked up by finish()
+	{
+		std::lock_guard<std::mutex> lock(dependency.mMutex);
+		if (!dependency.isDone())
+		{
+			dependency.mContinuations.emplace_back(job, counter);
+			return;
+		}
+	}
+
+	Job queued;
+	queued.function = job;
+	queued.counter = counter;
+	push(std::move(queued));
+}
+
+void JobSystem::runOnMainThread(const std::function<void()>& job, JobCounter* counter)
+{
+	if (counter)
+		counter->mCount.fetch_add(1, std::memory_order_relaxed);
+
+	Job queued;
+	queued.function = job;
+	queued.counter = counter;
+
+	std::lock_guard<std::mutex> lock(mMainMutex);
+	mMainJobs.push_back(std::move(queued));
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+	bool mainThread = isMainThread();
+
+	// help instead of blocking, which also lets jobs wait on other jobs
+	while (!counter.isDone())
+	{
+		if (mainThread)
+			runMainThreadJobs();
+
+		if (!counter.isDone() && !runOneJob())
+			std::this_thread::yield();
+	}
+
+	// let the job that finished the counter leave it
+	std::lock_guard<std::mutex> lock(counter.mMutex);
+}
+
+void JobSystem::runMainThreadJobs()
+{
+	std::vector<Job> jobs;
+	{
+		std::lock_guard<std::mutex> lock(mMainMutex);
+		jobs.swap(mMainJobs);
+	}
+
+	for (size_t i = 0; i < jobs.size(); i++)
+		execute(jobs[i]);
+}
+
+void JobSystem::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& function)
+{
+	if (count == 0)
+		return;
+
+	if (grainSize == 0)
+		grainSize = 1;
+
+	// not worth spawning jobs for a single chunk
+	if (mThreads.empty() || count <= grainSize)
+	{
+		function(0, count);
+		return;
+	}
+
+	JobCounter counter;
+	splitRange(0, count, grainSize, function, counter);
+	wait(counter);
+}
+
+void JobSystem::resetCounters()
+{
+	mJobCount.store(0, std::memory_order_relaxed);
+	mStealCount.store(0, std::memory_order_relaxed);
+}
+
+int JobSystem::queueIndex() const
+{
+	return tOwner == this ? tQueueIndex : 0;
+}
+
+void JobSystem::push(Job&& job)
+{
+	JobQueue& queue = *mQueues[queueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+	}
+
+	// seq_cst pairs with the sleep check in workerLoop, so a worker either sees the job or gets woken
+	mQueuedJobs.fetch_add(1);
+	if (mSleepingWorkers.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mWakeCondition.notify_one();
+	}
+}
+
+bool JobSystem::takeJob(Job& job)
+{
+	int own = queueIndex();
+
+	// newest job of the own deque first
+	{
+		JobQueue& queue = *mQueues[own];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			return true;
+		}
+	}
+
+	// then the oldest job of another deque, starting at the next one to spread the thieves
+	int numQueues = static_cast<int>(mQueues.size());
+	for (int i = 1; i < numQueues; i++)
+	{
+		JobQueue& queue = *mQueues[(own + i) % numQueues];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			mStealCount.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool JobSystem::runOneJob()
+{
+	Job job;
+	if (!takeJob(job))
+		return false;
+
+	mQueuedJobs.fetch_sub(1);
+	execute(job);
+	return true;
+}
+
+void JobSystem::execute(Job& job)
+{
+	job.function();
+	mJobCount.fetch_add(1, std::memory_order_relaxed);
+
+	if (job.counter)
+		finish(*job.counter);
+}
+
+void JobSystem::finish(JobCounter& counter)
+{
+	// decrement under the lock: wait() takes it once the count is zero, so the counter
+	// is not destroyed while the last job still uses it
+	std::vector<std::pair<std::function<void()>, JobCounter*>> continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter.mMutex);
+		if (counter.mCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			continuations.swap(counter.mContinuations);
+	}
+
+	// the counter reached zero, release the jobs that waited for it
+
+	for (size_t i = 0; i < continuations.size(); i++)
+	{
+		Job queued;
+		queued.function = std::move(continuations[i].first);
+		queued.counter = continuations[i].second;
+		push(std::move(queued));
+	}
+}
+
+void JobSystem::splitRange(size_t begin, size_t end, size_t grainSize,
+	const std::function<void(size_t, size_t)>& function, JobCounter& counter)
+{
+	// hand the upper half to whoever steals it until the range is down to the grain size
+	while (end - begin > grainSize)
+	{
+		size_t middle = begin + (end - begin) / 2;
+		run([this, middle, end, grainSize, &function, &counter]
+		{
+			splitRange(middle, end, grainSize, function, counter);
+		}, &counter);
+		end = middle;
+	}
+
+	function(begin, end);
+}
+
+void JobSystem::workerLoop(int index)
+{
+	tOwner = this;
+	tQueueIndex = index;
+	Profiler::setThreadName("Worker " + std::to_string(index));
+
+	while (true)
+	{
+		if (runOneJob())
+			continue;
+
+		// sleep until jobs are queued
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mSleepingWorkers.fetch_add(1);
+		mWakeCondition.wait(lock, [this] { return mQuit || mQueuedJobs.load() > 0; });
+		mSleepingWorkers.fetch_sub(1);
+
+		if (mQuit)
+			return;
+	}
+}
@@ -0,0 +1,360 @@
+#include "LightClusters.h"
+#include "Culling.h"
+#include "GLState.h"
+#include "RenderStats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CLUSTERS_SSE
+#endif
+
+// texels (vec4) per light in the light buffer
+static const int kLightTexels = 5;
+// texture units of the light, grid and index buffers
+static const int kFirstTextureUnit = 2;
+// radius of lights that reach everything (directional or without falloff)
+static const float kInfiniteRadius = 1.0e30f;
+
+// distance beyond which a light contributes less than 1/256 of its intensity
+static float lightRadius(const Light& light)
+{
+	if (light.type == 2)
+		return kInfiniteRadius;
+
+	glm::vec3 intensity = glm::max(light.Ld, light.Ls);
+	float threshold = 256.0f * glm::max(intensity.x, glm::max(intensity.y, intensity.z));
+
+	// solve att.z * d^2 + att.y * d + att.x = threshold
+	float c = light.att.x - threshold;
+	if (c >= 0.0f)
+		return 0.0f;
+	if (light.att.z > 0.0f)
+		return (-light.att.y + sqrtf(light.att.y * light.att.y - 4.0f * light.att.z * c)) / (2.0f * light.att.z);
+	if (light.att.y > 0.0f)
+		return -c / light.att.y;
+	return kInfiniteRadius;
+}
+
+// tiles between the boundaries a sphere is not entirely beyond;
+// above = boundaries the sphere is entirely past, below = boundaries it is entirely before
+static void tileRange(int above, int below, int tiles, int16_t& first, int16_t& last)
+{
+	first = static_cast<int16_t>(above > 0 ? above - 1 : 0);
+	last = static_cast<int16_t>(glm::min(tiles - below, tiles - 1));
+}
+
+LightClusters::LightClusters()
+{}
+
+LightClusters::~LightClusters()
+{
+	if (mTextures[0] != 0)
+	{
+		glDeleteTextures(3, mTextures);
+		for (int i = 0; i < 3; i++)
+			GLState::textureDeleted(mTextures[i]);
+	}
+	if (mBuffers[0] != 0)
+		glDeleteBuffers(3, mBuffers);
+}
+
+void LightClusters::setLights(const Light* lights, size_t count)
+{
+	mLights = lights;
+	mLightCount = count;
+}
+
+void LightClusters::build(const ClusterView* views, int numViews)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	mNumViews = glm::min(numViews, kMaxViews);
+	packLights();
+
+	// cluster ranges of every light in every view
+	mRanges.resize(mNumViews * mActiveLights);
+	for (int v = 0; v < mNumViews; v++)
+		assignView(v, views[v], mRanges.data() + v * mActiveLights);
+
+	// count lights per cluster, nothing to do without lights
+	mIndices.clear();
+	mGrid.assign(mActiveLights > 0 ? mNumViews * kClusterCount * 2 : 0, 0);
+	for (int v = 0; v < mNumViews && mActiveLights > 0; v++)
+	{
+		GLuint* grid = mGrid.data() + v * kClusterCount * 2;
+		for (int l = 0; l < mActiveLights; l++)
+		{
+			const ClusterRange& range = mRanges[v * mActiveLights + l];
+			for (int z = range.minZ; z <= range.maxZ; z++)
+				for (int y = range.minY; y <= range.maxY; y++)
+					for (int x = range.minX; x <= range.maxX; x++)
+						grid[((z * kTilesY + y) * kTilesX + x) * 2 + 1]++;
+		}
+	}
+
+	// offsets from the counts, then fill the index list (count is rebuilt as the fill cursor)
+	GLuint offset = 0;
+	for (size_t c = 0; c < mGrid.size(); c += 2)
+	{
+		mGrid[c] = offset;
+		offset += mGrid[c + 1];
+		mGrid[c + 1] = 0;
+	}
+	mIndices.resize(offset);
+
+	for (int v = 0; v < mNumViews && mActiveLights > 0; v++)
+	{
+		GLuint* grid = mGrid.data() + v * kClusterCount * 2;
+		for (int l = 0; l < mActiveLights; l++)
+		{
+			const ClusterRange& range = mRanges[v * mActiveLights + l];
+			for (int z = range.minZ; z <= range.maxZ; z++)
+				for (int y = range.minY; y <= range.maxY; y++)
+					for (int x = range.minX; x <= range.maxX; x++)
+					{
+						GLuint* cluster = grid + ((z * kTilesY + y) * kTilesX + x) * 2;
+						mIndices[cluster[0] + cluster[1]++] = static_cast<GLuint>(l);
+					}
+		}
+	}
+
+	upload();
+
+	std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+	mBuildTime = elapsed.count();
+}
+
+void LightClusters::packLights()
+{
+	mLightX.clear();
+	mLightY.clear();
+	mLightZ.clear();
+	mLightRadius.clear();
+	mLightData.clear();
+
+	for (size_t i = 0; i < mLightCount; i++)
+	{
+		const Light& light = mLights[i];
+		if (light.type < 1 || light.type > 3)
+			continue;
+
+		float radius = lightRadius(light);
+		if (radius <= 0.0f)
+			continue;
+
+		// directional lights are not positioned, their sphere covers every cluster
+		glm::vec3 center = (light.type == 2) ? glm::vec3(0.0f) : light.pos;
+		mLightX.push_back(center.x);
+		mLightY.push_back(center.y);
+		mLightZ.push_back(center.z);
+		mLightRadius.push_back(radius);
+
+		glm::vec3 dir = glm::length(light.dir) > 0.0f ? glm::normalize(light.dir) : glm::vec3(0.0f, 0.0f, -1.0f);
+		mLightData.push_back(glm::vec4(light.pos, static_cast<float>(light.type)));
+		mLightData.push_back(glm::vec4(dir, cosf(glm::radians(light.innerAngle))));
+		mLightData.push_back(glm::vec4(light.Ld, cosf(glm::radians(light.outerAngle))));
+		mLightData.push_back(glm::vec4(light.Ls, radius));
+		mLightData.push_back(glm::vec4(light.att, 0.0f));
+	}
+
+	mActiveLights = static_cast<int>(mLightRadius.size());
+}
+
+void LightClusters::assignView(int view, const ClusterView& clusterView, ClusterRange* ranges)
+{
+	// rows of the (column major) matrix
+	const glm::mat4& m = clusterView.projViewMatrix;
+	glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	// tile boundary planes, positive distance = right of (above) the boundary
+	glm::vec4 planesX[kTilesX + 1];
+	glm::vec4 planesY[kTilesY + 1];
+	for (int i = 0; i <= kTilesX; i++)
+	{
+		glm::vec4 p = row0 - (-1.0f + 2.0f * i / kTilesX) * row3;
+		planesX[i] = p / glm::length(glm::vec3(p));
+	}
+	for (int i = 0; i <= kTilesY; i++)
+	{
+		glm::vec4 p = row1 - (-1.0f + 2.0f * i / kTilesY) * row3;
+		planesY[i] = p / glm::length(glm::vec3(p));
+	}
+
+	// distance along the view direction, and the near and far distances
+	Frustum frustum = extractFrustum(m);
+	glm::vec3 forward(frustum.planes[4]);
+	glm::vec4 depthPlane(forward, -glm::dot(forward, clusterView.viewpoint));
+	float nearDepth = -frustum.planes[4].w + depthPlane.w;
+	float farDepth = -frustum.planes[5].w * glm::dot(forward, glm::vec3(frustum.planes[5])) + depthPlane.w;
+
+	// logarithmic slices for perspective views keep clusters roughly cubic, linear for orthographic
+	bool perspective = glm::length(glm::vec3(row3)) > 0.0f;
+	float scale, bias;
+	if (perspective)
+	{
+		nearDepth = glm::max(nearDepth, 0.01f);
+		scale = kSlices / logf(farDepth / nearDepth);
+		bias = -logf(nearDepth) * scale;
+	}
+	else
+	{
+		scale = kSlices / (farDepth - nearDepth);
+		bias = -nearDepth * scale;
+	}
+
+	mViewports[view] = clusterView.viewport;
+	mDepthPlanes[view] = depthPlane;
+	mDepthParams[view] = glm::vec3(scale, bias, perspective ? 1.0f : 0.0f);
+
+	// boundaries each light is entirely past (above) or entirely before (below)
+	std::vector<int> aboveX(mActiveLights), belowX(mActiveLights);
+	std::vector<int> aboveY(mActiveLights), belowY(mActiveLights);
+
+	int i = 0;
+#if defined(CLUSTERS_SSE)
+	for (; i + 4 <= mActiveLights; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(&mLightX[i]);
+		__m128 y = _mm_loadu_ps(&mLightY[i]);
+		__m128 z = _mm_loadu_ps(&mLightZ[i]);
+		__m128 radius = _mm_loadu_ps(&mLightRadius[i]);
+		__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+		// compare masks are -1, so subtracting them counts
+		__m128i above = _mm_setzero_si128();
+		__m128i below = _mm_setzero_si128();
+		for (int p = 0; p <= kTilesX; p++)
+		{
+			const glm::vec4& plane = planesX[p];
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x), _mm_mul_ps(_mm_set1_ps(plane.y), y)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), z), _mm_set1_ps(plane.w)));
+			above = _mm_sub_epi32(above, _mm_castps_si128(_mm_cmpgt_ps(dist, radius)));
+			below = _mm_sub_epi32(below, _mm_castps_si128(_mm_cmplt_ps(dist, negRadius)));
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&aboveX[i]), above);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&belowX[i]), below);
+
+		above = _mm_setzero_si128();
+		below = _mm_setzero_si128();
+		for (int p = 0; p <= kTilesY; p++)
+		{
+			const glm::vec4& plane = planesY[p];
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x), _mm_mul_ps(_mm_set1_ps(plane.y), y)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), z), _mm_set1_ps(plane.w)));
+			above = _mm_sub_epi32(above, _mm_castps_si128(_mm_cmpgt_ps(dist, radius)));
+			below = _mm_sub_epi32(below, _mm_castps_si128(_mm_cmplt_ps(dist, negRadius)));
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&aboveY[i]), above);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&belowY[i]), below);
+	}
+#endif
+
+	// remaining lights
+	for (; i < mActiveLights; i++)
+	{
+		glm::vec3 center(mLightX[i], mLightY[i], mLightZ[i]);
+		float radius = mLightRadius[i];
+
+		aboveX[i] = belowX[i] = aboveY[i] = belowY[i] = 0;
+		for (int p = 0; p <= kTilesX; p++)
+		{
+			float dist = glm::dot(glm::vec3(planesX[p]), center) + planesX[p].w;
+			aboveX[i] += dist > radius;
+			belowX[i] += dist < -radius;
+		}
+		for (int p = 0; p <= kTilesY; p++)
+		{
+			float dist = glm::dot(glm::vec3(planesY[p]), center) + planesY[p].w;
+			aboveY[i] += dist > radius;
+			belowY[i] += dist < -radius;
+		}
+	}
+
+	// tile and slice ranges
+	for (i = 0; i < mActiveLights; i++)
+	{
+		ClusterRange& range = ranges[i];
+		tileRange(aboveX[i], belowX[i], kTilesX, range.minX, range.maxX);
+		tileRange(aboveY[i], belowY[i], kTilesY, range.minY, range.maxY);
+
+		float depth = glm::dot(forward, glm::vec3(mLightX[i], mLightY[i], mLightZ[i])) + depthPlane.w;
+		float radius = mLightRadius[i];
+		if (range.minY > range.maxY || depth + radius < nearDepth || depth - radius > farDepth)
+		{
+			range.minX = 1;
+			range.maxX = 0;
+			range.minY = range.maxY = range.minZ = range.maxZ = 0;
+			continue;
+		}
+
+		float minDepth = glm::max(depth - radius, nearDepth);
+		float maxDepth = glm::min(depth + radius, farDepth);
+		float minSlice = (perspective ? logf(minDepth) : minDepth) * scale + bias;
+		float maxSlice = (perspective ? logf(maxDepth) : maxDepth) * scale + bias;
+		range.minZ = static_cast<int16_t>(glm::clamp(static_cast<int>(floorf(minSlice)), 0, kSlices - 1));
+		range.maxZ = static_cast<int16_t>(glm::clamp(static_cast<int>(floorf(maxSlice)), 0, kSlices - 1));
+	}
+}
+
+void LightClusters::upload()
+{
+	if (mBuffers[0] == 0)
+	{
+		static const GLenum kFormats[3] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+
+		glGenBuffers(3, mBuffers);
+		glGenTextures(3, mTextures);
+		for (int i = 0; i < 3; i++)
+		{
+			glBindBuffer(GL_TEXTURE_BUFFER, mBuffers[i]);
+			glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+			GLState::bindTexture(GL_TEXTURE_BUFFER, mTextures[i]);
+			glTexBuffer(GL_TEXTURE_BUFFER, kFormats[i], mBuffers[i]);
+		}
+		GLState::bindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+
+	// shaders skip the buffers entirely without active lights
+	if (mActiveLights == 0)
+		return;
+
+	// respecify (orphan) every frame so the previous frame's data can still be read by the GPU
+	glBindBuffer(GL_TEXTURE_BUFFER, mBuffers[0]);
+	glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::vec4) * mLightData.size(), mLightData.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, mBuffers[1]);
+	glBufferData(GL_TEXTURE_BUFFER, sizeof(GLuint) * mGrid.size(), mGrid.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, mBuffers[2]);
+	glBufferData(GL_TEXTURE_BUFFER, sizeof(GLuint) * std::max(mIndices.size(), static_cast<size_t>(1)),
+		mIndices.empty() ? nullptr : mIndices.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	RenderStats::add(STAT_BUFFER_BYTES, sizeof(glm::vec4) * mLightData.size() + sizeof(GLuint) * (mGrid.size() + mIndices.size()));
+}
+
+void LightClusters::bind()
+{
+	for (int i = 0; i < 3; i++)
+		GLState::bindTexture(kFirstTextureUnit + i, GL_TEXTURE_BUFFER, mTextures[i]);
+}
+
+void LightClusters::setUniforms(ShaderProgram& program)
+{
+	program.setUniform("uClusterLightCount", mActiveLights);
+	program.setUniform("uClusterLights", kFirstTextureUnit);
+	program.setUniform("uClusterGrid", kFirstTextureUnit + 1);
+	program.setUniform("uClusterIndices", kFirstTextureUnit + 2);
+
+	// one upload per array, so no element names are built per bind
+	if (mNumViews > 0)
+	{
+		program.setUniform("uClusterViewports", mViewports, mNumViews);
+		program.setUniform("uClusterDepthPlanes", mDepthPlanes, mNumViews);
+		program.setUniform("uClusterDepthParams", mDepthParams, mNumViews);
+	}
+}
@@ -1,799 +1,2012 @@
-#include "utilities.h"
-#include "Texture.h"
-#include "Camera.h"
-#include "SimpleModel.h"
-
-// MARK: - Global Varibales
-
-// Global variables for window dimensions
-unsigned int gWindowWidth = 800;
-unsigned int gWindowHeight = 600;
-
-// Shader programs
-ShaderProgram gShader;
-ShaderProgram gLightShader;
-ShaderProgram gNormalMapShader;
-
-// Frame rate settings
-float gFrameRate = 120.0f;
-float gFrameTime = 1 / gFrameRate; // Frame time calculated based on frame rate
-
-// Rotation settings
-const float rotationSpeed = 20.0f; // Speed of rotation
-float gRotation = 0.0f;            // Current rotation angle
-bool rotationEnabled = true;       // Flag to control rotation
-
-// Point light settings
-Light gPointLight;  // Point light properties
-
-// Models
-SimpleModel torusModel;           // Torus model
-SimpleModel floorModel;           // Floor model
-SimpleModel viewportBorderModel;  // Viewport border model
-SimpleModel wallModel;            // Wall model
-SimpleModel paintingModel;        // Painting model
-
-// Camera settings
-float gYaw = 0.0;         // Yaw angle for camera orientation
-float gPitch = 0.0;       // Pitch angle for camera orientation
-float CameraZoom = 15.0f; // Zoom level for camera
-
-// Viewport data structure to manage multiple viewports
-struct ViewportData
-{
-    int x = 0;
-    int y = 0;
-    int width = 0;
-    int height = 0;
-    Camera cam; // Camera associated with the viewports
-
-    ViewportData() {}
-
-    // Constructor to initialize viewport data with specific dimensions
-    ViewportData(int x, int y, int width, int height) : x(x), y(y), width(width), height(height) {}
-};
-
-std::vector<ViewportData> ViewportNumber; // Vector to store viewport data
-
-
-
-
-// MARK: - Setup functions
-// These functions initialize the geometry, materials, and textures for each respective model (for viewport border, floor, walls, and painting models)
-    
-void SetupViewportBorder() {
-    auto mesh = viewportBorderModel.GetMesh();
-    mesh->hasTexCoords = false;
-    mesh->numOfIndices = 0;
-    mesh->numOfVertices = 4;
-
-    viewportBorderModel.mIsValid = true;
-
-    std::vector<GLfloat> borderVertices = {
-        -1.0f, 0.0f, 0.0f, // Vertex 1
-         1.0f, 1.0f, 1.0f, // Color 1
-         1.0f, 0.0f, 0.0f, // Vertex 2
-         1.0f, 1.0f, 1.0f, // Color 2
-         0.0f, 1.0f, 0.0f, // Vertex 3
-         1.0f, 1.0f, 1.0f, // Color 3
-         0.0f, -1.0f, 0.0f,// Vertex 4
-         1.0f, 1.0f, 1.0f  // Color 4
-    };
-
-    // Generate and bind VAO
-    glGenVertexArrays(1, &mesh->VAO);
-    glBindVertexArray(mesh->VAO);
-
-    // Generate, bind, and fill VBO
-    glGenBuffers(1, &mesh->VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * borderVertices.size(), borderVertices.data(), GL_STATIC_DRAW);
-
-    // Define vertex attributes layout
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-
-    // Enable vertex attributes
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-
-    // Unbind VAO
-    glBindVertexArray(0);
-}
-
-
-
-
-void SetupFloor() {
-    Mesh* mesh =  floorModel.GetMesh();
-
-    // Configure mesh properties
-    mesh->hasTexCoords = false;
-    mesh->numOfIndices = 0;
-    mesh->numOfVertices = 4;
-    floorModel.mIsValid = true; 
-
-    // Set material properties
-    mesh->material.Ka = glm::vec3(0.25f, 0.21f, 0.21f);
-    mesh->material.Kd = glm::vec3(1.0f, 0.83f, 0.83f);
-    mesh->material.Ks = glm::vec3(0.3f, 0.3f, 0.3f);
-    mesh->material.shininess = 11.3f;
-
-    // Load texture
-    mesh->texture.generate("./images/check.bmp");
-
-    // Define floor vertices
-    std::vector<GLfloat> vertices = {
-        -1.0f, 0.0f, 1.0f,   0.0f, 1.0f, 0.0f,   0.0f, 0.0f,
-         1.0f, 0.0f, 1.0f,   0.0f, 1.0f, 0.0f,   5.0f, 0.0f,
-        -1.0f, 0.0f, -1.0f,  0.0f, 1.0f, 0.0f,   0.0f, 5.0f,
-         1.0f, 0.0f, -1.0f,  0.0f, 1.0f, 0.0f,   5.0f, 5.0f,
-    };
-
-    // Setup Vertex Buffer Object (VBO )
-    glGenBuffers(1, &mesh->VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
-    // Setup VAO (Vertex Array Object) and configure it
-    glGenVertexArrays(1, &mesh->VAO);
-    glBindVertexArray(mesh->VAO);
-
-    // Set up vertex attributes
-    auto setupVertexAttrib = [&](GLuint index, GLint size, GLenum type, GLsizei stride, size_t offset) {
-        glVertexAttribPointer(index, size, type, GL_FALSE, stride, reinterpret_cast<void*>(offset));
-        glEnableVertexAttribArray(index);
-    };
-
-    GLsizei stride = sizeof(VertexNormTex);
-    setupVertexAttrib(0, 3, GL_FLOAT, stride, offsetof(VertexNormTex, position));
-    setupVertexAttrib(1, 3, GL_FLOAT, stride, offsetof(VertexNormTex, normal));
-    setupVertexAttrib(2, 2, GL_FLOAT, stride, offsetof(VertexNormTex, texCoord));
-
-    glBindVertexArray(0); // Unbind VAO
-}
-
-
-
-
-void SetupWalls() {
-    Mesh* mesh = wallModel.GetMesh();
-
-    // Set mesh properties
-    mesh->hasTexCoords = false;
-    mesh->numOfIndices = 0;
-    mesh->numOfVertices = 4;
-    wallModel.mIsValid = true; // Validate wall model
-
-    // Texture loading
-    mesh->texture.generate("./images/Fieldstone.bmp");
-    mesh->normalTexture.generate("./images/FieldstoneBumpDOT3.bmp");
-
-    // Material configuration
-    mesh->material.Ka = glm::vec3(0.2f);
-    mesh->material.Kd = glm::vec3(0.2f, 0.7f, 1.0f);
-    mesh->material.Ks = glm::vec3(0.2f, 0.7f, 1.0f);
-    mesh->material.shininess = 40.0f;
-
-    // Define vertices with position, normal, tangent, and texture coordinates
-    std::vector<GLfloat> vertices = {
-        -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
-         1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 2.0f, 0.0f,
-        -1.0f,  1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 2.0f,
-         1.0f,  1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 2.0f, 2.0f,
-    };
-
-    // Setup Vertex Buffer Object (VBO )
-    glGenBuffers(1, &mesh->VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
-
-    // Setup VAO (Vertex Array Object) and configure it
-    glGenVertexArrays(1, &mesh->VAO);
-    glBindVertexArray(mesh->VAO);
-
-    auto setVertexAttribute = [&](GLuint index, GLint size, GLenum type, bool normalized, GLsizei stride, std::size_t offset) {
-        glVertexAttribPointer(index, size, type, normalized, stride, reinterpret_cast<void*>(offset));
-        glEnableVertexAttribArray(index);
-    };
-
-    GLsizei stride = sizeof(VertexNormTanTex); // Assuming a struct named VertexNormTanTex defines the stride
-    setVertexAttribute(0, 3, GL_FLOAT, GL_FALSE, stride, offsetof(VertexNormTanTex, position));
-    setVertexAttribute(1, 3, GL_FLOAT, GL_FALSE, stride, offsetof(VertexNormTanTex, normal));
-    setVertexAttribute(2, 3, GL_FLOAT, GL_FALSE, stride, offsetof(VertexNormTanTex, tangent));
-    setVertexAttribute(3, 2, GL_FLOAT, GL_FALSE, stride, offsetof(VertexNormTanTex, texCoord));
-
-    glBindVertexArray(0); // Unbind VAO
-}
-
-
-
-
-void SetupPainting() {
-    Mesh* mesh = paintingModel.GetMesh();
-
-    // Initialize mesh properties
-    mesh->hasTexCoords = false;
-    mesh->numOfIndices = 0;
-    mesh->numOfVertices = 4;
-    paintingModel.mIsValid = true; // Mark the painting model as valid
-
-    // Set material properties
-    mesh->material.Ka = glm::vec3(0.25f, 0.21f, 0.21f);
-    mesh->material.Kd = glm::vec3(1.0f, 0.83f, 0.83f);
-    mesh->material.Ks = glm::vec3(0.3f, 0.3f, 0.3f);
-    mesh->material.shininess = 11.3f;
-
-    // Generate texture
-    mesh->texture.generate("./images/painting.png");
-
-    // Define vertices for the painting
-    std::vector<GLfloat> vertices = {
-        -1.0f, 0.0f,  1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f,
-         1.0f, 0.0f,  1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f,
-        -1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,
-         1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f,
-    };
-
-    // Setup Vertex Buffer Object (VBO )
-    glGenBuffers(1, &mesh->VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices[0]) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
-
-    // Setup VAO (Vertex Array Object) and configure it
-    glGenVertexArrays(1, &mesh->VAO);
-    glBindVertexArray(mesh->VAO);
-
-    // Simplify attribute setup with a lambda function
-    auto setupVertexAttrib = [&](GLuint index, GLint size, GLenum type, GLsizei stride, size_t offset) {
-        glVertexAttribPointer(index, size, type, GL_FALSE, stride, reinterpret_cast<void*>(offset));
-        glEnableVertexAttribArray(index);
-    };
-
-    GLsizei stride = sizeof(VertexNormTex); // Assuming VertexNormTex structure defines the layout
-    setupVertexAttrib(0, 3, GL_FLOAT, stride, offsetof(VertexNormTex, position));
-    setupVertexAttrib(1, 3, GL_FLOAT, stride, offsetof(VertexNormTex, normal));
-    setupVertexAttrib(2, 2, GL_FLOAT, stride, offsetof(VertexNormTex, texCoord));
-
-    glBindVertexArray(0); // Unbind VAOs
-}
-
-
-
-
-// MARK: - Initialization function
-void init(GLFWwindow* window) {
-    // Get the size of the framebuffer
-    int framebufferWidth, framebufferHeight;
-    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
-
-    // Update global window size variables based on the framebuffer size
-    gWindowWidth = framebufferWidth;
-    gWindowHeight = framebufferHeight;
-
-    //Add andi Initialize viewport data based on the framebuffer size
-    ViewportNumber.emplace_back(0, framebufferHeight / 2, framebufferWidth / 2, framebufferHeight / 2);
-    ViewportNumber.emplace_back(framebufferWidth / 2, framebufferHeight / 2, framebufferWidth / 2, framebufferHeight / 2);
-    ViewportNumber.emplace_back(0, 0, framebufferWidth / 2, framebufferHeight / 2);
-    ViewportNumber.emplace_back(framebufferWidth / 2, 0, framebufferWidth / 2, framebufferHeight / 2);
-    
-    // Update projection matrices for each viewport
-    float aspectRatio = static_cast<float>(framebufferWidth) / static_cast<float>(framebufferHeight);
-    float scale1 = tanf(glm::radians(60.0f) / 2.0f) * CameraZoom;
-    float scale2 = tanf(glm::radians(60.0f) / 2.0f) * 12.0f;
-
-    // Projection matrix for viewport 1
-    glm::mat4 projMat = glm::ortho(-scale1 * aspectRatio, scale1 * aspectRatio, -scale1, scale1, 0.01f, 100.0f);
-    ViewportNumber[1].cam.setProjMatrix(projMat);
-    ViewportNumber[1].cam.setViewMatrix(glm::vec3(0.0f, CameraZoom, 0.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0, 0.0, -1.0));
-
-    // Projection matrix for viewport 2
-    projMat = glm::ortho(-scale2 * aspectRatio, scale2 * aspectRatio, -scale2, scale2, 0.01f, 100.0f);
-    ViewportNumber[2].cam.setProjMatrix(projMat);
-    ViewportNumber[2].cam.setViewMatrix(glm::vec3(0.0f, 0.0f, 8.0f), glm::vec3(0.0f, 0.0f, 0.0f));
-
-    // Projection matrix for viewport 3
-    projMat = glm::perspective(glm::radians(70.0f), aspectRatio, 0.1f, 100.0f);
-    ViewportNumber[3].cam.setProjMatrix(projMat);
-    ViewportNumber[3].cam.setViewMatrix(glm::vec3(0.0f, 0.0f, 7.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0, 1.0, 0.0));
-
-    // Initialize shaders
-    gShader.compileAndLink("SimpleTransform.vert", "color.frag");
-    gLightShader.compileAndLink("lightingAndTexture.vert", "pointLightTexture.frag");
-    gNormalMapShader.compileAndLink("normalMap.vert", "normalMap.frag");
-
-    SetupViewportBorder();
-    SetupFloor();
-    SetupWalls();
-    SetupPainting();
-    
-    /// Create Torus Model
-    // Set material properties for the Torus Model
-    torusModel.GetMesh()->material.Ka = glm::vec3(0.6f, 0.6f, 0.6f);  // Ambient color
-    torusModel.GetMesh()->material.Kd = glm::vec3(1.0f, 1.0f, 1.0f);  // Diffuse color
-    torusModel.GetMesh()->material.Ks = glm::vec3(0.8f, 0.8f, 0.8f);  // Specular color
-    torusModel.GetMesh()->material.shininess = 40.0f;  // Shininess
-
-    // Generate texture for the Torus Model
-    torusModel.GetMesh()->texture.generate(
-        "./images/cm_front.bmp", "./images/cm_back.bmp",
-        "./images/cm_left.bmp", "./images/cm_right.bmp",
-        "./images/cm_top.bmp", "./images/cm_bottom.bmp");
-
-    // Load model data for the Torus Model
-    torusModel.loadModel("./models/torus.obj");
-
-    // Initialize model matrix for the Torus Model
-    auto& torusModelMatrix = torusModel.GetMesh()->modelMatrix;
-    torusModelMatrix = glm::mat4(1.0f);  // Identity matrix
-    torusModelMatrix = glm::translate(torusModelMatrix, glm::vec3(0.0, -1.0, 0.0));  // Translate
-    torusModelMatrix = glm::rotate(torusModelMatrix, glm::radians(90.0f), glm::vec3(1.0, 0, 0));  // Rotate
-    torusModelMatrix = glm::scale(torusModelMatrix, glm::vec3(2.0));  // Scale
-
-    /// Setup light
-    gPointLight.pos = glm::vec3(3.0f, 3.0f, 0.0f);
-    gPointLight.La = glm::vec3(1.0f, 0.9f, 0.3f);
-    gPointLight.Ld = glm::vec3(0.8f);
-    gPointLight.Ls = glm::vec3(0.8f);
-    gPointLight.att = glm::vec3(1.0f, 0.0f, 0.0f);
-
-    // Set OpenGL state
-    glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
-    glEnable(GL_DEPTH_TEST);
-}
-
-
-
-
-// MARK: - Scene Rendering Function
-static void RenderScene(ViewportData &viewportData)
-{
-    // Calculate the projection-view matrix
-    glm::mat4 projViewMatrix = viewportData.cam.getProjMatrix() * viewportData.cam.getViewMatrix();
-
-    // Use the light shader for rendering
-    gLightShader.use();
-
-    // Set light properties
-    gLightShader.setUniform("uLight.pos", gPointLight.pos);
-    gLightShader.setUniform("uLight.La", gPointLight.La);
-    gLightShader.setUniform("uLight.Ld", gPointLight.Ld);
-    gLightShader.setUniform("uLight.Ls", gPointLight.Ls);
-    gLightShader.setUniform("uLight.att", gPointLight.att);
-    gLightShader.setUniform("uViewpoint", viewportData.cam.getPosition());
-
-    // Set material properties for the floor
-    auto& floorMaterial = floorModel.GetMesh()->material;
-    gLightShader.setUniform("uMaterial.Ka", floorMaterial.Ka);
-    gLightShader.setUniform("uMaterial.Kd", floorMaterial.Kd);
-    gLightShader.setUniform("uMaterial.Ks", floorMaterial.Ks);
-    gLightShader.setUniform("uMaterial.shininess", floorMaterial.shininess);
-
-    // Set model matrix for the floor
-    glm::mat4 modelMatrix(1.0f);
-    modelMatrix = glm::translate(modelMatrix, glm::vec3(0.0f, -4.0, 0.0));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(8.0, 1.0, 8.0));
-
-    // Calculate MVP matrix and normal matrix for the floor
-    glm::mat4 MVP = projViewMatrix * modelMatrix;
-    glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(modelMatrix)));
-
-    // Set uniform variables for the floor
-    gLightShader.setUniform("uMVPMatrix", MVP);
-    gLightShader.setUniform("uModelMatrix", modelMatrix);
-    gLightShader.setUniform("uNormalMatrix", normalMatrix);
-    gLightShader.setUniform("uTextureSampler", 0);
-    gLightShader.setUniform("uEnvironmentMap", 1);
-    gLightShader.setUniform("hasEnvMap", 0);
-
-    // Bind textures and draw the floor model
-    glActiveTexture(GL_TEXTURE0);
-    floorModel.GetMesh()->texture.bind();
-    floorModel.drawModel(GL_TRIANGLE_STRIP);
-
-    // Set material properties for the painting
-    auto& paintingMaterial = paintingModel.GetMesh()->material;
-    gLightShader.setUniform("uMaterial.Ka", paintingMaterial.Ka);
-    gLightShader.setUniform("uMaterial.Kd", paintingMaterial.Kd);
-    gLightShader.setUniform("uMaterial.Ks", paintingMaterial.Ks);
-    gLightShader.setUniform("uMaterial.shininess", paintingMaterial.shininess);
-
-    // Set model matrix for the painting
-    modelMatrix = glm::mat4(1.0f);
-    modelMatrix = glm::translate(modelMatrix, glm::vec3(0.0f, 0.0f, -3.9f));
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(3.0f, 1.0f, 2.0f));
-
-    // Calculate MVP matrix and normal matrix for the painting
-    MVP = projViewMatrix * modelMatrix;
-    normalMatrix = glm::mat3(glm::transpose(glm::inverse(modelMatrix)));
-
-    // Set uniform variables for the painting
-    gLightShader.setUniform("uMVPMatrix", MVP);
-    gLightShader.setUniform("uModelMatrix", modelMatrix);
-    gLightShader.setUniform("uNormalMatrix", normalMatrix);
-
-    // Bind textures and draw the painting model
-    glActiveTexture(GL_TEXTURE0);
-    paintingModel.GetMesh()->texture.bind();
-    paintingModel.drawModel(GL_TRIANGLE_STRIP);
-
-    // Set material properties for the torus
-    auto& torusMaterial = torusModel.GetMesh()->material;
-    gLightShader.setUniform("uMaterial.Ka", torusMaterial.Ka);
-    gLightShader.setUniform("uMaterial.Kd", torusMaterial.Kd);
-    gLightShader.setUniform("uMaterial.Ks", torusMaterial.Ks);
-    gLightShader.setUniform("uMaterial.shininess", torusMaterial.shininess);
-
-    // Set model matrix for the torus
-    auto torusModelMatrix = torusModel.GetMesh()->modelMatrix;
-
-    // Calculate MVP matrix and normal matrix for the torus
-    MVP = projViewMatrix * torusModelMatrix;
-    normalMatrix = glm::mat3(glm::transpose(glm::inverse(torusModelMatrix)));
-
-    // Set uniform variables for the torus
-    gLightShader.setUniform("uMVPMatrix", MVP);
-    gLightShader.setUniform("uModelMatrix", torusModelMatrix);
-    gLightShader.setUniform("uNormalMatrix", normalMatrix);
-    gLightShader.setUniform("uEnvironmentMap", 0);
-    gLightShader.setUniform("uTextureSampler", 1);
-    gLightShader.setUniform("hasEnvMap", 1);
-
-    // Bind textures and draw the torus model
-    glActiveTexture(GL_TEXTURE0);
-    torusModel.GetMesh()->texture.bind();
-    torusModel.drawModel();
-
-    // Use the normal map shader for rendering
-    gNormalMapShader.use();
-
-    // Set light properties for the normal map shader
-    gNormalMapShader.setUniform("uLight.pos", gPointLight.pos);
-    gNormalMapShader.setUniform("uLight.La", gPointLight.La);
-    gNormalMapShader.setUniform("uLight.Ld", gPointLight.Ld);
-    gNormalMapShader.setUniform("uLight.Ls", gPointLight.Ls);
-    gNormalMapShader.setUniform("uLight.att", gPointLight.att);
-    gNormalMapShader.setUniform("uViewpoint", viewportData.cam.getPosition());
-
-    // Set material properties for the wall
-    auto& wallMaterial = wallModel.GetMesh()->material;
-    gNormalMapShader.setUniform("uMaterial.Ka", wallMaterial.Ka);
-    gNormalMapShader.setUniform("uMaterial.Kd", wallMaterial.Kd);
-    gNormalMapShader.setUniform("uMaterial.Ks", wallMaterial.Ks);
-    gNormalMapShader.setUniform("uMaterial.shininess", wallMaterial.shininess);
-    gNormalMapShader.setUniform("uTextureSampler", 0);
-    gNormalMapShader.setUniform("uNormalSampler", 1);
-
-    // Bind textures for the wall model
-    glActiveTexture(GL_TEXTURE0);
-    wallModel.GetMesh()->texture.bind();
-    glActiveTexture(GL_TEXTURE1);
-    wallModel.GetMesh()->normalTexture.bind();
-
-    // Render the back wall
-    modelMatrix = glm::mat4(1.0f);
-    modelMatrix = glm::translate(modelMatrix, glm::vec3(0.0, 0.0, -4.0));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(8.0, 4.0, 1.0));
-    MVP = projViewMatrix * modelMatrix;
-    normalMatrix = glm::mat3(glm::transpose(glm::inverse(modelMatrix)));
-    gNormalMapShader.setUniform("uMVPMatrix", MVP);
-    gNormalMapShader.setUniform("uModelMatrix", modelMatrix);
-    gNormalMapShader.setUniform("uNormalMatrix", normalMatrix);
-    wallModel.drawModel(GL_TRIANGLE_STRIP);
-
-    // Render the left wall
-    modelMatrix = glm::mat4(1.0f);
-    modelMatrix = glm::translate(modelMatrix, glm::vec3(-8.0f, 0.0, 0.0));
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(90.0f), glm::vec3(0, 1.0, 0));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(8.0, 4.0, 1.0));
-    MVP = projViewMatrix * modelMatrix;
-    normalMatrix = glm::mat3(glm::transpose(glm::inverse(modelMatrix)));
-    gNormalMapShader.setUniform("uMVPMatrix", MVP);
-    gNormalMapShader.setUniform("uModelMatrix", modelMatrix);
-    gNormalMapShader.setUniform("uNormalMatrix", normalMatrix);
-    wallModel.drawModel(GL_TRIANGLE_STRIP);
-
-    // Render the right wall
-    modelMatrix = glm::mat4(1.0f);
-    modelMatrix = glm::translate(modelMatrix, glm::vec3(8.0f, 0.0, 0.0));
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(-90.0f), glm::vec3(0, 1.0, 0));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(8.0, 4.0, 1.0));
-    MVP = projViewMatrix * modelMatrix;
-    normalMatrix = glm::mat3(glm::transpose(glm::inverse(modelMatrix)));
-    gNormalMapShader.setUniform("uMVPMatrix", MVP);
-    gNormalMapShader.setUniform("uModelMatrix", modelMatrix);
-    gNormalMapShader.setUniform("uNormalMatrix", normalMatrix);
-    wallModel.drawModel(GL_TRIANGLE_STRIP);
-
-    // Render the front wall
-    modelMatrix = glm::mat4(1.0f);
-    modelMatrix = glm::translate(modelMatrix, glm::vec3(0.0, 0.0, 8.0));
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(180.0f), glm::vec3(0, 1.0, 0));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(8.0, 4.0, 1.0));
-    MVP = projViewMatrix * modelMatrix;
-    normalMatrix = glm::mat3(glm::transpose(glm::inverse(modelMatrix)));
-    gNormalMapShader.setUniform("uMVPMatrix", MVP);
-    gNormalMapShader.setUniform("uModelMatrix", modelMatrix);
-    gNormalMapShader.setUniform("uNormalMatrix", normalMatrix);
-    wallModel.drawModel(GL_TRIANGLE_STRIP);
-}
-
-
-
-
-// MARK: - Scene Update Function
-static void UpdateScene(GLFWwindow* window)
-{
-    // Calculate time elapsed since last frame
-    static float lastFrameTime = 0.0f;
-    float currentFrameTime = glfwGetTime();
-    gFrameTime = currentFrameTime - lastFrameTime;
-    lastFrameTime = currentFrameTime;
-
-    if (rotationEnabled)
-    {
-        gRotation += rotationSpeed * gFrameTime;
-        if (gRotation >= 360.0f)
-            gRotation = 0.0f;
-
-        // Update torus model matrix
-        auto& torusModelMatrix = torusModel.GetMesh()->modelMatrix;
-        torusModelMatrix = glm::mat4(1.0f); // Identity matrix initialization
-        torusModelMatrix = glm::translate(torusModelMatrix, glm::vec3(0.0, -1.0, 0.0));
-        torusModelMatrix = glm::rotate(torusModelMatrix, glm::radians(gRotation * 5), glm::vec3(0.0f, 1.0f, 0.0f));
-        torusModelMatrix = glm::rotate(torusModelMatrix, glm::radians(90.0f), glm::vec3(1.0, 0, 0));
-        torusModelMatrix = glm::scale(torusModelMatrix, glm::vec3(2.0));
-    }
-
-    // Update camera yaw and pitch
-    ViewportNumber[3].cam.mYaw = gYaw;
-    ViewportNumber[3].cam.mPitch = gPitch;
-
-    // Update camera
-    ViewportNumber[3].cam.update(0.0f, 0.0f);
-}
-
-
-
-
-// MARK: - Rendering ViewPorts based on index
-void RenderViewports(int viewportIndex) {
-    auto& viewportData = ViewportNumber[viewportIndex];
-    
-    glViewport(viewportData.x, viewportData.y, viewportData.width, viewportData.height);
-
-    if (viewportIndex == 0) {
-        // Render GUI for viewport 0
-        TwDraw();
-    } else {
-        // Render scene for viewports 1, 2, and 3
-        RenderScene(viewportData);
-    }
-}
-
-
-
-
-// MARK: - Main Viewport Rendering
-void Render() {
-    // Clear colour buffer and depth buffer
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    // Render 4 viewports
-    for (int i = 0; i < 4; ++i) {
-        RenderViewports(i);
-    }
-
-    // Render the main viewport border
-    glViewport(0, 0, gWindowWidth, gWindowHeight); // Set the viewport to cover the entire window
-    gShader.use(); // Use the shader for rendering
-    glm::mat4 MVP(1.0f); // Identity matrix for MVP (no transformation)
-    gShader.setUniform("uMVPMatrix", MVP); // Set the MVP matrix uniform
-    viewportBorderModel.drawModel(GL_LINES); // Draw the viewport border model as lines
-
-    glFlush();
-}
-
-
-
-
-static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
-{
-	// close the window when the ESCAPE key is pressed
-	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
-	{
-		// set flag to close the window
-		glfwSetWindowShouldClose(window, GL_TRUE);
-		return;
-	}
-}
-
-
-
-
-static void cursor_position_callback(GLFWwindow* window, double xpos, double ypos)
-{
-	// pass cursor position to tweak bar
-	TwEventMousePosGLFW(static_cast<int>(xpos), static_cast<int>(ypos));
-}
-
-
-
-
-static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
-{
-	// pass mouse button status to tweak bar
-	TwEventMouseButtonGLFW(button, action);
-}
-
-
-
-
-static void error_callback(int error, const char* description)
-{
-	std::cerr << description << std::endl;	// output error description
-}
-
-
-
-
-// MARK: - Window Size Manager
-static void macOS_HiDPI_WindowManager(GLFWwindow* window, int w, int h) {
-    // Get the size of the framebuffer to handle high-DPI displays.
-    int framebufferWidth, framebufferHeight;
-    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
-
-    // Update global variables to reflect the framebuffer size.
-    gWindowWidth = framebufferWidth;
-    gWindowHeight = framebufferHeight;
-
-    // Update Viewport dimensions
-    ViewportNumber[0] = ViewportData(0, gWindowHeight / 2, gWindowWidth / 2, gWindowHeight / 2);
-    ViewportNumber[1] = ViewportData(gWindowWidth / 2, gWindowHeight / 2, gWindowWidth / 2, gWindowHeight / 2);
-    ViewportNumber[2] = ViewportData(0, 0, gWindowWidth / 2, gWindowHeight / 2);
-    ViewportNumber[3] = ViewportData(gWindowWidth / 2, 0, gWindowWidth / 2, gWindowHeight / 2);
-
-    // Recalculate scale for the orthographic projection based on the new window size
-    float scale1 = tanf(glm::radians(60.0f) / 2.0f) * CameraZoom ;
-    float scale2 = tanf(glm::radians(60.0f) / 2.0f) * 12.0f;
-    
-    float aspectRatio = static_cast<float>(framebufferWidth) / static_cast<float>(framebufferHeight);
-    float scaleWidth1 = scale1 * aspectRatio;
-    float scaleWidth2 = scale2 * aspectRatio;
-
-    glm::mat4 projMat = glm::ortho(-scaleWidth1, scaleWidth1, -scale1, scale1, 0.01f, 100.0f);
-    ViewportNumber[1].cam.setProjMatrix(projMat);
-    ViewportNumber[1].cam.setViewMatrix(glm::vec3(0.0f, CameraZoom , 0.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0, 0.0, -1.0));
-   
-    projMat = glm::ortho(-scaleWidth2, scaleWidth2, -scale2, scale2, 0.01f, 100.0f);
-    ViewportNumber[2].cam.setProjMatrix(projMat);
-    ViewportNumber[2].cam.setViewMatrix(glm::vec3(0.0f, 0.0f, 8.0f), glm::vec3(0.0f, 0.0f, 0.0f));
-   
-    projMat = glm::perspective(glm::radians(70.0f), aspectRatio, 0.1f, 100.0f);
-    ViewportNumber[3].cam.setProjMatrix(projMat);
-    ViewportNumber[3].cam.setViewMatrix(glm::vec3(0.0f, 0.0f, 7.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0, 1.0, 0.0));
-
-    // Update GUI size
-    TwWindowSize(gWindowWidth, gWindowHeight);
-}
-
-
-
-
-// MARK: - GUI Interface
-TwBar* CreateUI(const std::string name)
-{
-	TwBar* twBar = TwNewBar(name.c_str());
-
-	TwWindowSize(gWindowWidth / 2, gWindowHeight);
-	TwDefine(" TW_HELP visible=false ");
-	TwDefine(" GLOBAL fontsize=3 ");
-
-	TwDefine(" Main label='Controls' refresh=0.02 text=light size='250 250' ");
-
-	TwAddVarRO(twBar, "FPS", TW_TYPE_FLOAT, &gFrameRate, " group='Frame Statistics' precision=2 ");
-	TwAddVarRO(twBar, "Frame Time", TW_TYPE_FLOAT, &gFrameTime, " group='Frame Statistics' ");
-
-	TwAddVarRW(twBar, "Toggle", TW_TYPE_BOOLCPP, &rotationEnabled, " group='Animation' ");
-
-	TwAddVarRW(twBar, "Position X", TW_TYPE_FLOAT, &gPointLight.pos.x, " group='Light' step=0.01 ");
-	TwAddVarRW(twBar, "Position Y", TW_TYPE_FLOAT, &gPointLight.pos.y, " group='Light' step=0.01 ");
-	TwAddVarRW(twBar, "Position Z", TW_TYPE_FLOAT, &gPointLight.pos.z, " group='Light' step=0.01");
-
-	TwAddVarRW(twBar, "Yaw", TW_TYPE_FLOAT, &gYaw, " group='Camera' step=0.01");
-	TwAddVarRW(twBar, "Pitch", TW_TYPE_FLOAT, &gPitch, " group='Camera' step=0.01");
-
-	return twBar;
-}
-
-
-
-
-// MARK: - Main function
-int main(void)
-{
-    GLFWwindow* window = nullptr;
-
-    glfwSetErrorCallback(error_callback);
-
-    if (!glfwInit())
-    {
-        exit(EXIT_FAILURE);
-    }
-
-    // minimum OpenGL version 3.3
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    window = glfwCreateWindow(gWindowWidth, gWindowHeight, "Assignment 2 - abah609, 7571562", nullptr, nullptr);
-
-    if (window == nullptr)
-    {
-        glfwTerminate();
-        exit(EXIT_FAILURE);
-    }
-
-    glfwMakeContextCurrent(window);
-    int framebufferWidth, framebufferHeight;
-    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
-    glViewport(0, 0, framebufferWidth, framebufferHeight);
-
-    glfwSwapInterval(1);
-
-    if (glewInit() != GLEW_OK)
-    {
-        std::cerr << "GLEW initialisation failed" << std::endl;
-        exit(EXIT_FAILURE);
-    }
-
-    glfwSetKeyCallback(window, key_callback);
-    glfwSetCursorPosCallback(window, cursor_position_callback);
-    glfwSetMouseButtonCallback(window, mouse_button_callback);
-    glfwSetWindowSizeCallback(window, macOS_HiDPI_WindowManager);
-
-    init(window);
-
-    TwInit(TW_OPENGL_CORE, nullptr);
-    TwBar* tweakBar = CreateUI("Main");
-
-
-    double lastUpdateTime = glfwGetTime();
-    double elapsedTime = lastUpdateTime;
-    int frameCount = 0;
-
-
-    while (!glfwWindowShouldClose(window))
-    {
-        UpdateScene(window);
-
-        Render();
-
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-
-        frameCount++;
-        elapsedTime = glfwGetTime() - lastUpdateTime;
-
-        // if elapsed time since last update > 1 second
-        if (elapsedTime > 1.0)
-        {
-            gFrameTime = elapsedTime / frameCount;  // average time per frame
-            gFrameRate = 1 / gFrameTime;            // frames per second
-            lastUpdateTime = glfwGetTime();         // set last update time to current time
-            frameCount = 0;                         // reset frame counter
-        }
-    }
-    
-
-    TwDeleteBar(tweakBar);
-    TwTerminate();
-
-    glfwDestroyWindow(window);
-    glfwTerminate();
-
-    
-    
-    exit(EXIT_SUCCESS);
-}
+#include "utilities.h"
+#include "Texture.h"
+#include "Camera.h"
+#include "SimpleModel.h"
+#include "RenderQueue.h"
+#include "Culling.h"
+#include "Scene.h"
+#include "RenderTarget.h"
+#include "ShadowCubeMap.h"
+#include "OcclusionBuffer.h"
+#include "ResolutionScaler.h"
+#include "StreamBuffer.h"
+#include "GLState.h"
+#include "SimulationThread.h"
+#include "TripleBuffer.h"
+#include "JobSystem.h"
+#include "JobBenchmark.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "RenderStats.h"
+#include "FrameTimeRecorder.h"
+#include "HeadlessContext.h"
+
+#include <iomanip>
+
+// MARK: - Global Varibales
+
+// Global variables for window dimensions
+unsigned int gWindowWidth = 800;
+unsigned int gWindowHeight = 600;
+
+// Shader programs
+ShaderProgram gShader;
+ShaderProgram gLightShader;
+ShaderProgram gNormalMapShader;
+ShaderProgram gLightInstancedShader;
+ShaderProgram gNormalMapInstancedShader;
+ShaderProgram gLightMultiViewShader;
+ShaderProgram gNormalMapMultiViewShader;
+ShaderProgram gDepthShader;
+ShaderProgram gDepthInstancedShader;
+ShaderProgram gShadowShader;
+
+// Headless benchmark: an offscreen context, a scripted camera and light, a JSON report
+bool gHeadless = false;                  // No window and no tweak bar
+const int kBenchmarkFrames = 600;
+const char* kBenchmarkReportFile = "bench_report.json";
+
+// Frame rate settings
+float gFrameRate = 120.0f;
+float gFrameTime = 1 / gFrameRate; // Frame time calculated based on frame rate
+
+// Frame time distributions: CPU time of every frame, GPU time of every frame read back, exported at exit
+const char* kFrameTimesCsvFile = "frame_times.csv";
+const char* kFrameTimesJsonFile = "frame_times.json";
+float gFrameBudget = 1.5f * 1000.0f / 60.0f;  // Frames over this many ms count as hitches, 1.5 refresh intervals
+FrameTimeRecorder gCpuFrameTimes("cpu");
+FrameTimeRecorder gGpuFrameTimes("gpu");
+float gFrameTimePercentiles[2][5];       // p50, p90, p99, p99.9 and max of the CPU and GPU windows in ms
+int gFrameHitches[2] = { 0, 0 };         // Hitches in the CPU and GPU windows
+
+// Rotation settings
+const float rotationSpeed = 20.0f; // Speed of rotation
+bool rotationEnabled = true;       // Flag to control rotation
+
+// Models
+SimpleModel torusModel;           // Torus model
+SimpleModel floorModel;           // Floor model
+SimpleModel viewportBorderModel;  // Viewport border model
+SimpleModel wallModel;            // Wall model
+SimpleModel paintingModel;        // Painting model
+
+// Render queue shared by all scene viewports
+RenderQueue gRenderQueue;
+
+// Work-stealing job system for the scene update, occlusion rasterisation and asset loading, created by main()
+JobSystem* gJobs = nullptr;
+JobCounter gAssetLoads;           // Asset loads still running during init()
+int gJobThreads = 0;              // Threads running jobs, including the main thread
+int gJobsRun = 0;                 // Jobs run last frame
+int gJobsStolen = 0;              // Jobs taken from another thread's deque last frame
+bool gParallelRecording = true;   // Cull, submit and record the scene viewports on the job threads
+int gRecordedCommands = 0;        // Commands recorded for the GL thread last frame
+float gRecordTime = 0.0f;         // Cost of recording them in ms
+
+// Scene entities (placement, renderables, lights)
+Scene gScene;
+Entity gTorusEntity = kNoEntity;  // Animated torus
+Entity gLightEntity = kNoEntity;  // Point light
+int gEntityCount = 0;             // Number of entities in gScene
+float gSceneUpdateTime = 0.0f;    // Cost of the last transform update in ms
+
+// Extra point lights for clustered shading, children of a rotating pivot (scene lights 1 and up)
+const int kMaxExtraLights = 512;
+Entity gExtraLightPivot = kNoEntity;
+int gExtraLights = 0;                 // Number of extra lights switched on
+int gClusterLightCount = 0;           // Lights assigned to clusters in the last frame
+int gClusterIndexCount = 0;           // Light references in all clusters
+float gClusterBuildTime = 0.0f;       // Cost of the light assignment in ms
+
+// Cube shadow map of the main light, shared by all viewports; faces are only re-rendered when something in them moved
+ShadowCubeMap gShadowMap;
+bool gShadows = true;
+int gShadowFacesRendered = 0;         // Faces re-rendered this frame
+int gShadowFaceUpdates = 0;           // Faces re-rendered since start
+
+// Transform stress test: animated pivots, each with a ring of child entities
+const int kStressPivots = 1000;
+const int kStressChildren = 99;
+std::vector<Entity> gStressPivots;
+bool gStressTest = false;
+
+// Single-pass rendering of all scene viewports (needs GL_ARB_viewport_array)
+bool gMultiViewSupported = false;
+bool gMultiView = false;
+
+int gVisibleCount = 0;               // Objects passing the frustum test, summed over viewports
+int gCulledCount = 0;                // Objects rejected by the frustum test, summed over viewports
+
+// Software occlusion culling: the walls and floor are rasterised on the CPU for every viewport camera
+struct SceneOccluder
+{
+    Entity entity;
+    const OccluderMesh* mesh;
+};
+
+OccluderMesh gWallOccluder;           // Unit quad in the xy plane, like the wall model
+OccluderMesh gFloorOccluder;          // Unit quad in the xz plane, like the floor model
+std::vector<SceneOccluder> gOccluders;
+std::vector<uint8_t> gRenderOccluder;  // Per renderable, drawn in the occluder pass
+OcclusionBuffer gOcclusionBuffers[4];
+bool gOcclusionCulling = true;
+int gOccludedCount = 0;               // Objects rejected by the occlusion test, summed over viewports
+float gOcclusionTime = 0.0f;          // Cost of rasterising the occluders in ms, summed over viewports
+
+// Hardware occlusion queries of bounding boxes, issued after the occluder pass of each viewport
+bool gOcclusionQueries = false;
+int gQueryHysteresis[4] = { 4, 4, 4, 4 };   // Per viewport: hidden results in a row before drawing conditionally
+int gQueryCount = 0;                  // Queries issued this frame
+int gQueryResults = 0;                // Results read back this frame
+int gConditionalDraws = 0;            // Draws left to the GPU to skip this frame
+int gDroppedQueries = 0;              // Queries whose results never arrived in time
+int gInsideQueries = 0;               // Boxes around the viewpoint, drawn without a query
+
+// Camera settings
+float gYaw = 0.0;         // Yaw angle for camera orientation
+float gPitch = 0.0;       // Pitch angle for camera orientation
+float CameraZoom = 15.0f; // Zoom level for camera
+
+// Viewport data structure to manage multiple viewports
+struct ViewportData
+{
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    Camera cam; // Camera associated with the viewports
+
+    ViewportData() {}
+
+    // Constructor to initialize viewport data with specific dimensions
+    ViewportData(int x, int y, int width, int height) : x(x), y(y), width(width), height(height) {}
+};
+
+std::vector<ViewportData> ViewportNumber; // Vector to store viewport data
+
+// Cached rendering of the static scene for viewports with a fixed camera
+struct ViewportCache
+{
+    bool enabled = false;             // Only for viewports whose camera never moves
+    bool valid = false;
+    RenderTarget target;              // Static objects, colour and depth
+    uint32_t staticVersion = 0;       // Scene state the cache was rendered with
+    uint32_t lightVersion = 0;
+    uint32_t shadowVersion = 0;
+    bool shadows = false;
+    glm::mat4 projViewMatrix;
+};
+
+ViewportCache gViewportCache[4];
+RenderQueue gCacheQueue;              // Render queue for refreshing a viewport cache
+bool gViewCache = true;               // Toggle for cached rendering
+int gCachedViews = 0;                 // Viewports drawn from their cache this frame
+int gCacheUpdates = 0;                // Number of cache refreshes since start
+
+// Ring buffer for per-draw instance data, one fenced region per frame in flight
+StreamBuffer gStreamBuffer;
+bool gStreaming = true;               // Toggle between the ring buffer and per-model uploads
+float gStreamUsage = 0.0f;            // KB written to the ring buffer last frame
+int gStreamWaits = 0;                 // Frames that had to wait for the GPU to release a region
+int gMaterialCount = 0;               // Distinct materials in the render queue's material buffer
+bool gStateFiltering = true;          // Filter out GL calls that would not change the state
+int gGLCallsIssued = 0;               // State calls passed on to OpenGL last frame
+int gGLCallsSkipped = 0;              // State calls filtered out last frame
+
+// Simulation (animation, future gameplay) on its own thread, one frame ahead of rendering.
+// Settings go to it and snapshots come back through lock-free triple buffers.
+// The simulation advances in fixed ticks; each step runs as many ticks as the elapsed time covers,
+// and the renderer interpolates between the last two
+struct SimulationInput
+{
+    bool rotationEnabled = true;
+    bool stressTest = false;
+    int extraLights = 0;
+    int tickRate = 60;                // Ticks per second
+    int maxTicksPerStep = 8;          // Catch-up limit, time beyond it is dropped
+};
+
+// Rotations of one simulation tick
+struct SimulationState
+{
+    glm::quat torusRotation;
+    glm::quat extraLightRotation;
+    std::vector<glm::quat> pivotRotations;  // Stress test pivots, empty while it is off
+};
+
+struct SimulationSnapshot
+{
+    uint64_t step = 0;
+    uint64_t tick = 0;                // Ticks simulated since start
+    int ticks = 0;                    // Ticks run by this step
+    bool rotating = false;            // The previous and current tick differ
+    SimulationState previous;         // Tick before the current one
+    SimulationState current;          // Latest tick
+    uint64_t stepTime = 0;            // Profiler clock when the step ran, in ns
+    uint64_t previousTickTime = 0;    // Profiler clock the previous and current ticks stand for
+    uint64_t currentTickTime = 0;
+    float droppedSeconds = 0.0f;      // Time dropped by the catch-up limit since start
+    int extraLights = 0;
+};
+
+TripleBuffer<SimulationInput> gSimulationInput;
+TripleBuffer<SimulationSnapshot> gSimulationSnapshots;
+SimulationThread gSimulationThread;
+bool gThreadedSimulation = true;      // Toggle between the simulation thread and simulating before each frame
+float gSimulationTime = 0.0f;         // Cost of the last simulation step in ms
+int gTickRate = 60;                   // Simulation ticks per second
+int gMaxTicksPerStep = 8;             // Ticks a step may run to catch up before time is dropped
+bool gInterpolation = true;           // Interpolate between the last two ticks, or show the latest one
+int gStepTicks = 0;                   // Ticks run by the last step
+float gDroppedTime = 0.0f;            // Simulation time dropped by the catch-up limit in ms
+
+// CPU zone profiler: rolling per-zone breakdown in the tweak bar, Chrome trace written on demand
+const int kMaxProfilerZones = 64;
+const char* kTraceFile = "trace.json";
+bool gProfiling = true;
+float gProfilerZoneTimes[kMaxProfilerZones];  // Average ms per frame of each zone shown
+size_t gProfilerZonesShown = 0;
+
+// Zone names of the per-viewport work
+const char* kRenderSceneZones[4] = { "RenderScene 0", "RenderScene 1", "RenderScene 2", "RenderScene 3" };
+const char* kSubmitViewportZones[4] = { "SubmitViewport 0", "SubmitViewport 1", "SubmitViewport 2", "SubmitViewport 3" };
+const char* kViewportGpuZones[4] = { "Viewport 0", "Viewport 1", "Viewport 2", "Viewport 3" };
+const char* kViewportSceneGpuZones[4] = { "Viewport 0 Scene", "Viewport 1 Scene", "Viewport 2 Scene", "Viewport 3 Scene" };
+
+// GPU zone profiler: timestamp queries read a few frames late, shown next to the CPU zones and in the trace
+bool gGpuProfiling = true;
+float gGpuZoneTimes[kMaxProfilerZones];       // Average GPU ms per frame of each zone shown
+size_t gGpuZonesShown = 0;
+int gGpuDroppedFrames = 0;                    // Frames whose queries were not ready in time
+
+// Rendering statistics of the last frame, per viewport scope and in total (last row), dumped as JSON on demand
+const char* kRenderStatsFile = "render_stats.json";
+int gRenderStats[RenderStats::kScopeCount + 1][STAT_COUNT];
+
+// Depth pre-pass per viewport, and GPU time per viewport to compare with and without it
+bool gDepthPrepass[4] = { false, false, false, false };
+int gViewportView[4] = { -1, -1, -1, -1 };   // Render queue view of each viewport this frame
+float gViewportGpuTime[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+float gMultiViewGpuTime = 0.0f;
+
+// Dynamic resolution: scene viewports render into an offscreen target at a scale picked from their GPU time,
+// then are upscaled into the window
+RenderTarget gSceneTarget;            // Window sized, each viewport uses the scaled part of its own region
+ResolutionScaler gResolutionScalers[4];
+bool gDynamicResolution = false;
+float gResolutionBudget = 6.0f;       // GPU time in ms for all scene viewports together
+float gMinResolutionScale = 0.5f;
+float gViewportScale[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+
+
+
+// MARK: - Asset Loading
+// Files are decoded on the job threads; the GL objects are created on the main thread while init() waits for gAssetLoads
+
+static void LoadTextureAsync(Texture& texture, const std::string& filename)
+{
+    gJobs->run([&texture, filename] {
+        if (texture.load(filename))
+            gJobs->runOnMainThread([&texture] { texture.upload(); }, &gAssetLoads);
+    }, &gAssetLoads);
+}
+
+static void LoadCubeMapAsync(Texture& texture, const std::string& fileFront, const std::string& fileBack,
+    const std::string& fileLeft, const std::string& fileRight, const std::string& fileTop, const std::string& fileBottom)
+{
+    gJobs->run([=, &texture] {
+        if (texture.load(fileFront, fileBack, fileLeft, fileRight, fileTop, fileBottom))
+            gJobs->runOnMainThread([&texture] { texture.upload(); }, &gAssetLoads);
+    }, &gAssetLoads);
+}
+
+static void LoadModelAsync(SimpleModel& model, const std::string& filename, bool texture = false)
+{
+    gJobs->run([&model, filename, texture] {
+        if (model.importModel(filename.c_str(), texture))
+        {
+            gJobs->runOnMainThread([&model] { model.upload(); }, &gAssetLoads);
+        }
+        else
+        {
+            // The scene needs every model, stop on the main thread like loadModel() would
+            gJobs->runOnMainThread([filename] {
+                std::cerr << "Failed to open: " << filename << std::endl;
+                exit(EXIT_FAILURE);
+            }, &gAssetLoads);
+        }
+    }, &gAssetLoads);
+}
+
+
+
+
+// MARK: - Setup functions
+// These functions initialize the geometry, materials, and textures for each respective model (for viewport border, floor, walls, and painting models)
+    
+void SetupViewportBorder() {
+    auto mesh = viewportBorderModel.GetMesh();
+    mesh->hasTexCoords = false;
+    mesh->numOfIndices = 0;
+    mesh->numOfVertices = 4;
+
+    viewportBorderModel.mIsValid = true;
+
+    std::vector<GLfloat> borderVertices = {
+        -1.0f, 0.0f, 0.0f, // Vertex 1
+         1.0f, 1.0f, 1.0f, // Color 1
+         1.0f, 0.0f, 0.0f, // Vertex 2
+         1.0f, 1.0f, 1.0f, // Color 2
+         0.0f, 1.0f, 0.0f, // Vertex 3
+         1.0f, 1.0f, 1.0f, // Color 3
+         0.0f, -1.0f, 0.0f,// Vertex 4
+         1.0f, 1.0f, 1.0f  // Color 4
+    };
+
+    // Generate and bind VAO
+    glGenVertexArrays(1, &mesh->VAO);
+    GLState::bindVertexArray(mesh->VAO);
+
+    // Generate, bind, and fill VBO
+    glGenBuffers(1, &mesh->VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * borderVertices.size(), borderVertices.data(), GL_STATIC_DRAW);
+
+    // Define vertex attributes layout
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+
+    // Enable vertex attributes
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+
+    // Unbind VAO
+    GLState::bindVertexArray(0);
+}
+
+
+
+
+void SetupFloor() {
+    Mesh* mesh =  floorModel.GetMesh();
+
+    // Configure mesh properties
+    mesh->hasTexCoords = false;
+    mesh->numOfIndices = 0;
+    mesh->numOfVertices = 4;
+    floorModel.mIsValid = true; 
+
+    // Set material properties
+    mesh->material.Ka = glm::vec3(0.25f, 0.21f, 0.21f);
+    mesh->material.Kd = glm::vec3(1.0f, 0.83f, 0.83f);
+    mesh->material.Ks = glm::vec3(0.3f, 0.3f, 0.3f);
+    mesh->material.shininess = 11.3f;
+
+    // Load texture
+    LoadTextureAsync(mesh->texture, "./images/check.bmp");
+
+    // Define floor vertices
+    std::vector<GLfloat> vertices = {
+        -1.0f, 0.0f, 1.0f,   0.0f, 1.0f, 0.0f,   0.0f, 0.0f,
+         1.0f, 0.0f, 1.0f,   0.0f, 1.0f, 0.0f,   5.0f, 0.0f,
+        -1.0f, 0.0f, -1.0f,  0.0f, 1.0f, 0.0f,   0.0f, 5.0f,
+         1.0f, 0.0f, -1.0f,  0.0f, 1.0f, 0.0f,   5.0f, 5.0f,
+    };
+    floorModel.computeBounds(vertices.data(), mesh->numOfVertices, sizeof(VertexNormTex) / sizeof(GLfloat));
+    floorModel.createPositionStream(vertices.data(), mesh->numOfVertices, sizeof(VertexNormTex) / sizeof(GLfloat));
+
+    // Setup Vertex Buffer Object (VBO )
+    glGenBuffers(1, &mesh->VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+    // Setup VAO (Vertex Array Object) and configure it
+    glGenVertexArrays(1, &mesh->VAO);
+    GLState::bindVertexArray(mesh->VAO);
+
+    // Set up vertex attributes
+    auto setupVertexAttrib = [&](GLuint index, GLint size, GLenum type, GLsizei stride, size_t offset) {
+        glVertexAttribPointer(index, size, type, GL_FALSE, stride, reinterpret_cast<void*>(offset));
+        glEnableVertexAttribArray(index);
+    };
+
+    GLsizei stride = sizeof(VertexNormTex);
+    setupVertexAttrib(0, 3, GL_FLOAT, stride, offsetof(VertexNormTex, position));
+    setupVertexAttrib(1, 3, GL_FLOAT, stride, offsetof(VertexNormTex, normal));
+    setupVertexAttrib(2, 2, GL_FLOAT, stride, offsetof(VertexNormTex, texCoord));
+
+    GLState::bindVertexArray(0); // Unbind VAO
+}
+
+
+
+
+void SetupWalls() {
+    Mesh* mesh = wallModel.GetMesh();
+
+    // Set mesh properties
+    mesh->hasTexCoords = false;
+    mesh->numOfIndices = 0;
+    mesh->numOfVertices = 4;
+    wallModel.mIsValid = true; // Validate wall model
+
+    // Texture loading
+    LoadTextureAsync(mesh->texture, "./images/Fieldstone.bmp");
+    LoadTextureAsync(mesh->normalTexture, "./images/FieldstoneBumpDOT3.bmp");
+
+    // Material configuration
+    mesh->material.Ka = glm::vec3(0.2f);
+    mesh->material.Kd = glm::vec3(0.2f, 0.7f, 1.0f);
+    mesh->material.Ks = glm::vec3(0.2f, 0.7f, 1.0f);
+    mesh->material.shininess = 40.0f;
+
+    // Define vertices with position, normal, tangent, and texture coordinates
+    std::vector<GLfloat> vertices = {
+        -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+         1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 2.0f, 0.0f,
+        -1.0f,  1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 2.0f,
+         1.0f,  1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 2.0f, 2.0f,
+    };
+    wallModel.computeBounds(vertices.data(), mesh->numOfVertices, sizeof(VertexNormTanTex) / sizeof(GLfloat));
+    wallModel.createPositionStream(vertices.data(), mesh->numOfVertices, sizeof(VertexNormTanTex) / sizeof(GLfloat));
+
+    // Setup Vertex Buffer Object (VBO )
+    glGenBuffers(1, &mesh->VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+
+    // Setup VAO (Vertex Array Object) and configure it
+    glGenVertexArrays(1, &mesh->VAO);
+    GLState::bindVertexArray(mesh->VAO);
+
+    auto setVertexAttribute = [&](GLuint index, GLint size, GLenum type, bool normalized, GLsizei stride, std::size_t offset) {
+        glVertexAttribPointer(index, size, type, normalized, stride, reinterpret_cast<void*>(offset));
+        glEnableVertexAttribArray(index);
+    };
+
+    GLsizei stride = sizeof(VertexNormTanTex); // Assuming a struct named VertexNormTanTex defines the stride
+    setVertexAttribute(0, 3, GL_FLOAT, GL_FALSE, stride, offsetof(VertexNormTanTex, position));
+    setVertexAttribute(1, 3, GL_FLOAT, GL_FALSE, stride, offsetof(VertexNormTanTex, normal));
+    setVertexAttribute(2, 3, GL_FLOAT, GL_FALSE, stride, offsetof(VertexNormTanTex, tangent));
+    setVertexAttribute(3, 2, GL_FLOAT, GL_FALSE, stride, offsetof(VertexNormTanTex, texCoord));
+
+    GLState::bindVertexArray(0); // Unbind VAO
+}
+
+
+
+
+void SetupPainting() {
+    Mesh* mesh = paintingModel.GetMesh();
+
+    // Initialize mesh properties
+    mesh->hasTexCoords = false;
+    mesh->numOfIndices = 0;
+    mesh->numOfVertices = 4;
+    paintingModel.mIsValid = true; // Mark the painting model as valid
+
+    // Set material properties
+    mesh->material.Ka = glm::vec3(0.25f, 0.21f, 0.21f);
+    mesh->material.Kd = glm::vec3(1.0f, 0.83f, 0.83f);
+    mesh->material.Ks = glm::vec3(0.3f, 0.3f, 0.3f);
+    mesh->material.shininess = 11.3f;
+
+    // Generate texture
+    LoadTextureAsync(mesh->texture, "./images/painting.png");
+
+    // Define vertices for the painting
+    std::vector<GLfloat> vertices = {
+        -1.0f, 0.0f,  1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f,
+         1.0f, 0.0f,  1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f,
+        -1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,
+         1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f,
+    };
+    paintingModel.computeBounds(vertices.data(), mesh->numOfVertices, sizeof(VertexNormTex) / sizeof(GLfloat));
+    paintingModel.createPositionStream(vertices.data(), mesh->numOfVertices, sizeof(VertexNormTex) / sizeof(GLfloat));
+
+    // Setup Vertex Buffer Object (VBO )
+    glGenBuffers(1, &mesh->VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices[0]) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+
+    // Setup VAO (Vertex Array Object) and configure it
+    glGenVertexArrays(1, &mesh->VAO);
+    GLState::bindVertexArray(mesh->VAO);
+
+    // Simplify attribute setup with a lambda function
+    auto setupVertexAttrib = [&](GLuint index, GLint size, GLenum type, GLsizei stride, size_t offset) {
+        glVertexAttribPointer(index, size, type, GL_FALSE, stride, reinterpret_cast<void*>(offset));
+        glEnableVertexAttribArray(index);
+    };
+
+    GLsizei stride = sizeof(VertexNormTex); // Assuming VertexNormTex structure defines the layout
+    setupVertexAttrib(0, 3, GL_FLOAT, stride, offsetof(VertexNormTex, position));
+    setupVertexAttrib(1, 3, GL_FLOAT, stride, offsetof(VertexNormTex, normal));
+    setupVertexAttrib(2, 2, GL_FLOAT, stride, offsetof(VertexNormTex, texCoord));
+
+    GLState::bindVertexArray(0); // Unbind VAOs
+}
+
+
+
+
+// MARK: - Scene Entities
+// Places a model in the scene as a renderable entity
+static Entity AddSceneModel(ShaderProgram* program, SimpleModel* model, GLenum topology,
+                            const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    Entity entity = gScene.createEntity();
+    gScene.setLocalTransform(entity, position, rotation, scale);
+    gScene.addRenderable(entity, program, model, topology);
+
+    // Sort key slots in scene order, so parallel submission cannot change the draw order between runs
+    gRenderQueue.reserveSlots(program, model);
+    gCacheQueue.reserveSlots(program, model);
+    return entity;
+}
+
+// Marks a scene entity as an occluder for the software occlusion test
+static void AddOccluder(Entity entity, const OccluderMesh* mesh)
+{
+    SceneOccluder occluder;
+    occluder.entity = entity;
+    occluder.mesh = mesh;
+    gOccluders.push_back(occluder);
+
+    // Occluders are also drawn first, so the occlusion queries test against them
+    gRenderOccluder.resize(gScene.getRenderableCount(), 0);
+    for (size_t i = 0; i < gScene.getRenderableCount(); ++i) {
+        if (gScene.getRenderEntity(i) == entity)
+            gRenderOccluder[i] = 1;
+    }
+}
+
+// Builds the occluder stand-ins for the wall and floor models (two triangles each)
+static void SetupOccluders()
+{
+    gWallOccluder.positions = { glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec3(1.0f, -1.0f, 0.0f),
+                                glm::vec3(-1.0f, 1.0f, 0.0f), glm::vec3(1.0f, 1.0f, 0.0f) };
+    gWallOccluder.indices = { 0, 1, 2, 2, 1, 3 };
+
+    gFloorOccluder.positions = { glm::vec3(-1.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 1.0f),
+                                 glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(1.0f, 0.0f, -1.0f) };
+    gFloorOccluder.indices = { 0, 1, 2, 2, 1, 3 };
+}
+
+static void SetupScene()
+{
+    const glm::vec3 xAxis(1.0f, 0.0f, 0.0f);
+    const glm::vec3 yAxis(0.0f, 1.0f, 0.0f);
+    const glm::quat noRotation(1.0f, 0.0f, 0.0f, 0.0f);
+
+    SetupOccluders();
+
+    // Floor
+    AddOccluder(AddSceneModel(&gLightShader, &floorModel, GL_TRIANGLE_STRIP,
+                glm::vec3(0.0f, -4.0f, 0.0f), noRotation, glm::vec3(8.0f, 1.0f, 8.0f)), &gFloorOccluder);
+
+    // Painting
+    AddSceneModel(&gLightShader, &paintingModel, GL_TRIANGLE_STRIP,
+                  glm::vec3(0.0f, 0.0f, -3.9f), glm::angleAxis(glm::radians(90.0f), xAxis), glm::vec3(3.0f, 1.0f, 2.0f));
+
+    // Torus
+    gTorusEntity = AddSceneModel(&gLightShader, &torusModel, GL_TRIANGLES,
+                  glm::vec3(0.0f, -1.0f, 0.0f), glm::angleAxis(glm::radians(90.0f), xAxis), glm::vec3(2.0f));
+
+    // Back, left, right and front walls
+    AddOccluder(AddSceneModel(&gNormalMapShader, &wallModel, GL_TRIANGLE_STRIP,
+                glm::vec3(0.0f, 0.0f, -4.0f), noRotation, glm::vec3(8.0f, 4.0f, 1.0f)), &gWallOccluder);
+    AddOccluder(AddSceneModel(&gNormalMapShader, &wallModel, GL_TRIANGLE_STRIP,
+                glm::vec3(-8.0f, 0.0f, 0.0f), glm::angleAxis(glm::radians(90.0f), yAxis), glm::vec3(8.0f, 4.0f, 1.0f)), &gWallOccluder);
+    AddOccluder(AddSceneModel(&gNormalMapShader, &wallModel, GL_TRIANGLE_STRIP,
+                glm::vec3(8.0f, 0.0f, 0.0f), glm::angleAxis(glm::radians(-90.0f), yAxis), glm::vec3(8.0f, 4.0f, 1.0f)), &gWallOccluder);
+    AddOccluder(AddSceneModel(&gNormalMapShader, &wallModel, GL_TRIANGLE_STRIP,
+                glm::vec3(0.0f, 0.0f, 8.0f), glm::angleAxis(glm::radians(180.0f), yAxis), glm::vec3(8.0f, 4.0f, 1.0f)), &gWallOccluder);
+
+    // Point light
+    Light pointLight;
+    pointLight.type = 1;
+    pointLight.La = glm::vec3(1.0f, 0.9f, 0.3f);
+    pointLight.Ld = glm::vec3(0.8f);
+    pointLight.Ls = glm::vec3(0.8f);
+    pointLight.att = glm::vec3(1.0f, 0.0f, 0.0f);
+
+    gLightEntity = gScene.createEntity();
+    gScene.setPosition(gLightEntity, glm::vec3(3.0f, 3.0f, 0.0f));
+    gScene.addLight(gLightEntity, pointLight);
+}
+
+// Adds kMaxExtraLights small coloured point lights around the room, all switched off
+static void SetupExtraLights()
+{
+    gExtraLightPivot = gScene.createEntity();
+
+    for (int i = 0; i < kMaxExtraLights; ++i) {
+        // Spread deterministically through the room with varied colours
+        float angle = glm::radians(137.5f * i);
+        float radius = 1.5f + 5.5f * ((i * 7919) % kMaxExtraLights) / kMaxExtraLights;
+        float height = -3.5f + 6.5f * ((i * 104729) % kMaxExtraLights) / kMaxExtraLights;
+
+        Light light;
+        light.type = 0;
+        light.La = glm::vec3(0.0f);
+        light.Ld = glm::vec3(0.5f + 0.5f * cosf(angle), 0.5f + 0.5f * cosf(angle + 2.1f), 0.5f + 0.5f * cosf(angle + 4.2f)) * 0.6f;
+        light.Ls = light.Ld;
+        light.att = glm::vec3(1.0f, 4.0f, 16.0f);
+        light.dir = glm::vec3(0.0f, -1.0f, 0.0f);
+        light.innerAngle = 0.0f;
+        light.outerAngle = 0.0f;
+
+        Entity entity = gScene.createEntity(gExtraLightPivot);
+        gScene.setPosition(entity, glm::vec3(cosf(angle) * radius, height, sinf(angle) * radius));
+        gScene.addLight(entity, light);
+    }
+}
+
+// Adds kStressPivots * (kStressChildren + 1) transform-only entities below the torus
+static void SetupStressTest()
+{
+    Entity root = gScene.createEntity();
+    gScene.setPosition(root, glm::vec3(0.0f, -1.0f, 0.0f));
+
+    for (int i = 0; i < kStressPivots; ++i) {
+        Entity pivot = gScene.createEntity(root);
+        float angle = glm::radians(360.0f * i / kStressPivots);
+        gScene.setPosition(pivot, glm::vec3(cosf(angle), 0.0f, sinf(angle)) * 6.0f);
+        gStressPivots.push_back(pivot);
+
+        for (int j = 0; j < kStressChildren; ++j) {
+            Entity child = gScene.createEntity(pivot);
+            float childAngle = glm::radians(360.0f * j / kStressChildren);
+            gScene.setLocalTransform(child, glm::vec3(cosf(childAngle), sinf(childAngle), 0.0f) * 0.5f,
+                                     glm::angleAxis(childAngle, glm::vec3(0.0f, 0.0f, 1.0f)), glm::vec3(0.05f));
+        }
+    }
+}
+
+
+
+
+// MARK: - Initialization function
+void init(int framebufferWidth, int framebufferHeight) {
+    // Update global window size variables based on the framebuffer size
+    gWindowWidth = framebufferWidth;
+    gWindowHeight = framebufferHeight;
+
+    //Add andi Initialize viewport data based on the framebuffer size
+    ViewportNumber.emplace_back(0, framebufferHeight / 2, framebufferWidth / 2, framebufferHeight / 2);
+    ViewportNumber.emplace_back(framebufferWidth / 2, framebufferHeight / 2, framebufferWidth / 2, framebufferHeight / 2);
+    ViewportNumber.emplace_back(0, 0, framebufferWidth / 2, framebufferHeight / 2);
+    ViewportNumber.emplace_back(framebufferWidth / 2, 0, framebufferWidth / 2, framebufferHeight / 2);
+    
+    // Update projection matrices for each viewport
+    float aspectRatio = static_cast<float>(framebufferWidth) / static_cast<float>(framebufferHeight);
+    float scale1 = tanf(glm::radians(60.0f) / 2.0f) * CameraZoom;
+    float scale2 = tanf(glm::radians(60.0f) / 2.0f) * 12.0f;
+
+    // Projection matrix for viewport 1
+    glm::mat4 projMat = glm::ortho(-scale1 * aspectRatio, scale1 * aspectRatio, -scale1, scale1, 0.01f, 100.0f);
+    ViewportNumber[1].cam.setProjMatrix(projMat);
+    ViewportNumber[1].cam.setViewMatrix(glm::vec3(0.0f, CameraZoom, 0.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0, 0.0, -1.0));
+
+    // Projection matrix for viewport 2
+    projMat = glm::ortho(-scale2 * aspectRatio, scale2 * aspectRatio, -scale2, scale2, 0.01f, 100.0f);
+    ViewportNumber[2].cam.setProjMatrix(projMat);
+    ViewportNumber[2].cam.setViewMatrix(glm::vec3(0.0f, 0.0f, 8.0f), glm::vec3(0.0f, 0.0f, 0.0f));
+
+    // Projection matrix for viewport 3
+    projMat = glm::perspective(glm::radians(70.0f), aspectRatio, 0.1f, 100.0f);
+    ViewportNumber[3].cam.setProjMatrix(projMat);
+    ViewportNumber[3].cam.setViewMatrix(glm::vec3(0.0f, 0.0f, 7.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0, 1.0, 0.0));
+
+    // Initialize shaders
+    gShader.compileAndLink("SimpleTransform.vert", "color.frag");
+    gLightShader.compileAndLink("lightingAndTexture.vert", "pointLightTexture.frag");
+    gNormalMapShader.compileAndLink("normalMap.vert", "normalMap.frag");
+    gLightInstancedShader.compileAndLink("lightingAndTextureInstanced.vert", "pointLightTexture.frag");
+    gNormalMapInstancedShader.compileAndLink("normalMapInstanced.vert", "normalMap.frag");
+    gDepthShader.compileAndLink("depthOnly.vert", "depthOnly.frag");
+    gDepthInstancedShader.compileAndLink("depthOnlyInstanced.vert", "depthOnly.frag");
+    gShadowShader.compileAndLink("shadowDepth.vert", "shadowDepth.frag");
+
+    // Shadows of the main light reach across the whole room
+    gShadowMap.create(512, 25.0f);
+
+    // Repeated meshes (e.g. the four walls) are batched into instanced draws
+    gRenderQueue.setInstancedProgram(&gLightShader, &gLightInstancedShader);
+    gRenderQueue.setInstancedProgram(&gNormalMapShader, &gNormalMapInstancedShader);
+    gCacheQueue.setInstancedProgram(&gLightShader, &gLightInstancedShader);
+    gCacheQueue.setInstancedProgram(&gNormalMapShader, &gNormalMapInstancedShader);
+
+    // Per-draw instance data is streamed through a persistently mapped ring buffer where available
+    gStreamBuffer.create(4 * 1024 * 1024);
+
+    // Position-only programs for the optional depth pre-pass, judged by the GPU profiler's view times
+    gRenderQueue.setDepthProgram(&gDepthShader);
+    gRenderQueue.setInstancedProgram(&gDepthShader, &gDepthInstancedShader);
+
+    // The top and front views have fixed cameras, so their static objects are cached
+    gViewportCache[1].enabled = true;
+    gViewportCache[2].enabled = true;
+
+    // All scene viewports can be drawn in one pass, routed by a geometry shader
+    gMultiViewSupported = GLState::isVersionAtLeast(4, 1) || GLState::isExtensionSupported("GL_ARB_viewport_array");
+    if (gMultiViewSupported) {
+        gLightMultiViewShader.compileAndLink("lightingAndTextureMultiView.vert", "multiView.geom", "pointLightTexture.frag");
+        gNormalMapMultiViewShader.compileAndLink("normalMapMultiView.vert", "multiView.geom", "normalMap.frag");
+        gRenderQueue.setMultiViewProgram(&gLightShader, &gLightMultiViewShader);
+        gRenderQueue.setMultiViewProgram(&gNormalMapShader, &gNormalMapMultiViewShader);
+        gMultiView = true;
+    }
+
+    SetupViewportBorder();
+    SetupFloor();
+    SetupWalls();
+    SetupPainting();
+    
+    /// Create Torus Model
+    // Set material properties for the Torus Model
+    torusModel.GetMesh()->material.Ka = glm::vec3(0.6f, 0.6f, 0.6f);  // Ambient color
+    torusModel.GetMesh()->material.Kd = glm::vec3(1.0f, 1.0f, 1.0f);  // Diffuse color
+    torusModel.GetMesh()->material.Ks = glm::vec3(0.8f, 0.8f, 0.8f);  // Specular color
+    torusModel.GetMesh()->material.shininess = 40.0f;  // Shininess
+
+    // Generate texture for the Torus Model
+    LoadCubeMapAsync(torusModel.GetMesh()->texture,
+        "./images/cm_front.bmp", "./images/cm_back.bmp",
+        "./images/cm_left.bmp", "./images/cm_right.bmp",
+        "./images/cm_top.bmp", "./images/cm_bottom.bmp");
+
+    // Load model data for the Torus Model
+    LoadModelAsync(torusModel, "./models/torus.obj");
+
+    // Finish loading before the scene needs the model bounds; the uploads run here on the main thread
+    gJobs->wait(gAssetLoads);
+
+    /// Place models and light in the scene
+    SetupScene();
+    gScene.update();
+
+    // Set OpenGL state
+    glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+    GLState::setDepthTest(true);
+}
+
+
+
+
+// MARK: - Scene Rendering Function
+// Every scene light after the main light is shaded through the light clusters
+static void SetClusterLights(RenderQueue& queue)
+{
+    size_t numLights = gScene.getLightCount();
+    if (numLights > 1)
+        queue.setClusterLights(&gScene.getLight(1), numLights - 1);
+    else
+        queue.setClusterLights(nullptr, 0);
+}
+
+// Which renderables to submit
+enum SubmitFilter
+{
+    SUBMIT_ALL,
+    SUBMIT_STATIC,
+    SUBMIT_DYNAMIC
+};
+
+// Culling results of one SubmitScene() call
+struct CullStats
+{
+    int visible = 0;
+    int culled = 0;
+    int occluded = 0;
+};
+
+// A scene viewport whose GL work is done, waiting to be culled and submitted on a job thread
+struct ViewportSubmission
+{
+    bool active = false;
+    int view = -1;
+    glm::mat4 projViewMatrix;
+    int width = 0;
+    int height = 0;
+    SubmitFilter filter = SUBMIT_ALL;
+    CullStats stats;
+    float occlusionTime = 0.0f;
+};
+
+ViewportSubmission gViewportSubmissions[4];
+
+static void AddCullStats(const CullStats& stats)
+{
+    gVisibleCount += stats.visible;
+    gCulledCount += stats.culled;
+    gOccludedCount += stats.occluded;
+}
+
+// Culls the scene against one view (and its occlusion buffer, if any) and submits the visible objects to a render queue.
+// Only reads the scene, so different views can be submitted from different threads
+static void SubmitScene(RenderQueue& queue, int view, const glm::mat4& projViewMatrix, SubmitFilter filter,
+                        CullStats& stats, const OcclusionBuffer* occlusion = nullptr)
+{
+    // Test every renderable against the view frustum
+    static thread_local std::vector<uint8_t> visible;
+    gScene.getBounds().cull(extractFrustum(projViewMatrix), visible);
+
+    // Submit the visible renderables with their cached matrices
+    for (size_t i = 0; i < gScene.getRenderableCount(); ++i) {
+        if (filter != SUBMIT_ALL && gScene.isRenderStatic(i) != (filter == SUBMIT_STATIC))
+            continue;
+
+        if (!visible[i]) {
+            stats.culled++;
+            continue;
+        }
+
+        // Hidden behind the walls or floor
+        if (occlusion && !occlusion->isVisible(gScene.getBounds().getCenter(static_cast<int>(i)),
+                                               gScene.getBounds().getRadius(static_cast<int>(i)))) {
+            stats.occluded++;
+            continue;
+        }
+        stats.visible++;
+
+        Entity entity = gScene.getRenderEntity(i);
+        RenderPass pass = (i < gRenderOccluder.size() && gRenderOccluder[i]) ? PASS_OCCLUDER : PASS_OPAQUE;
+        queue.submit(view, pass, gScene.getRenderProgram(i), gScene.getRenderModel(i), entity,
+                     gScene.getWorldMatrix(entity), gScene.getNormalMatrix(entity), gScene.getRenderTopology(i));
+    }
+}
+
+// Re-renders the static objects of a viewport into its cache if the scene, light, camera or size changed
+static void UpdateViewportCache(ViewportCache& cache, ViewportData& viewportData, int width, int height,
+                                const glm::mat4& projViewMatrix)
+{
+    bool resized = cache.target.resize(width, height);
+    if (cache.valid && !resized
+        && cache.staticVersion == gScene.getStaticVersion()
+        && cache.lightVersion == gScene.getLightVersion()
+        && cache.shadows == gShadows
+        && (!gShadows || cache.shadowVersion == gShadowMap.getVersion())
+        && cache.projViewMatrix == projViewMatrix)
+        return;
+
+    cache.valid = true;
+    cache.staticVersion = gScene.getStaticVersion();
+    cache.lightVersion = gScene.getLightVersion();
+    cache.shadows = gShadows;
+    cache.shadowVersion = gShadowMap.getVersion();
+    cache.projViewMatrix = projViewMatrix;
+    gCacheUpdates++;
+
+    cache.target.bind();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    gCacheQueue.clear();
+    gCacheQueue.setLight(&gScene.getLight(0));
+    SetClusterLights(gCacheQueue);
+    gCacheQueue.setShadowMap(gShadows ? &gShadowMap : nullptr);
+    int view = gCacheQueue.addView(0, 0, width, height, projViewMatrix, viewportData.cam.getPosition());
+    CullStats stats;
+    SubmitScene(gCacheQueue, view, projViewMatrix, SUBMIT_STATIC, stats);
+    AddCullStats(stats);
+    gCacheQueue.sort();
+    gCacheQueue.execute();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Prepares one viewport for submission to the render queue; culling and submitting happen in SubmitViewport(),
+// drawing in Render(). Cached viewports blit their static objects and only submit the dynamic ones
+static void RenderScene(int viewportIndex)
+{
+    PROFILE_ZONE(kRenderSceneZones[viewportIndex]);
+    ViewportData& viewportData = ViewportNumber[viewportIndex];
+    ViewportCache& cache = gViewportCache[viewportIndex];
+
+    // Calculate the projection-view matrix
+    glm::mat4 projViewMatrix = viewportData.cam.getProjMatrix() * viewportData.cam.getViewMatrix();
+
+    // With dynamic resolution the viewport is drawn into the lower left part of its region in the scene target
+    GLuint framebuffer = 0;
+    int width = viewportData.width;
+    int height = viewportData.height;
+    if (gDynamicResolution) {
+        framebuffer = gSceneTarget.getFramebuffer();
+        width = std::max(1, static_cast<int>(viewportData.width * gViewportScale[viewportIndex]));
+        height = std::max(1, static_cast<int>(viewportData.height * gViewportScale[viewportIndex]));
+    }
+
+    SubmitFilter filter = SUBMIT_ALL;
+    if (gViewCache && cache.enabled && viewportData.width > 0 && viewportData.height > 0) {
+        UpdateViewportCache(cache, viewportData, width, height, projViewMatrix);
+        cache.target.blitTo(viewportData.x, viewportData.y, framebuffer);
+        filter = SUBMIT_DYNAMIC;
+        gCachedViews++;
+    } else {
+        cache.valid = false;
+    }
+
+    // Register the viewport with the render queue
+    int view = gRenderQueue.addView(viewportData.x, viewportData.y, width, height,
+                                    projViewMatrix, viewportData.cam.getPosition(), gDepthPrepass[viewportIndex]);
+    gViewportView[viewportIndex] = view;
+    gRenderQueue.setViewStatsScope(view, viewportIndex);
+    gRenderQueue.setViewGpuZone(view, kViewportSceneGpuZones[viewportIndex]);
+    gRenderQueue.getOcclusionQueries().setHysteresis(view, gQueryHysteresis[viewportIndex]);
+
+    ViewportSubmission& submission = gViewportSubmissions[viewportIndex];
+    submission.active = true;
+    submission.view = view;
+    submission.projViewMatrix = projViewMatrix;
+    submission.width = width;
+    submission.height = height;
+    submission.filter = filter;
+}
+
+// Culls and submits a viewport prepared by RenderScene(); runs on any thread, never touches OpenGL
+static void SubmitViewport(int viewportIndex)
+{
+    PROFILE_ZONE(kSubmitViewportZones[viewportIndex]);
+    ViewportSubmission& submission = gViewportSubmissions[viewportIndex];
+    submission.stats = CullStats();
+    submission.occlusionTime = 0.0f;
+
+    // Rasterise the occluders as seen from this camera
+    OcclusionBuffer* occlusion = nullptr;
+    if (gOcclusionCulling) {
+        occlusion = &gOcclusionBuffers[viewportIndex];
+        occlusion->begin(submission.projViewMatrix, submission.width, submission.height);
+        for (size_t i = 0; i < gOccluders.size(); ++i)
+            occlusion->addOccluder(*gOccluders[i].mesh, gScene.getWorldMatrix(gOccluders[i].entity));
+        occlusion->rasterize(*gJobs);
+        submission.occlusionTime = occlusion->getRasterTime();
+    }
+
+    SubmitScene(gRenderQueue, submission.view, submission.projViewMatrix, submission.filter, submission.stats, occlusion);
+}
+
+
+
+
+// MARK: - Simulation Function
+// Rotations of the scene at a rotation angle
+static void ComputeSimulationState(float rotation, bool stressTest, SimulationState& state)
+{
+    // Spin the torus about the y-axis, and the extra lights around the room
+    state.torusRotation = glm::angleAxis(glm::radians(rotation * 5), glm::vec3(0.0f, 1.0f, 0.0f)) *
+                          glm::angleAxis(glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    state.extraLightRotation = glm::angleAxis(glm::radians(rotation), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    // Spin the stress test pivots, which moves all of their children
+    state.pivotRotations.clear();
+    if (stressTest)
+    {
+        for (int i = 0; i < kStressPivots; ++i)
+            state.pivotRotations.push_back(glm::angleAxis(glm::radians(rotation * (1.0f + i % 7)), glm::vec3(0.0f, 1.0f, 0.0f)));
+    }
+}
+
+// One simulation step: runs the fixed ticks covered by the elapsed time and publishes the last two.
+// Only touches simulation state and the snapshot it publishes, never the scene or GL
+static void SimulateScene(float seconds)
+{
+    PROFILE_ZONE("SimulateScene");
+
+    // Latest settings from the render thread
+    gSimulationInput.update();
+    const SimulationInput& input = gSimulationInput.front();
+
+    static float rotation = 0.0f;     // Current rotation angle
+    static uint64_t step = 0;
+    static uint64_t tick = 0;
+    static double accumulator = 0.0;  // Elapsed time not simulated yet
+    static float droppedSeconds = 0.0f;
+    static SimulationState previous;
+    static SimulationState current;
+
+    if (step == 0)
+    {
+        ComputeSimulationState(rotation, input.stressTest, current);
+        previous = current;
+    }
+
+    // Run whole ticks only; the remainder carries over to the next step
+    const double tickSeconds = 1.0 / std::max(1, input.tickRate);
+    accumulator += seconds;
+
+    int ticks = 0;
+    while (accumulator >= tickSeconds && ticks < input.maxTicksPerStep)
+    {
+        if (input.rotationEnabled)
+            rotation = std::fmod(rotation + rotationSpeed * static_cast<float>(tickSeconds), 360.0f);
+
+        std::swap(previous, current);
+        ComputeSimulationState(rotation, input.stressTest, current);
+
+        accumulator -= tickSeconds;
+        ticks++;
+        tick++;
+    }
+
+    // Too far behind (e.g. a hitch or a debugger break): drop whole ticks rather than spiral
+    if (accumulator >= tickSeconds)
+    {
+        double dropped = accumulator - std::fmod(accumulator, tickSeconds);
+        accumulator -= dropped;
+        droppedSeconds += static_cast<float>(dropped);
+    }
+
+    // The current tick stands for the time the accumulator has not covered yet, the previous one a tick earlier
+    uint64_t now = Profiler::now();
+    uint64_t remainder = static_cast<uint64_t>(accumulator * 1.0e9);
+    uint64_t tickNanoseconds = static_cast<uint64_t>(tickSeconds * 1.0e9);
+
+    SimulationSnapshot& snapshot = gSimulationSnapshots.back();
+    snapshot.step = ++step;
+    snapshot.tick = tick;
+    snapshot.ticks = ticks;
+    snapshot.previous = previous;
+    snapshot.current = current;
+    snapshot.rotating = previous.torusRotation != current.torusRotation
+                        || previous.pivotRotations != current.pivotRotations;
+    snapshot.stepTime = now;
+    snapshot.currentTickTime = now > remainder ? now - remainder : 0;
+    snapshot.previousTickTime = snapshot.currentTickTime > tickNanoseconds ? snapshot.currentTickTime - tickNanoseconds : 0;
+    snapshot.droppedSeconds = droppedSeconds;
+    snapshot.extraLights = input.extraLights;
+    gSimulationSnapshots.publish();
+}
+
+
+
+
+// MARK: - Scene Update Function
+// Takes the latest simulation snapshot and applies it to the scene
+static void UpdateScene(float frameSeconds)
+{
+    PROFILE_ZONE("UpdateScene");
+
+    // Hand the current settings to the simulation
+    SimulationInput& input = gSimulationInput.back();
+    input.rotationEnabled = rotationEnabled;
+    input.stressTest = gStressTest;
+    input.extraLights = gExtraLights;
+    input.tickRate = gTickRate;
+    input.maxTicksPerStep = gMaxTicksPerStep;
+    gSimulationInput.publish();
+
+    // Simulate the next frame on the simulation thread while this one renders, or right here
+    if (gThreadedSimulation != gSimulationThread.isRunning())
+    {
+        if (gThreadedSimulation)
+            gSimulationThread.start(SimulateScene);
+        else
+            gSimulationThread.stop();
+    }
+
+    bool newSnapshot = false;
+    if (gThreadedSimulation)
+    {
+        newSnapshot = gSimulationSnapshots.update();
+        if (newSnapshot)
+            gSimulationThread.frameConsumed();
+        gSimulationTime = gSimulationThread.getStepTime();
+    }
+    else
+    {
+        uint64_t start = Profiler::now();
+        SimulateScene(frameSeconds);
+        newSnapshot = gSimulationSnapshots.update();
+        gSimulationTime = (Profiler::now() - start) * 1.0e-6f;
+    }
+
+    const SimulationSnapshot& snapshot = gSimulationSnapshots.front();
+    gStepTicks = snapshot.ticks;
+    gDroppedTime = snapshot.droppedSeconds * 1000.0f;
+
+    // Show the scene between the last two ticks every frame; once they stop differing, settle on the latest one
+    static bool wasRotating = false;
+    bool applyRotations = snapshot.rotating || (newSnapshot && wasRotating);
+    if (newSnapshot)
+        wasRotating = snapshot.rotating;
+
+    // How far the render clock is past the current tick, so frames between ticks move on too. Without the
+    // thread the step ran just now for this frame, and its own time keeps fixed time step runs repeatable
+    float alpha = 1.0f;
+    if (gInterpolation && snapshot.rotating) {
+        uint64_t renderTime = gThreadedSimulation ? Profiler::now() : snapshot.stepTime;
+        uint64_t tickLength = snapshot.currentTickTime - snapshot.previousTickTime;
+        double sinceTick = renderTime > snapshot.currentTickTime ? static_cast<double>(renderTime - snapshot.currentTickTime) : 0.0;
+        if (tickLength > 0)
+            alpha = static_cast<float>(std::min(1.0, sinceTick / tickLength));
+    }
+    const SimulationState& previous = snapshot.previous;
+    const SimulationState& current = snapshot.current;
+
+    if (applyRotations)
+        gScene.setRotation(gTorusEntity, glm::slerp(previous.torusRotation, current.torusRotation, alpha));
+
+    if ((newSnapshot || applyRotations) && !current.pivotRotations.empty())
+    {
+        if (gStressPivots.empty())
+            SetupStressTest();
+
+        // The stress test may have started between the two ticks
+        bool interpolate = previous.pivotRotations.size() == current.pivotRotations.size();
+        for (size_t i = 0; i < gStressPivots.size() && i < current.pivotRotations.size(); ++i)
+            gScene.setRotation(gStressPivots[i], interpolate ? glm::slerp(previous.pivotRotations[i], current.pivotRotations[i], alpha)
+                                                             : current.pivotRotations[i]);
+    }
+
+    // Switch the requested number of extra lights on, and circle them around the room
+    static int activeExtraLights = 0;
+    if (snapshot.extraLights > 0 && gExtraLightPivot == kNoEntity)
+        SetupExtraLights();
+
+    if (snapshot.extraLights != activeExtraLights && gExtraLightPivot != kNoEntity)
+    {
+        activeExtraLights = snapshot.extraLights;
+        for (int i = 0; i < kMaxExtraLights; ++i)
+            gScene.getLight(1 + i).type = (i < activeExtraLights) ? 1 : 0;
+        gScene.invalidateLights();
+    }
+
+    if (applyRotations && gExtraLightPivot != kNoEntity)
+        gScene.setRotation(gExtraLightPivot, glm::slerp(previous.extraLightRotation, current.extraLightRotation, alpha));
+
+    // Propagate changed transforms to world matrices, bounds and lights
+    gScene.update();
+    gEntityCount = static_cast<int>(gScene.getEntityCount());
+    gSceneUpdateTime = gScene.getUpdateTime();
+
+    // Update camera yaw and pitch
+    ViewportNumber[3].cam.mYaw = gYaw;
+    ViewportNumber[3].cam.mPitch = gPitch;
+
+    // Update camera
+    ViewportNumber[3].cam.update(0.0f, 0.0f);
+}
+
+
+
+
+// MARK: - Rendering ViewPorts based on index
+void RenderViewports(int viewportIndex) {
+    auto& viewportData = ViewportNumber[viewportIndex];
+    
+    glViewport(viewportData.x, viewportData.y, viewportData.width, viewportData.height);
+
+    // Scene viewports only draw cached parts here, their queued draws are timed as "Viewport N Scene"
+    PROFILE_GPU(kViewportGpuZones[viewportIndex]);
+    RenderStatsScope statsScope(viewportIndex);
+
+    if (viewportIndex == 0) {
+        // Render GUI for viewport 0; there is no tweak bar without a window
+        if (!gHeadless) {
+            PROFILE_ZONE("TwDraw");
+            TwDraw();
+            // The tweak bar sets its own state behind the cache's back
+            GLState::invalidate();
+        }
+    } else {
+        // Submit scene for viewports 1, 2, and 3
+        RenderScene(viewportIndex);
+    }
+}
+
+
+
+
+// MARK: - Main Viewport Rendering
+void Render() {
+    PROFILE_ZONE("Render");
+
+    // Read back the GPU zones of an older frame and start timing this one; the resolution scaler needs the view times
+    GpuProfiler::setEnabled(gGpuProfiling || gDynamicResolution);
+    GpuProfiler::beginFrame();
+
+    // Clear colour buffer and depth buffer
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Reset culling statistics for this frame
+    gVisibleCount = 0;
+    gCulledCount = 0;
+    gOccludedCount = 0;
+    gOcclusionTime = 0.0f;
+    gCachedViews = 0;
+
+    // Count this frame's state calls
+    GLState::setFiltering(gStateFiltering);
+    GLState::resetCounters();
+
+    // Per-frame data goes into the next region of the ring buffer
+    gStreamBuffer.beginFrame();
+    gRenderQueue.setStreamBuffer(gStreaming ? &gStreamBuffer : nullptr);
+    gCacheQueue.setStreamBuffer(gStreaming ? &gStreamBuffer : nullptr);
+
+    // Bring the shadow map up to date before any viewport samples it
+    gShadowFacesRendered = 0;
+    if (gShadows) {
+        PROFILE_GPU("Shadow Map");
+        gShadowFacesRendered = gShadowMap.update(gScene.getLight(0), gScene, gShadowShader);
+        gShadowFaceUpdates += gShadowFacesRendered;
+    }
+
+    // Render 4 viewports
+    gRenderQueue.clear();
+    gRenderQueue.setLight(&gScene.getLight(0));
+    SetClusterLights(gRenderQueue);
+    gRenderQueue.setShadowMap(gShadows ? &gShadowMap : nullptr);
+    gRenderQueue.setMultiView(gMultiView && gMultiViewSupported);
+    gRenderQueue.setOcclusionQueries(gOcclusionQueries);
+    gRenderQueue.setJobSystem(gParallelRecording ? gJobs : nullptr);
+
+    // Scaled viewports (and their cached parts) go to the scene target, which must be cleared first
+    if (gDynamicResolution) {
+        gSceneTarget.resize(gWindowWidth, gWindowHeight);
+        gSceneTarget.bind();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        gViewportSubmissions[i].active = false;
+        RenderViewports(i);
+    }
+
+    // Cull and submit the scene viewports in parallel once all of them are added to the queue
+    JobCounter submissions;
+    for (int i = 1; i < 4; ++i) {
+        if (!gViewportSubmissions[i].active)
+            continue;
+        if (gParallelRecording)
+            gJobs->run([i] { SubmitViewport(i); }, &submissions);
+        else
+            SubmitViewport(i);
+    }
+    gJobs->wait(submissions);
+
+    for (int i = 1; i < 4; ++i) {
+        if (!gViewportSubmissions[i].active)
+            continue;
+        AddCullStats(gViewportSubmissions[i].stats);
+        gOcclusionTime += gViewportSubmissions[i].occlusionTime;
+    }
+
+    // Draw the scene viewports in state-sorted order
+    if (gDynamicResolution)
+        gSceneTarget.bind();
+    gRenderQueue.sort();
+    {
+        PROFILE_GPU("Scene Queue");
+        gRenderQueue.execute();
+    }
+    gRecordedCommands = static_cast<int>(gRenderQueue.getRecordedCommandCount());
+    gRecordTime = gRenderQueue.getRecordTime();
+
+    // Upscale the scene viewports into the window
+    if (gDynamicResolution) {
+        PROFILE_GPU("Upscale");
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        for (int i = 1; i < 4; ++i) {
+            const ViewportData& viewportData = ViewportNumber[i];
+            const RenderView& view = gRenderQueue.getView(gViewportView[i]);
+            gSceneTarget.blitColorTo(view.x, view.y, view.width, view.height,
+                                     viewportData.x, viewportData.y, viewportData.width, viewportData.height);
+        }
+    }
+
+    const OcclusionQueries& queries = gRenderQueue.getOcclusionQueries();
+    gQueryCount = queries.getQueryCount();
+    gQueryResults = queries.getResultCount();
+    gConditionalDraws = queries.getHiddenCount();
+    gDroppedQueries = queries.getDroppedCount();
+    gInsideQueries = queries.getInsideCount();
+
+    const LightClusters& clusters = gRenderQueue.getLightClusters();
+    gClusterLightCount = clusters.getActiveLightCount();
+    gClusterIndexCount = clusters.getIndexCount();
+    gClusterBuildTime = clusters.getBuildTime();
+
+    // GPU times arrive a few frames late
+    for (int i = 1; i < 4; ++i)
+        gViewportGpuTime[i] = gRenderQueue.getViewTime(gViewportView[i]);
+    gMultiViewGpuTime = gRenderQueue.getMultiViewTime();
+
+    // Pick the next resolution scales; views drawn in the multi-view pass share its time
+    int sharedViews = 0;
+    for (int i = 1; i < 4; ++i) {
+        if (gViewportGpuTime[i] <= 0.0f)
+            sharedViews++;
+    }
+    for (int i = 1; i < 4; ++i) {
+        ResolutionScaler& scaler = gResolutionScalers[i];
+        scaler.setBudget(gResolutionBudget / 3.0f);
+        scaler.setRange(gMinResolutionScale, 1.0f);
+
+        if (!gDynamicResolution) {
+            scaler.reset();
+        } else {
+            float gpuTime = gViewportGpuTime[i];
+            if (gpuTime <= 0.0f && sharedViews > 0)
+                gpuTime = gMultiViewGpuTime / sharedViews;
+            scaler.update(gpuTime);
+        }
+        gViewportScale[i] = scaler.getScale();
+    }
+
+    // Render the main viewport border
+    {
+        PROFILE_GPU("Viewport Border");
+        glViewport(0, 0, gWindowWidth, gWindowHeight); // Set the viewport to cover the entire window
+        gShader.use(); // Use the shader for rendering
+        glm::mat4 MVP(1.0f); // Identity matrix for MVP (no transformation)
+        gShader.setUniform("uMVPMatrix", MVP); // Set the MVP matrix uniform
+        viewportBorderModel.drawModel(GL_LINES); // Draw the viewport border model as lines
+    }
+
+    // Fence this frame's region of the ring buffer
+    gStreamBuffer.endFrame();
+    gStreamUsage = gStreamBuffer.getFrameUsage() / 1024.0f;
+    gStreamWaits = gStreamBuffer.getWaitCount();
+    gMaterialCount = gRenderQueue.getMaterialBuffer().getCount();
+    gGLCallsIssued = GLState::getIssuedCount();
+    gGLCallsSkipped = GLState::getSkippedCount();
+    gJobThreads = static_cast<int>(gJobs->getThreadCount());
+    gJobsRun = static_cast<int>(gJobs->getJobCount());
+    gJobsStolen = static_cast<int>(gJobs->getStealCount());
+    gJobs->resetCounters();
+
+    GpuProfiler::endFrame();
+    gGpuDroppedFrames = GpuProfiler::getDroppedFrames();
+
+    RenderStats::endFrame();
+    for (int s = 0; s < STAT_COUNT; ++s) {
+        RenderStat stat = static_cast<RenderStat>(s);
+        for (int scope = 0; scope < RenderStats::kScopeCount; ++scope)
+            gRenderStats[scope][s] = static_cast<int>(RenderStats::get(scope, stat));
+        gRenderStats[RenderStats::kScopeCount][s] = static_cast<int>(RenderStats::getTotal(stat));
+    }
+
+    glFlush();
+}
+
+
+
+
+static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	// close the window when the ESCAPE key is pressed
+	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+	{
+		// set flag to close the window
+		glfwSetWindowShouldClose(window, GL_TRUE);
+		return;
+	}
+
+	// write the profiler's trace when P is pressed
+	if (key == GLFW_KEY_P && action == GLFW_PRESS)
+	{
+		if (Profiler::exportChromeTrace(kTraceFile))
+			std::cout << "Trace written to " << kTraceFile << std::endl;
+		else
+			std::cerr << "Unable to write: " << kTraceFile << std::endl;
+	}
+}
+
+
+
+
+static void cursor_position_callback(GLFWwindow* window, double xpos, double ypos)
+{
+	// pass cursor position to tweak bar
+	TwEventMousePosGLFW(static_cast<int>(xpos), static_cast<int>(ypos));
+}
+
+
+
+
+static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+	// pass mouse button status to tweak bar
+	TwEventMouseButtonGLFW(button, action);
+}
+
+
+
+
+static void error_callback(int error, const char* description)
+{
+	std::cerr << description << std::endl;	// output error description
+}
+
+
+
+
+// MARK: - Window Size Manager
+static void macOS_HiDPI_WindowManager(GLFWwindow* window, int w, int h) {
+    // Get the size of the framebuffer to handle high-DPI displays.
+    int framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+    // Update global variables to reflect the framebuffer size.
+    gWindowWidth = framebufferWidth;
+    gWindowHeight = framebufferHeight;
+
+    // Update Viewport dimensions
+    ViewportNumber[0] = ViewportData(0, gWindowHeight / 2, gWindowWidth / 2, gWindowHeight / 2);
+    ViewportNumber[1] = ViewportData(gWindowWidth / 2, gWindowHeight / 2, gWindowWidth / 2, gWindowHeight / 2);
+    ViewportNumber[2] = ViewportData(0, 0, gWindowWidth / 2, gWindowHeight / 2);
+    ViewportNumber[3] = ViewportData(gWindowWidth / 2, 0, gWindowWidth / 2, gWindowHeight / 2);
+
+    // Recalculate scale for the orthographic projection based on the new window size
+    float scale1 = tanf(glm::radians(60.0f) / 2.0f) * CameraZoom ;
+    float scale2 = tanf(glm::radians(60.0f) / 2.0f) * 12.0f;
+    
+    float aspectRatio = static_cast<float>(framebufferWidth) / static_cast<float>(framebufferHeight);
+    float scaleWidth1 = scale1 * aspectRatio;
+    float scaleWidth2 = scale2 * aspectRatio;
+
+    glm::mat4 projMat = glm::ortho(-scaleWidth1, scaleWidth1, -scale1, scale1, 0.01f, 100.0f);
+    ViewportNumber[1].cam.setProjMatrix(projMat);
+    ViewportNumber[1].cam.setViewMatrix(glm::vec3(0.0f, CameraZoom , 0.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0, 0.0, -1.0));
+   
+    projMat = glm::ortho(-scaleWidth2, scaleWidth2, -scale2, scale2, 0.01f, 100.0f);
+    ViewportNumber[2].cam.setProjMatrix(projMat);
+    ViewportNumber[2].cam.setViewMatrix(glm::vec3(0.0f, 0.0f, 8.0f), glm::vec3(0.0f, 0.0f, 0.0f));
+   
+    projMat = glm::perspective(glm::radians(70.0f), aspectRatio, 0.1f, 100.0f);
+    ViewportNumber[3].cam.setProjMatrix(projMat);
+    ViewportNumber[3].cam.setViewMatrix(glm::vec3(0.0f, 0.0f, 7.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0, 1.0, 0.0));
+
+    // Update GUI size
+    TwWindowSize(gWindowWidth, gWindowHeight);
+}
+
+
+
+
+// MARK: - Frame Time Reporting
+// Records the CPU time of a frame and the GPU time of any frame read back since
+static void RecordFrameTimes(float cpuTime)
+{
+    static uint64_t gpuFramesRecorded = 0;
+
+    gCpuFrameTimes.setBudget(gFrameBudget);
+    gGpuFrameTimes.setBudget(gFrameBudget);
+
+    gCpuFrameTimes.record(cpuTime);
+    if (GpuProfiler::getFramesRead() != gpuFramesRecorded) {
+        gpuFramesRecorded = GpuProfiler::getFramesRead();
+        gGpuFrameTimes.record(GpuProfiler::getFrameTime());
+    }
+}
+
+static void UpdateFrameTimesUI()
+{
+    const double percentiles[4] = { 50.0, 90.0, 99.0, 99.9 };
+    const FrameTimeRecorder* recorders[2] = { &gCpuFrameTimes, &gGpuFrameTimes };
+
+    for (int r = 0; r < 2; ++r) {
+        for (int p = 0; p < 4; ++p)
+            gFrameTimePercentiles[r][p] = recorders[r]->getWindowPercentile(percentiles[p]);
+        gFrameTimePercentiles[r][4] = recorders[r]->getWindowMax();
+        gFrameHitches[r] = static_cast<int>(recorders[r]->getWindowHitchCount());
+    }
+}
+
+// Writes the distributions of the whole run and of the last window
+static void WriteFrameTimes()
+{
+    std::ofstream csv(kFrameTimesCsvFile);
+    FrameTimeRecorder::writeCsvHeader(csv);
+    gCpuFrameTimes.writeCsv(csv);
+    gGpuFrameTimes.writeCsv(csv);
+    if (csv)
+        std::cout << "Frame times written to " << kFrameTimesCsvFile << std::endl;
+    else
+        std::cerr << "Unable to write: " << kFrameTimesCsvFile << std::endl;
+
+    std::ofstream json(kFrameTimesJsonFile);
+    json << "{\"series\": [\n";
+    gCpuFrameTimes.writeJson(json);
+    json << ",\n";
+    gGpuFrameTimes.writeJson(json);
+    json << "\n]}\n";
+    if (json)
+        std::cout << "Frame times written to " << kFrameTimesJsonFile << std::endl;
+    else
+        std::cerr << "Unable to write: " << kFrameTimesJsonFile << std::endl;
+}
+
+
+
+
+// MARK: - GUI Interface
+static void TW_CALL ExportTrace(void* clientData)
+{
+    if (Profiler::exportChromeTrace(kTraceFile))
+        std::cout << "Trace written to " << kTraceFile << std::endl;
+    else
+        std::cerr << "Unable to write: " << kTraceFile << std::endl;
+}
+
+static void TW_CALL DumpRenderStats(void* clientData)
+{
+    if (RenderStats::writeJson(kRenderStatsFile))
+        std::cout << "Render statistics written to " << kRenderStatsFile << std::endl;
+    else
+        std::cerr << "Unable to write: " << kRenderStatsFile << std::endl;
+}
+
+// Totals in the 'Render Stats' group, each scope in a closed group nested in it
+static void AddRenderStatsUI(TwBar* twBar)
+{
+    const char* labels[STAT_COUNT] = { "Draw Calls", "Triangles", "Vertices", "Program Switches",
+                                       "VAO Binds", "Texture Binds", "Uniform Uploads", "Buffer Bytes" };
+
+    auto addStats = [&](int scope, const std::string& group) {
+        for (int s = 0; s < STAT_COUNT; ++s) {
+            std::string name = group + " " + labels[s];
+            std::string definition = " group='" + group + "' label='" + labels[s] + "' ";
+            TwAddVarRO(twBar, name.c_str(), TW_TYPE_INT32, &gRenderStats[scope][s], definition.c_str());
+        }
+    };
+
+    addStats(RenderStats::kScopeCount, "Render Stats");
+    TwAddButton(twBar, "Dump Render Stats", DumpRenderStats, nullptr, " group='Render Stats' label='Dump JSON' ");
+
+    for (int scope = 0; scope < RenderStats::kScopeCount; ++scope) {
+        std::string group = std::string(RenderStats::getScopeName(scope)) + " Stats";
+        addStats(scope, group);
+        TwDefine((" Main/'" + group + "' group='Render Stats' opened=false ").c_str());
+    }
+}
+
+// Adds zones seen for the first time to the profiler group and refreshes the breakdown
+static void UpdateProfilerUI(TwBar* twBar)
+{
+    size_t numZones = std::min(Profiler::getZoneCount(), static_cast<size_t>(kMaxProfilerZones));
+    for (; gProfilerZonesShown < numZones; ++gProfilerZonesShown) {
+        std::string label = std::string(Profiler::getZoneName(gProfilerZonesShown)) + " (ms)";
+        TwAddVarRO(twBar, label.c_str(), TW_TYPE_FLOAT, &gProfilerZoneTimes[gProfilerZonesShown], " group='Profiler' precision=3 ");
+    }
+
+    for (size_t i = 0; i < gProfilerZonesShown; ++i)
+        gProfilerZoneTimes[i] = Profiler::getZoneTime(i);
+}
+
+// Same for the GPU zones, labelled apart from CPU zones of the same name
+static void UpdateGpuProfilerUI(TwBar* twBar)
+{
+    size_t numZones = std::min(GpuProfiler::getZoneCount(), static_cast<size_t>(kMaxProfilerZones));
+    for (; gGpuZonesShown < numZones; ++gGpuZonesShown) {
+        std::string label = "GPU " + std::string(GpuProfiler::getZoneName(gGpuZonesShown)) + " (ms)";
+        TwAddVarRO(twBar, label.c_str(), TW_TYPE_FLOAT, &gGpuZoneTimes[gGpuZonesShown], " group='GPU Profiler' precision=3 ");
+    }
+
+    for (size_t i = 0; i < gGpuZonesShown; ++i)
+        gGpuZoneTimes[i] = GpuProfiler::getZoneTime(i);
+}
+
+static void TW_CALL SetLightPosition(const void* value, void* clientData)
+{
+    int axis = *static_cast<int*>(clientData);
+    glm::vec3 position = gScene.getPosition(gLightEntity);
+    position[axis] = *static_cast<const float*>(value);
+    gScene.setPosition(gLightEntity, position);
+}
+
+static void TW_CALL GetLightPosition(void* value, void* clientData)
+{
+    int axis = *static_cast<int*>(clientData);
+    *static_cast<float*>(value) = gScene.getPosition(gLightEntity)[axis];
+}
+
+TwBar* CreateUI(const std::string name)
+{
+	TwBar* twBar = TwNewBar(name.c_str());
+
+	TwWindowSize(gWindowWidth / 2, gWindowHeight);
+	TwDefine(" TW_HELP visible=false ");
+	TwDefine(" GLOBAL fontsize=3 ");
+
+	TwDefine(" Main label='Controls' refresh=0.02 text=light size='250 250' ");
+
+	TwAddVarRO(twBar, "FPS", TW_TYPE_FLOAT, &gFrameRate, " group='Frame Statistics' precision=2 ");
+	TwAddVarRO(twBar, "Frame Time", TW_TYPE_FLOAT, &gFrameTime, " group='Frame Statistics' ");
+	TwAddVarRW(twBar, "Frame Budget (ms)", TW_TYPE_FLOAT, &gFrameBudget, " group='Frame Statistics' min=1 max=1000 step=0.5 precision=3 ");
+	{
+		const char* series[2] = { "CPU", "GPU" };
+		const char* stats[5] = { "p50", "p90", "p99", "p99.9", "Max" };
+		for (int r = 0; r < 2; ++r) {
+			for (int p = 0; p < 5; ++p) {
+				std::string name = std::string(series[r]) + " " + stats[p] + " (ms)";
+				TwAddVarRO(twBar, name.c_str(), TW_TYPE_FLOAT, &gFrameTimePercentiles[r][p], " group='Frame Statistics' precision=3 ");
+			}
+			std::string name = std::string(series[r]) + " Hitches";
+			TwAddVarRO(twBar, name.c_str(), TW_TYPE_INT32, &gFrameHitches[r], " group='Frame Statistics' ");
+		}
+	}
+
+	TwAddVarRO(twBar, "Visible", TW_TYPE_INT32, &gVisibleCount, " group='Culling' ");
+	TwAddVarRO(twBar, "Culled", TW_TYPE_INT32, &gCulledCount, " group='Culling' ");
+	TwAddVarRW(twBar, "Occlusion Culling", TW_TYPE_BOOLCPP, &gOcclusionCulling, " group='Culling' ");
+	TwAddVarRO(twBar, "Occluded", TW_TYPE_INT32, &gOccludedCount, " group='Culling' ");
+	TwAddVarRO(twBar, "Rasterise (ms)", TW_TYPE_FLOAT, &gOcclusionTime, " group='Culling' precision=3 ");
+
+	TwAddVarRW(twBar, "Queries", TW_TYPE_BOOLCPP, &gOcclusionQueries, " group='Occlusion Queries' ");
+	TwAddVarRW(twBar, "Top Hysteresis", TW_TYPE_INT32, &gQueryHysteresis[1], " group='Occlusion Queries' min=1 max=60 ");
+	TwAddVarRW(twBar, "Front Hysteresis", TW_TYPE_INT32, &gQueryHysteresis[2], " group='Occlusion Queries' min=1 max=60 ");
+	TwAddVarRW(twBar, "Perspective Hysteresis", TW_TYPE_INT32, &gQueryHysteresis[3], " group='Occlusion Queries' min=1 max=60 ");
+	TwAddVarRO(twBar, "Issued", TW_TYPE_INT32, &gQueryCount, " group='Occlusion Queries' ");
+	TwAddVarRO(twBar, "Results", TW_TYPE_INT32, &gQueryResults, " group='Occlusion Queries' ");
+	TwAddVarRO(twBar, "Conditional Draws", TW_TYPE_INT32, &gConditionalDraws, " group='Occlusion Queries' ");
+	TwAddVarRO(twBar, "Dropped", TW_TYPE_INT32, &gDroppedQueries, " group='Occlusion Queries' ");
+	TwAddVarRO(twBar, "Viewpoint Inside", TW_TYPE_INT32, &gInsideQueries, " group='Occlusion Queries' ");
+
+	TwAddVarRW(twBar, "Toggle", TW_TYPE_BOOLCPP, &rotationEnabled, " group='Animation' ");
+	TwAddVarRW(twBar, "Simulation Thread", TW_TYPE_BOOLCPP, &gThreadedSimulation, " group='Animation' ");
+	TwAddVarRO(twBar, "Simulation (ms)", TW_TYPE_FLOAT, &gSimulationTime, " group='Animation' precision=3 ");
+	TwAddVarRW(twBar, "Tick Rate (Hz)", TW_TYPE_INT32, &gTickRate, " group='Animation' min=1 max=1000 ");
+	TwAddVarRW(twBar, "Max Catch-Up Ticks", TW_TYPE_INT32, &gMaxTicksPerStep, " group='Animation' min=1 max=64 ");
+	TwAddVarRW(twBar, "Interpolation", TW_TYPE_BOOLCPP, &gInterpolation, " group='Animation' ");
+	TwAddVarRO(twBar, "Ticks per Step", TW_TYPE_INT32, &gStepTicks, " group='Animation' ");
+	TwAddVarRO(twBar, "Dropped (ms)", TW_TYPE_FLOAT, &gDroppedTime, " group='Animation' precision=1 ");
+
+	// the light follows its entity, so edits go through the scene
+	static int axes[3] = { 0, 1, 2 };
+	TwAddVarCB(twBar, "Position X", TW_TYPE_FLOAT, SetLightPosition, GetLightPosition, &axes[0], " group='Light' step=0.01 ");
+	TwAddVarCB(twBar, "Position Y", TW_TYPE_FLOAT, SetLightPosition, GetLightPosition, &axes[1], " group='Light' step=0.01 ");
+	TwAddVarCB(twBar, "Position Z", TW_TYPE_FLOAT, SetLightPosition, GetLightPosition, &axes[2], " group='Light' step=0.01");
+
+	TwAddVarRO(twBar, "Entities", TW_TYPE_INT32, &gEntityCount, " group='Scene' ");
+	TwAddVarRO(twBar, "Update (ms)", TW_TYPE_FLOAT, &gSceneUpdateTime, " group='Scene' precision=3 ");
+	TwAddVarRW(twBar, "Stress Test", TW_TYPE_BOOLCPP, &gStressTest, " group='Scene' ");
+	TwAddVarRO(twBar, "Job Threads", TW_TYPE_INT32, &gJobThreads, " group='Scene' ");
+	TwAddVarRO(twBar, "Jobs", TW_TYPE_INT32, &gJobsRun, " group='Scene' ");
+	TwAddVarRO(twBar, "Stolen Jobs", TW_TYPE_INT32, &gJobsStolen, " group='Scene' ");
+
+	if (gMultiViewSupported)
+		TwAddVarRW(twBar, "Multi-View", TW_TYPE_BOOLCPP, &gMultiView, " group='Rendering' ");
+	TwAddVarRW(twBar, "View Cache", TW_TYPE_BOOLCPP, &gViewCache, " group='Rendering' ");
+	TwAddVarRO(twBar, "Cached Views", TW_TYPE_INT32, &gCachedViews, " group='Rendering' ");
+	TwAddVarRO(twBar, "Cache Updates", TW_TYPE_INT32, &gCacheUpdates, " group='Rendering' ");
+	TwAddVarRW(twBar, "Stream Buffer", TW_TYPE_BOOLCPP, &gStreaming, " group='Rendering' ");
+	TwAddVarRO(twBar, "Streamed (KB)", TW_TYPE_FLOAT, &gStreamUsage, " group='Rendering' precision=1 ");
+	TwAddVarRO(twBar, "Stream Waits", TW_TYPE_INT32, &gStreamWaits, " group='Rendering' ");
+	TwAddVarRO(twBar, "Materials", TW_TYPE_INT32, &gMaterialCount, " group='Rendering' ");
+	TwAddVarRW(twBar, "Parallel Recording", TW_TYPE_BOOLCPP, &gParallelRecording, " group='Rendering' ");
+	TwAddVarRO(twBar, "Commands", TW_TYPE_INT32, &gRecordedCommands, " group='Rendering' ");
+	TwAddVarRO(twBar, "Record (ms)", TW_TYPE_FLOAT, &gRecordTime, " group='Rendering' precision=3 ");
+	TwAddVarRW(twBar, "Filter State", TW_TYPE_BOOLCPP, &gStateFiltering, " group='GL State' ");
+	TwAddVarRO(twBar, "Calls Issued", TW_TYPE_INT32, &gGLCallsIssued, " group='GL State' ");
+	TwAddVarRO(twBar, "Calls Skipped", TW_TYPE_INT32, &gGLCallsSkipped, " group='GL State' ");
+
+	TwAddVarRW(twBar, "Top Pre-Pass", TW_TYPE_BOOLCPP, &gDepthPrepass[1], " group='Depth Pre-Pass' ");
+	TwAddVarRW(twBar, "Front Pre-Pass", TW_TYPE_BOOLCPP, &gDepthPrepass[2], " group='Depth Pre-Pass' ");
+	TwAddVarRW(twBar, "Perspective Pre-Pass", TW_TYPE_BOOLCPP, &gDepthPrepass[3], " group='Depth Pre-Pass' ");
+	TwAddVarRO(twBar, "Top GPU (ms)", TW_TYPE_FLOAT, &gViewportGpuTime[1], " group='Depth Pre-Pass' precision=3 ");
+	TwAddVarRO(twBar, "Front GPU (ms)", TW_TYPE_FLOAT, &gViewportGpuTime[2], " group='Depth Pre-Pass' precision=3 ");
+	TwAddVarRO(twBar, "Perspective GPU (ms)", TW_TYPE_FLOAT, &gViewportGpuTime[3], " group='Depth Pre-Pass' precision=3 ");
+	TwAddVarRO(twBar, "Multi-View GPU (ms)", TW_TYPE_FLOAT, &gMultiViewGpuTime, " group='Depth Pre-Pass' precision=3 ");
+
+	TwAddVarRW(twBar, "Dynamic Resolution", TW_TYPE_BOOLCPP, &gDynamicResolution, " group='Resolution' ");
+	TwAddVarRW(twBar, "GPU Budget (ms)", TW_TYPE_FLOAT, &gResolutionBudget, " group='Resolution' min=0.5 max=50 step=0.5 ");
+	TwAddVarRW(twBar, "Min Scale", TW_TYPE_FLOAT, &gMinResolutionScale, " group='Resolution' min=0.25 max=1 step=0.05 ");
+	TwAddVarRO(twBar, "Top Scale", TW_TYPE_FLOAT, &gViewportScale[1], " group='Resolution' precision=2 ");
+	TwAddVarRO(twBar, "Front Scale", TW_TYPE_FLOAT, &gViewportScale[2], " group='Resolution' precision=2 ");
+	TwAddVarRO(twBar, "Perspective Scale", TW_TYPE_FLOAT, &gViewportScale[3], " group='Resolution' precision=2 ");
+
+	TwAddVarRW(twBar, "Extra Lights", TW_TYPE_INT32, &gExtraLights, " group='Clustered Lights' min=0 max=512 step=16 ");
+	TwAddVarRO(twBar, "Active Lights", TW_TYPE_INT32, &gClusterLightCount, " group='Clustered Lights' ");
+	TwAddVarRO(twBar, "Light Indices", TW_TYPE_INT32, &gClusterIndexCount, " group='Clustered Lights' ");
+	TwAddVarRO(twBar, "Assign (ms)", TW_TYPE_FLOAT, &gClusterBuildTime, " group='Clustered Lights' precision=3 ");
+
+	TwAddVarRW(twBar, "Shadows", TW_TYPE_BOOLCPP, &gShadows, " group='Shadows' ");
+	TwAddVarRO(twBar, "Faces Rendered", TW_TYPE_INT32, &gShadowFacesRendered, " group='Shadows' ");
+	TwAddVarRO(twBar, "Face Updates", TW_TYPE_INT32, &gShadowFaceUpdates, " group='Shadows' ");
+
+	TwAddVarRW(twBar, "Profiling", TW_TYPE_BOOLCPP, &gProfiling, " group='Profiler' ");
+	TwAddButton(twBar, "Export Trace", ExportTrace, nullptr, " group='Profiler' ");
+
+	TwAddVarRW(twBar, "GPU Profiling", TW_TYPE_BOOLCPP, &gGpuProfiling, " group='GPU Profiler' ");
+	TwAddVarRO(twBar, "GPU Dropped Frames", TW_TYPE_INT32, &gGpuDroppedFrames, " group='GPU Profiler' ");
+
+	AddRenderStatsUI(twBar);
+
+	TwAddVarRW(twBar, "Yaw", TW_TYPE_FLOAT, &gYaw, " group='Camera' step=0.01");
+	TwAddVarRW(twBar, "Pitch", TW_TYPE_FLOAT, &gPitch, " group='Camera' step=0.01");
+
+	return twBar;
+}
+
+
+
+
+// MARK: - Headless Benchmark
+// Camera and light of a benchmark frame, the same on every run
+static void ScriptBenchmarkFrame(int frame)
+{
+    float t = frame / 60.0f;
+    gYaw = 0.6f * sinf(t * 0.5f);
+    gPitch = 0.25f * sinf(t * 0.3f);
+    gScene.setPosition(gLightEntity, glm::vec3(3.0f * cosf(t), 3.0f, 3.0f * sinf(t)));
+}
+
+// A glGetString() value, empty if the context has none
+static std::string GLString(GLenum name)
+{
+    const GLubyte* text = glGetString(name);
+    return text ? reinterpret_cast<const char*>(text) : "";
+}
+
+// FNV-1a hash of the pixels of the default framebuffer
+static uint64_t FramebufferChecksum(int width, int height)
+{
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        hash ^= pixels[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Renders numFrames frames into the current headless context with a fixed time step, and writes timings,
+// statistics and a checksum of the final frame to reportFile
+static int RunBenchmark(int numFrames, const std::string& reportFile)
+{
+    // Core profile entry points are only all loaded in experimental mode
+    glewExperimental = GL_TRUE;
+    GLenum glewResult = glewInit();
+    glGetError(); // glewInit() may leave GL_INVALID_ENUM behind on a core profile
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // GLEW built for GLX loads the GL functions, then misses the X display an EGL context does not need
+    if (glewResult == GLEW_ERROR_NO_GLX_DISPLAY)
+        glewResult = GLEW_OK;
+#endif
+    if (glewResult != GLEW_OK)
+    {
+        std::cerr << "GLEW initialisation failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Settings that would make the frames depend on timing rather than on the script
+    gHeadless = true;
+    gThreadedSimulation = false;
+    gDynamicResolution = false;
+
+    init(gWindowWidth, gWindowHeight);
+
+    const float frameSeconds = 1.0f / 60.0f;
+    uint64_t start = Profiler::now();
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        uint64_t frameStart = Profiler::now();
+        {
+            PROFILE_ZONE("Frame");
+            ScriptBenchmarkFrame(frame);
+            UpdateScene(frameSeconds);
+            Render();
+        }
+        RecordFrameTimes((Profiler::now() - frameStart) * 1.0e-6f);
+        Profiler::endFrame();
+    }
+    glFinish();
+    double seconds = (Profiler::now() - start) * 1.0e-9;
+    uint64_t checksum = FramebufferChecksum(gWindowWidth, gWindowHeight);
+
+    std::ofstream out(reportFile);
+    out << std::fixed << std::setprecision(3);
+    out << "{\n\"frames\": " << numFrames << ",\n\"width\": " << gWindowWidth << ",\n\"height\": " << gWindowHeight;
+    out << ",\n\"renderer\": ";
+    Profiler::writeJsonString(out, GLString(GL_RENDERER));
+    out << ",\n\"version\": ";
+    Profiler::writeJsonString(out, GLString(GL_VERSION));
+    out << ",\n\"seconds\": " << seconds << ",\n\"framesPerSecond\": " << (seconds > 0.0 ? numFrames / seconds : 0.0);
+
+    out << ",\n\"frameTimes\": [\n";
+    gCpuFrameTimes.writeJson(out);
+    out << ",\n";
+    gGpuFrameTimes.writeJson(out);
+    out << "\n],\n\"renderStats\": ";
+    RenderStats::writeJson(out);
+
+    // Average ms per frame over the last frames
+    out << ",\n\"cpuZones\": {";
+    for (size_t i = 0; i < Profiler::getZoneCount(); ++i) {
+        out << (i > 0 ? ", " : "");
+        Profiler::writeJsonString(out, Profiler::getZoneName(i));
+        out << ": " << Profiler::getZoneTime(i);
+    }
+    out << "},\n\"gpuZones\": {";
+    for (size_t i = 0; i < GpuProfiler::getZoneCount(); ++i) {
+        out << (i > 0 ? ", " : "");
+        Profiler::writeJsonString(out, GpuProfiler::getZoneName(i));
+        out << ": " << GpuProfiler::getZoneTime(i);
+    }
+
+    out << "},\n\"checksum\": \"" << std::hex << std::setw(16) << std::setfill('0') << checksum << "\"\n}\n";
+    if (!out)
+    {
+        std::cerr << "Unable to write: " << reportFile << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Benchmark report written to " << reportFile << std::endl;
+    return EXIT_SUCCESS;
+}
+
+
+
+
+// MARK: - Main function
+// Stops the simulation thread and writes the frame time reports, with the GL context still current
+static void Shutdown()
+{
+    gSimulationThread.stop();
+    WriteFrameTimes();
+}
+
+int main(int argc, char** argv)
+{
+    // Job system microbenchmarks, no window needed
+    if (argc > 1 && std::string(argv[1]) == "--bench-jobs")
+    {
+        RunJobBenchmarks(std::cout);
+        return EXIT_SUCCESS;
+    }
+
+    // Worker threads start here rather than during static initialisation, and are joined when main returns
+    JobSystem jobs;
+    gJobs = &jobs;
+    gScene.setJobSystem(gJobs);
+
+    // Rendering benchmark without a window: --bench [frames] [report file]
+    if (argc > 1 && std::string(argv[1]) == "--bench")
+    {
+        int numFrames = argc > 2 ? std::max(1, atoi(argv[2])) : kBenchmarkFrames;
+        std::string reportFile = argc > 3 ? argv[3] : kBenchmarkReportFile;
+
+        Profiler::setThreadName("Main");
+        HeadlessContext context;
+        if (!context.create(gWindowWidth, gWindowHeight))
+            return EXIT_FAILURE;
+
+        int result = RunBenchmark(numFrames, reportFile);
+
+        // The same shutdown as a windowed run, before the context goes
+        Shutdown();
+        context.destroy();
+        return result;
+    }
+
+    GLFWwindow* window = nullptr;
+
+    Profiler::setThreadName("Main");
+    glfwSetErrorCallback(error_callback);
+
+    if (!glfwInit())
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    // minimum OpenGL version 3.3
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // depth/stencil format of the offscreen viewport caches, so their depth can be blitted
+    glfwWindowHint(GLFW_DEPTH_BITS, 24);
+    glfwWindowHint(GLFW_STENCIL_BITS, 8);
+
+    window = glfwCreateWindow(gWindowWidth, gWindowHeight, "Assignment 2 - abah609, 7571562", nullptr, nullptr);
+
+    if (window == nullptr)
+    {
+        glfwTerminate();
+        exit(EXIT_FAILURE);
+    }
+
+    glfwMakeContextCurrent(window);
+    int framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    glViewport(0, 0, framebufferWidth, framebufferHeight);
+
+    glfwSwapInterval(1);
+
+    // Core profile entry points are only all loaded in experimental mode
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK)
+    {
+        std::cerr << "GLEW initialisation failed" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    glGetError(); // glewInit() may leave GL_INVALID_ENUM behind on a core profile
+
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetCursorPosCallback(window, cursor_position_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetWindowSizeCallback(window, macOS_HiDPI_WindowManager);
+
+    init(framebufferWidth, framebufferHeight);
+
+    TwInit(TW_OPENGL_CORE, nullptr);
+    TwBar* tweakBar = CreateUI("Main");
+
+
+    double lastUpdateTime = glfwGetTime();
+    double elapsedTime = lastUpdateTime;
+    int frameCount = 0;
+
+
+    // Leave hitches to frames that miss a refresh by a good margin, not to vsync jitter
+    const GLFWvidmode* videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+    if (videoMode != nullptr && videoMode->refreshRate > 0)
+        gFrameBudget = 1.5f * 1000.0f / videoMode->refreshRate;
+
+    double lastFrameTime = glfwGetTime();
+    while (!glfwWindowShouldClose(window))
+    {
+        float cpuTime = 0.0f;
+        {
+            PROFILE_ZONE("Frame");
+            uint64_t frameStart = Profiler::now();
+
+            // Calculate time elapsed since last frame
+            double currentFrameTime = glfwGetTime();
+            UpdateScene(static_cast<float>(currentFrameTime - lastFrameTime));
+            lastFrameTime = currentFrameTime;
+
+            Render();
+
+            // The swap waits for vsync, which is not CPU work of the frame
+            cpuTime = (Profiler::now() - frameStart) * 1.0e-6f;
+
+            {
+                PROFILE_ZONE("SwapBuffers");
+                glfwSwapBuffers(window);
+            }
+            glfwPollEvents();
+        }
+        RecordFrameTimes(cpuTime);
+
+        // Fold this frame's zones into the breakdown
+        Profiler::setEnabled(gProfiling);
+        Profiler::endFrame();
+        UpdateProfilerUI(tweakBar);
+        UpdateGpuProfilerUI(tweakBar);
+
+        frameCount++;
+        elapsedTime = glfwGetTime() - lastUpdateTime;
+
+        // if elapsed time since last update > 1 second
+        if (elapsedTime > 1.0)
+        {
+            gFrameTime = elapsedTime / frameCount;  // average time per frame
+            gFrameRate = 1 / gFrameTime;            // frames per second
+            lastUpdateTime = glfwGetTime();         // set last update time to current time
+            frameCount = 0;                         // reset frame counter
+            UpdateFrameTimesUI();                   // percentiles of the sliding windows
+        }
+    }
+    
+
+    Shutdown();
+
+    TwDeleteBar(tweakBar);
+    TwTerminate();
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+
+    
+    
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+#include "MaterialBuffer.h"
+#include "GLState.h"
+#include "RenderStats.h"
+
+#include <algorithm>
+
+MaterialBuffer::MaterialBuffer()
+{}
+
+MaterialBuffer::~MaterialBuffer()
+{
+	if (mTexture != 0)
+	{
+		glDeleteTextures(1, &mTexture);
+		GLState::textureDeleted(mTexture);
+	}
+	if (mBuffer != 0)
+		glDeleteBuffers(1, &mBuffer);
+}
+
+int MaterialBuffer::add(const Material& material)
+{
+	// few materials exist, a linear search is cheaper than hashing them
+	for (size_t i = 0; i < mMaterials.size(); i++)
+	{
+		const Material& other = mMaterials[i];
+		if (other.Ka == material.Ka && other.Kd == material.Kd && other.Ks == material.Ks
+			&& other.emission == material.emission && other.shininess == material.shininess)
+			return static_cast<int>(i);
+	}
+
+	mMaterials.push_back(material);
+	mData.push_back(glm::vec4(material.Ka, material.shininess));
+	mData.push_back(glm::vec4(material.Kd, 0.0f));
+	mData.push_back(glm::vec4(material.Ks, 0.0f));
+	mData.push_back(glm::vec4(material.emission, 0.0f));
+	mDirty = true;
+
+	return static_cast<int>(mMaterials.size()) - 1;
+}
+
+void MaterialBuffer::clear()
+{
+	mMaterials.clear();
+	mData.clear();
+	mDirty = true;
+}
+
+void MaterialBuffer::bind()
+{
+	if (mBuffer == 0)
+	{
+		glGenBuffers(1, &mBuffer);
+		glBindBuffer(GL_TEXTURE_BUFFER, mBuffer);
+		glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::vec4), nullptr, GL_STATIC_DRAW);
+		glGenTextures(1, &mTexture);
+		GLState::bindTexture(kTextureUnit, GL_TEXTURE_BUFFER, mTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, mBuffer);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
+
+	// materials only change when meshes are set up, so the buffer is rarely respecified
+	if (mDirty)
+	{
+		mDirty = false;
+		glBindBuffer(GL_TEXTURE_BUFFER, mBuffer);
+		glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::vec4) * std::max(mData.size(), static_cast<size_t>(1)),
+			mData.empty() ? nullptr : mData.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		RenderStats::add(STAT_BUFFER_BYTES, sizeof(glm::vec4) * mData.size());
+	}
+
+	GLState::bindTexture(kTextureUnit, GL_TEXTURE_BUFFER, mTexture);
+}
+
+void MaterialBuffer::setUniforms(ShaderProgram& program)
+{
+	program.setUniform("uMaterials", kTextureUnit);
+}
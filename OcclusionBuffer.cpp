@@ -0,0 +1,331 @@
+#include "OcclusionBuffer.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OCCLUSION_SSE
+#endif
+
+// triangles smaller than this (in squared pixels) cannot cover a pixel centre reliably
+static const float kMinArea = 1e-4f;
+
+OcclusionBuffer::OcclusionBuffer()
+{}
+
+OcclusionBuffer::~OcclusionBuffer()
+{}
+
+void OcclusionBuffer::begin(const glm::mat4& projViewMatrix, int viewportWidth, int viewportHeight)
+{
+	mStartTime = std::chrono::steady_clock::now();
+	mProjViewMatrix = projViewMatrix;
+	mTriangles.clear();
+
+	// width and height are multiples of the block size, so SSE rows never straddle the edge
+	int width = std::min(kMaxWidth, (std::max(viewportWidth, 1) + kBlockSize - 1) / kBlockSize * kBlockSize);
+	int height = static_cast<int>(std::ceil(static_cast<float>(width) * std::max(viewportHeight, 1) / std::max(viewportWidth, 1)));
+	height = std::min(kMaxWidth, std::max(kBlockSize, (height + kBlockSize - 1) / kBlockSize * kBlockSize));
+
+	if (width != mWidth || height != mHeight)
+	{
+		mWidth = width;
+		mHeight = height;
+		mTilesX = (mWidth + kTileSize - 1) / kTileSize;
+		mTilesY = (mHeight + kTileSize - 1) / kTileSize;
+		mBlocksX = mWidth / kBlockSize;
+		mBlocksY = mHeight / kBlockSize;
+
+		mDepth.resize(mWidth * mHeight);
+		mHiZ.resize(mBlocksX * mBlocksY);
+		mBins.resize(mTilesX * mTilesY);
+	}
+
+	for (size_t i = 0; i < mBins.size(); i++)
+		mBins[i].clear();
+}
+
+void OcclusionBuffer::addOccluder(const OccluderMesh& mesh, const glm::mat4& modelMatrix)
+{
+	glm::mat4 matrix = mProjViewMatrix * modelMatrix;
+
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		glm::vec4 c0 = matrix * glm::vec4(mesh.positions[mesh.indices[i]], 1.0f);
+		glm::vec4 c1 = matrix * glm::vec4(mesh.positions[mesh.indices[i + 1]], 1.0f);
+		glm::vec4 c2 = matrix * glm::vec4(mesh.positions[mesh.indices[i + 2]], 1.0f);
+		addTriangle(c0, c1, c2);
+	}
+}
+
+void OcclusionBuffer::addTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2)
+{
+	// clip against the near plane (z >= -w), which turns the triangle into at most a quad
+	const glm::vec4 input[3] = { c0, c1, c2 };
+	glm::vec4 polygon[4];
+	int count = 0;
+
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec4& a = input[i];
+		const glm::vec4& b = input[(i + 1) % 3];
+		float distA = a.z + a.w;
+		float distB = b.z + b.w;
+
+		if (distA >= 0.0f)
+			polygon[count++] = a;
+		if ((distA >= 0.0f) != (distB >= 0.0f))
+			polygon[count++] = a + (b - a) * (distA / (distA - distB));
+	}
+
+	if (count < 3)
+		return;
+
+	// to pixels, with depth from 0 to 1
+	glm::vec3 screen[4];
+	for (int i = 0; i < count; i++)
+	{
+		glm::vec3 ndc = glm::vec3(polygon[i]) / polygon[i].w;
+		screen[i] = glm::vec3((ndc.x * 0.5f + 0.5f) * mWidth, (ndc.y * 0.5f + 0.5f) * mHeight, ndc.z * 0.5f + 0.5f);
+	}
+
+	setupTriangle(screen[0], screen[1], screen[2]);
+	if (count == 4)
+		setupTriangle(screen[0], screen[2], screen[3]);
+}
+
+void OcclusionBuffer::setupTriangle(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+{
+	float area = (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+	if (std::fabs(area) < kMinArea)
+		return;
+
+	// counter-clockwise order, so that the inside of every edge is positive
+	const glm::vec3* v[3] = { &p0, &p1, &p2 };
+	if (area < 0.0f)
+	{
+		std::swap(v[1], v[2]);
+		area = -area;
+	}
+
+	Triangle triangle;
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec3& a = *v[i];
+		const glm::vec3& b = *v[(i + 1) % 3];
+		triangle.edgeA[i] = a.y - b.y;
+		triangle.edgeB[i] = b.x - a.x;
+		triangle.edgeC[i] = -(triangle.edgeA[i] * a.x + triangle.edgeB[i] * a.y);
+	}
+
+	// depth is linear in screen space after the perspective divide
+	glm::vec3 d1 = *v[1] - *v[0];
+	glm::vec3 d2 = *v[2] - *v[0];
+	triangle.depthA = (d1.z * d2.y - d2.z * d1.y) / area;
+	triangle.depthB = (d2.z * d1.x - d1.z * d2.x) / area;
+	triangle.depthC = v[0]->z - triangle.depthA * v[0]->x - triangle.depthB * v[0]->y;
+
+	float minX = std::min(p0.x, std::min(p1.x, p2.x));
+	float minY = std::min(p0.y, std::min(p1.y, p2.y));
+	float maxX = std::max(p0.x, std::max(p1.x, p2.x));
+	float maxY = std::max(p0.y, std::max(p1.y, p2.y));
+	if (maxX < 0.0f || maxY < 0.0f || minX > mWidth || minY > mHeight)
+		return;
+
+	triangle.minX = std::max(0, static_cast<int>(std::floor(minX)));
+	triangle.minY = std::max(0, static_cast<int>(std::floor(minY)));
+	triangle.maxX = std::min(mWidth - 1, static_cast<int>(std::ceil(maxX)));
+	triangle.maxY = std::min(mHeight - 1, static_cast<int>(std::ceil(maxY)));
+
+	// bin into every tile the bounds touch
+	uint32_t index = static_cast<uint32_t>(mTriangles.size());
+	mTriangles.push_back(triangle);
+
+	for (int tileY = triangle.minY / kTileSize; tileY <= triangle.maxY / kTileSize; tileY++)
+		for (int tileX = triangle.minX / kTileSize; tileX <= triangle.maxX / kTileSize; tileX++)
+			mBins[tileY * mTilesX + tileX].push_back(index);
+}
+
+void OcclusionBuffer::rasterize(JobSystem& jobs)
+{
+	PROFILE_ZONE("OcclusionBuffer::rasterize");
+	jobs.parallelFor(mTilesX * mTilesY, 1, [this](size_t begin, size_t end)
+	{
+		for (size_t tile = begin; tile < end; tile++)
+			rasterizeTile(static_cast<int>(tile % mTilesX), static_cast<int>(tile / mTilesX));
+	});
+
+	std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - mStartTime;
+	mRasterTime = elapsed.count();
+}
+
+void OcclusionBuffer::rasterizeTile(int tileX, int tileY)
+{
+	const int x0 = tileX * kTileSize;
+	const int y0 = tileY * kTileSize;
+	const int x1 = std::min(x0 + kTileSize, mWidth);
+	const int y1 = std::min(y0 + kTileSize, mHeight);
+
+	for (int y = y0; y < y1; y++)
+		std::fill(mDepth.begin() + y * mWidth + x0, mDepth.begin() + y * mWidth + x1, 1.0f);
+
+	const std::vector<uint32_t>& bin = mBins[tileY * mTilesX + tileX];
+	for (size_t i = 0; i < bin.size(); i++)
+	{
+		const Triangle& t = mTriangles[bin[i]];
+
+		// rows start on a multiple of 4 so that 4 pixels are always inside the tile
+		int minX = std::max(t.minX, x0) & ~3;
+		int maxX = std::min(t.maxX, x1 - 1);
+		int minY = std::max(t.minY, y0);
+		int maxY = std::min(t.maxY, y1 - 1);
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			float* row = &mDepth[y * mWidth];
+			float py = y + 0.5f;
+
+#if defined(OCCLUSION_SSE)
+			__m128 px = _mm_add_ps(_mm_set1_ps(minX + 0.5f), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+			__m128 zero = _mm_setzero_ps();
+
+			__m128 edge[3], edgeStep[3];
+			for (int e = 0; e < 3; e++)
+			{
+				edge[e] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.edgeA[e]), px), _mm_set1_ps(t.edgeB[e] * py + t.edgeC[e]));
+				edgeStep[e] = _mm_set1_ps(t.edgeA[e] * 4.0f);
+			}
+			__m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.depthA), px), _mm_set1_ps(t.depthB * py + t.depthC));
+			__m128 depthStep = _mm_set1_ps(t.depthA * 4.0f);
+
+			for (int x = minX; x <= maxX; x += 4)
+			{
+				__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge[0], zero), _mm_cmpge_ps(edge[1], zero)),
+					_mm_cmpge_ps(edge[2], zero));
+
+				if (_mm_movemask_ps(inside))
+				{
+					// keep the nearest depth where the triangle covers the pixel centre
+					__m128 current = _mm_loadu_ps(row + x);
+					__m128 nearest = _mm_min_ps(current, depth);
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+				}
+
+				for (int e = 0; e < 3; e++)
+					edge[e] = _mm_add_ps(edge[e], edgeStep[e]);
+				depth = _mm_add_ps(depth, depthStep);
+			}
+#else
+			for (int x = minX; x <= maxX; x++)
+			{
+				float px = x + 0.5f;
+				bool inside = true;
+				for (int e = 0; e < 3 && inside; e++)
+					inside = t.edgeA[e] * px + t.edgeB[e] * py + t.edgeC[e] >= 0.0f;
+
+				if (inside)
+					row[x] = std::min(row[x], t.depthA * px + t.depthB * py + t.depthC);
+			}
+#endif
+		}
+	}
+
+	// farthest depth of every block in the tile
+	for (int blockY = y0 / kBlockSize; blockY < y1 / kBlockSize; blockY++)
+	{
+		for (int blockX = x0 / kBlockSize; blockX < x1 / kBlockSize; blockX++)
+		{
+			const float* block = &mDepth[blockY * kBlockSize * mWidth + blockX * kBlockSize];
+
+#if defined(OCCLUSION_SSE)
+			__m128 farthest = _mm_setzero_ps();
+			for (int y = 0; y < kBlockSize; y++)
+				for (int x = 0; x < kBlockSize; x += 4)
+					farthest = _mm_max_ps(farthest, _mm_loadu_ps(block + y * mWidth + x));
+
+			farthest = _mm_max_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(1, 0, 3, 2)));
+			farthest = _mm_max_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(2, 3, 0, 1)));
+			mHiZ[blockY * mBlocksX + blockX] = _mm_cvtss_f32(farthest);
+#else
+			float farthest = 0.0f;
+			for (int y = 0; y < kBlockSize; y++)
+				for (int x = 0; x < kBlockSize; x++)
+					farthest = std::max(farthest, block[y * mWidth + x]);
+
+			mHiZ[blockY * mBlocksX + blockX] = farthest;
+#endif
+		}
+	}
+}
+
+bool OcclusionBuffer::isVisible(const glm::vec3& center, float radius) const
+{
+	if (mTriangles.empty())
+		return true;
+
+	// project the corners of the box around the sphere; its screen bounds and nearest
+	// corner depth bound the sphere, as long as no corner is behind the near plane
+	glm::vec4 clipCenter = mProjViewMatrix * glm::vec4(center, 1.0f);
+	glm::vec4 axisX = mProjViewMatrix[0] * radius;
+	glm::vec4 axisY = mProjViewMatrix[1] * radius;
+	glm::vec4 axisZ = mProjViewMatrix[2] * radius;
+
+	glm::vec2 minScreen(1e30f), maxScreen(-1e30f);
+	float minDepth = 1e30f;
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec4 corner = clipCenter
+			+ ((i & 1) ? axisX : -axisX)
+			+ ((i & 2) ? axisY : -axisY)
+			+ ((i & 4) ? axisZ : -axisZ);
+
+		if (corner.w <= 0.0f || corner.z < -corner.w)
+			return true;
+
+		glm::vec3 ndc = glm::vec3(corner) / corner.w;
+		minScreen = glm::min(minScreen, glm::vec2(ndc));
+		maxScreen = glm::max(maxScreen, glm::vec2(ndc));
+		minDepth = std::min(minDepth, ndc.z);
+	}
+
+	minDepth = minDepth * 0.5f + 0.5f;
+
+	// blocks under the screen bounds
+	int x0 = static_cast<int>(std::floor((minScreen.x * 0.5f + 0.5f) * mWidth));
+	int y0 = static_cast<int>(std::floor((minScreen.y * 0.5f + 0.5f) * mHeight));
+	int x1 = static_cast<int>(std::floor((maxScreen.x * 0.5f + 0.5f) * mWidth));
+	int y1 = static_cast<int>(std::floor((maxScreen.y * 0.5f + 0.5f) * mHeight));
+	if (x1 < 0 || y1 < 0 || x0 >= mWidth || y0 >= mHeight)
+		return true;
+
+	int blockX0 = std::max(x0, 0) / kBlockSize;
+	int blockY0 = std::max(y0, 0) / kBlockSize;
+	int blockX1 = std::min(x1, mWidth - 1) / kBlockSize;
+	int blockY1 = std::min(y1, mHeight - 1) / kBlockSize;
+
+	// visible if any block has a farthest occluder depth behind the nearest point of the sphere
+	for (int blockY = blockY0; blockY <= blockY1; blockY++)
+	{
+		const float* row = &mHiZ[blockY * mBlocksX];
+		int blockX = blockX0;
+
+#if defined(OCCLUSION_SSE)
+		__m128 depth = _mm_set1_ps(minDepth);
+		for (; blockX + 4 <= blockX1 + 1; blockX += 4)
+		{
+			if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + blockX), depth)))
+				return true;
+		}
+#endif
+
+		for (; blockX <= blockX1; blockX++)
+		{
+			if (row[blockX] >= minDepth)
+				return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,149 @@
+#include "OcclusionQueries.h"
+
+OcclusionQueries::OcclusionQueries()
+{}
+
+OcclusionQueries::~OcclusionQueries()
+{
+	for (auto& entry : mObjects)
+		glDeleteQueries(kQueryFrames, entry.second.queries);
+}
+
+void OcclusionQueries::beginFrame()
+{
+	mFrame++;
+	mQueryCount = 0;
+	mResultCount = 0;
+	mHiddenCount = 0;
+	mDroppedCount = 0;
+	mInsideCount = 0;
+
+	// results of objects queried in the previous frame; older ones are stale and dropped by issue()
+	for (auto& entry : mObjects)
+	{
+		if (entry.second.lastFrame + 1 == mFrame)
+			readResults(entry.second);
+	}
+}
+
+void OcclusionQueries::issue(int view, uint32_t object, SimpleModel* model, ShaderProgram& program, const glm::mat4& modelMatrix,
+	const glm::vec3& viewpoint, float nearDistance)
+{
+	auto found = mObjects.find(objectKey(view, object));
+	if (found == mObjects.end())
+	{
+		ObjectQueries queries;
+		glGenQueries(kQueryFrames, queries.queries);
+		for (int i = 0; i < kQueryFrames; i++)
+			queries.pending[i] = false;
+		queries.lastFrame = mFrame - 1;
+		found = mObjects.emplace(objectKey(view, object), queries).first;
+	}
+
+	ObjectQueries& queries = found->second;
+
+	// results from before a gap (e.g. while the object was outside the frustum) are stale
+	if (queries.lastFrame + 1 != mFrame)
+	{
+		for (int i = 0; i < kQueryFrames; i++)
+		{
+			if (queries.pending[i])
+				mDroppedCount++;
+			queries.pending[i] = false;
+		}
+		queries.hiddenResults = 0;
+	}
+
+	// world space box around the transformed model space box, grown by the near plane distance
+	const Mesh* mesh = model->GetMesh();
+	glm::vec3 center = glm::vec3(modelMatrix * glm::vec4((mesh->aabbMin + mesh->aabbMax) * 0.5f, 1.0f));
+	glm::vec3 halfSize = (mesh->aabbMax - mesh->aabbMin) * 0.5f;
+	glm::vec3 extent(nearDistance);
+	for (int i = 0; i < 3; i++)
+		extent += glm::abs(glm::vec3(modelMatrix[i])) * halfSize[i];
+
+	// the near plane would cut the box open, so the object is visible and earlier results no longer apply
+	glm::vec3 offset = glm::abs(viewpoint - center);
+	if (offset.x <= extent.x && offset.y <= extent.y && offset.z <= extent.z)
+	{
+		for (int i = 0; i < kQueryFrames; i++)
+			queries.pending[i] = false;
+		queries.hiddenResults = 0;
+		queries.lastFrame = mFrame;
+		mInsideCount++;
+		return;
+	}
+
+	// the slot of this frame is reused; a result that still is not available is given up
+	int slot = mFrame % kQueryFrames;
+	if (queries.pending[slot])
+		mDroppedCount++;
+
+	program.setUniform("uModelMatrix", modelMatrix);
+	glBeginQuery(GL_ANY_SAMPLES_PASSED, queries.queries[slot]);
+	model->drawBounds();
+	glEndQuery(GL_ANY_SAMPLES_PASSED);
+
+	queries.pending[slot] = true;
+	queries.lastFrame = mFrame;
+
+	mQueryCount++;
+	if (queries.hiddenResults >= getHysteresis(view))
+		mHiddenCount++;
+}
+
+void OcclusionQueries::setHysteresis(int view, int results)
+{
+	if (view >= static_cast<int>(mHysteresis.size()))
+		mHysteresis.resize(view + 1, kDefaultHysteresis);
+	mHysteresis[view] = results > 0 ? results : 1;
+}
+
+GLuint OcclusionQueries::getConditionalQuery(int view, uint32_t object) const
+{
+	auto found = mObjects.find(objectKey(view, object));
+	if (found == mObjects.end())
+		return 0;
+
+	const ObjectQueries& queries = found->second;
+	if (queries.lastFrame != mFrame || queries.hiddenResults < getHysteresis(view))
+		return 0;
+
+	return queries.queries[mFrame % kQueryFrames];
+}
+
+bool OcclusionQueries::isHidden(int view, uint32_t object) const
+{
+	auto found = mObjects.find(objectKey(view, object));
+	if (found == mObjects.end())
+		return false;
+
+	// issue() keeps the hidden results of objects that were also queried in the previous frame
+	const ObjectQueries& queries = found->second;
+	bool continuous = queries.lastFrame == mFrame || queries.lastFrame + 1 == mFrame;
+	return continuous && queries.hiddenResults >= getHysteresis(view);
+}
+
+void OcclusionQueries::readResults(ObjectQueries& queries)
+{
+	// oldest first, stopping at the first result that is not available yet
+	for (int age = kQueryFrames; age > 0; age--)
+	{
+		int slot = (mFrame + kQueryFrames - age) % kQueryFrames;
+		if (!queries.pending[slot])
+			continue;
+
+		GLuint available = 0;
+		glGetQueryObjectuiv(queries.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			return;
+
+		GLuint samplesPassed = 0;
+		glGetQueryObjectuiv(queries.queries[slot], GL_QUERY_RESULT, &samplesPassed);
+		queries.pending[slot] = false;
+		mResultCount++;
+
+		// a single visible result makes the object visible again straight away
+		queries.hiddenResults = samplesPassed ? 0 : queries.hiddenResults + 1;
+	}
+}
@@ -0,0 +1,325 @@
+#include "Profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	struct Event
+	{
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+	};
+
+	// events of one thread; only the thread writes, and publishes them through written
+	struct ThreadEvents
+	{
+		std::string name;
+		uint32_t id = 0;
+		std::unique_ptr<Event[]> events;
+		std::atomic<uint64_t> written;
+		uint64_t folded = 0;		// main thread's position in the ring
+		bool gpu = false;			// zones timed by GPU queries rather than on this thread
+
+		ThreadEvents() : events(new Event[Profiler::kEventCapacity]), written(0) {}
+	};
+
+	struct Zone
+	{
+		const char* name;
+		float frames[Profiler::kRollingFrames];	// milliseconds per frame
+		float total;
+	};
+
+	// never destroyed, so threads still running at exit can record safely
+	struct Registry
+	{
+		Clock::time_point epoch = Clock::now();
+		std::atomic<bool> enabled;
+		std::mutex mutex;	// guards threads
+		std::vector<ThreadEvents*> threads;
+		ThreadEvents* gpuTrack = nullptr;	// written by the GL thread only
+
+		// rolling breakdown, main thread only
+		std::vector<Zone> zones;
+		std::unordered_map<const char*, size_t> zonesByPointer;
+		std::map<std::string, size_t> zonesByName;
+		int frameSlot = 0;
+
+		Registry() : enabled(true) {}
+	};
+
+	Registry& registry()
+	{
+		static Registry* instance = new Registry();
+		return *instance;
+	}
+
+	thread_local ThreadEvents* tThread = nullptr;
+	thread_local std::string tThreadName;	// name given before the first zone
+
+	// the ring of the calling thread, created with its first zone
+	ThreadEvents& threadEvents()
+	{
+		if (!tThread)
+		{
+			Registry& r = registry();
+			std::lock_guard<std::mutex> lock(r.mutex);
+			tThread = new ThreadEvents();
+			tThread->id = static_cast<uint32_t>(r.threads.size());
+			tThread->name = tThreadName.empty() ? "Thread " + std::to_string(tThread->id) : tThreadName;
+			r.threads.push_back(tThread);
+		}
+		return *tThread;
+	}
+
+	// the track of the GPU zones, created with the first of them
+	ThreadEvents& gpuEvents()
+	{
+		Registry& r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		if (!r.gpuTrack)
+		{
+			r.gpuTrack = new ThreadEvents();
+			r.gpuTrack->id = static_cast<uint32_t>(r.threads.size());
+			r.gpuTrack->name = "GPU";
+			r.gpuTrack->gpu = true;
+			r.threads.push_back(r.gpuTrack);
+		}
+		return *r.gpuTrack;
+	}
+
+	void writeEvent(ThreadEvents& thread, const char* name, uint64_t start, uint64_t end)
+	{
+		uint64_t index = thread.written.load(std::memory_order_relaxed);
+
+		Event& event = thread.events[index % Profiler::kEventCapacity];
+		event.name = name;
+		event.start = start;
+		event.end = end;
+
+		thread.written.store(index + 1, std::memory_order_release);
+	}
+
+	std::vector<ThreadEvents*> registeredThreads()
+	{
+		Registry& r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		return r.threads;
+	}
+
+	// copy the events of a thread from index first on; events overwritten while copying are dropped
+	uint64_t copyEvents(const ThreadEvents& thread, uint64_t first, std::vector<Event>& out)
+	{
+		uint64_t written = thread.written.load(std::memory_order_acquire);
+		if (written - first > Profiler::kEventCapacity)
+			first = written - Profiler::kEventCapacity;
+
+		size_t begin = out.size();
+		for (uint64_t i = first; i < written; i++)
+			out.push_back(thread.events[i % Profiler::kEventCapacity]);
+
+		// the writer may have lapped the oldest copied events in the meantime
+		uint64_t after = thread.written.load(std::memory_order_acquire);
+		if (after - first > Profiler::kEventCapacity)
+		{
+			size_t lapped = static_cast<size_t>(std::min<uint64_t>(after - first - Profiler::kEventCapacity, written - first));
+			out.erase(out.begin() + begin, out.begin() + begin + lapped);
+		}
+
+		return written;
+	}
+
+	size_t zoneIndex(Registry& r, const char* name)
+	{
+		auto found = r.zonesByPointer.find(name);
+		if (found != r.zonesByPointer.end())
+			return found->second;
+
+		// the same name may be a different literal in another translation unit
+		auto named = r.zonesByName.find(name);
+		size_t index;
+		if (named != r.zonesByName.end())
+		{
+			index = named->second;
+		}
+		else
+		{
+			Zone zone;
+			zone.name = name;
+			zone.total = 0.0f;
+			for (int i = 0; i < Profiler::kRollingFrames; i++)
+				zone.frames[i] = 0.0f;
+
+			index = r.zones.size();
+			r.zones.push_back(zone);
+			r.zonesByName[name] = index;
+		}
+
+		r.zonesByPointer[name] = index;
+		return index;
+	}
+
+}
+
+uint64_t Profiler::now()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - registry().epoch).count());
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t end)
+{
+	writeEvent(threadEvents(), name, start, end);
+}
+
+void Profiler::recordGpu(const char* name, uint64_t start, uint64_t end)
+{
+	writeEvent(gpuEvents(), name, start, end);
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+	registry().enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Profiler::isEnabled()
+{
+	return registry().enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const std::string& name)
+{
+	tThreadName = name;
+	if (tThread)
+	{
+		std::lock_guard<std::mutex> lock(registry().mutex);
+		tThread->name = name;
+	}
+}
+
+void Profiler::endFrame()
+{
+	Registry& r = registry();
+
+	// reuse the oldest frame of the rolling window
+	r.frameSlot = (r.frameSlot + 1) % kRollingFrames;
+	for (size_t z = 0; z < r.zones.size(); z++)
+	{
+		r.zones[z].total -= r.zones[z].frames[r.frameSlot];
+		r.zones[z].frames[r.frameSlot] = 0.0f;
+	}
+
+	std::vector<Event> events;
+	std::vector<ThreadEvents*> threads = registeredThreads();
+	for (size_t t = 0; t < threads.size(); t++)
+	{
+		events.clear();
+		threads[t]->folded = copyEvents(*threads[t], threads[t]->folded, events);
+		if (threads[t]->gpu)
+			continue;
+
+		for (size_t i = 0; i < events.size(); i++)
+		{
+			Zone& zone = r.zones[zoneIndex(r, events[i].name)];
+			float milliseconds = (events[i].end - events[i].start) * 1.0e-6f;
+			zone.frames[r.frameSlot] += milliseconds;
+			zone.total += milliseconds;
+		}
+	}
+}
+
+size_t Profiler::getZoneCount()
+{
+	return registry().zones.size();
+}
+
+const char* Profiler::getZoneName(size_t zone)
+{
+	return registry().zones[zone].name;
+}
+
+float Profiler::getZoneTime(size_t zone)
+{
+	// the running total drifts by float rounding, never show it below zero
+	float total = registry().zones[zone].total;
+	return total > 0.0f ? total / kRollingFrames : 0.0f;
+}
+
+bool Profiler::exportChromeTrace(const std::string& filename)
+{
+	std::ofstream out(filename);
+	if (!out)
+		return false;
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	out << std::fixed << std::setprecision(3);
+
+	bool first = true;
+	std::vector<Event> events;
+	std::vector<ThreadEvents*> threads = registeredThreads();
+	for (size_t t = 0; t < threads.size(); t++)
+	{
+		const ThreadEvents& thread = *threads[t];
+
+		// thread name metadata
+		std::string name;
+		{
+			std::lock_guard<std::mutex> lock(registry().mutex);
+			name = thread.name;
+		}
+		out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.id
+			<< ",\"args\":{\"name\":";
+		writeJsonString(out, name);
+		out << "}}";
+		first = false;
+
+		// complete events, timestamps and durations in microseconds
+		events.clear();
+		copyEvents(thread, 0, events);
+		for (size_t i = 0; i < events.size(); i++)
+		{
+			out << ",\n{\"name\":";
+			writeJsonString(out, events[i].name);
+			out << ",\"cat\":\"" << (thread.gpu ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.id
+				<< ",\"ts\":" << events[i].start * 1.0e-3
+				<< ",\"dur\":" << (events[i].end - events[i].start) * 1.0e-3 << "}";
+		}
+	}
+
+	out << "\n]}\n";
+	return static_cast<bool>(out);
+}
+
+void Profiler::writeJsonString(std::ostream& out, const std::string& text)
+{
+	static const char kHexDigits[] = "0123456789abcdef";
+
+	out << '"';
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		char c = text[i];
+		if (c == '"' || c == '\\')
+			out << '\\' << c;
+		else if (c == '\n')
+			out << "\\n";
+		else if (c == '\r')
+			out << "\\r";
+		else if (c == '\t')
+			out << "\\t";
+		else if (static_cast<unsigned char>(c) < 0x20)
+			out << "\\u00" << kHexDigits[c >> 4] << kHexDigits[c & 0xf];
+		else
+			out << c;
+	}
+	out << '"';
+}
@@ -0,0 +1,890 @@
+#include "RenderQueue.h"
+#include "GLState.h"
+#include "Culling.h"
+#include "GpuProfiler.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+// bit widths of the sort key fields
+static const int kViewBits = 4;
+static const int kPassBits = 4;
+static const int kProgramBits = 8;
+static const int kMaterialBits = 16;
+
+// smallest run of identical meshes that is drawn instanced
+static const size_t kMinInstances = 2;
+// offset alignment of instance data in the stream buffer
+static const size_t kInstanceAlignment = 16;
+
+// view field value shared by all multi-view draws, and the number of views they can cover
+static const uint32_t kMultiViewGroup = (1u << kViewBits) - 1;
+// every other value of the view field is free for a view, slots must fit their fields
+static const size_t kMaxViews = kMultiViewGroup;
+static const size_t kMaxPrograms = 1u << kProgramBits;
+static const size_t kMaxMaterials = 1u << kMaterialBits;
+static const int kMaxMultiViews = 4;
+// GpuProfiler zone of the multi-view pass
+static const char* const kMultiViewGpuZone = "Multi-View";
+
+// depth test modes: normal, depth only (pre-pass), shading after a pre-pass
+enum DepthMode { DEPTH_NORMAL, DEPTH_PREPASS, DEPTH_EQUAL };
+
+RenderQueue::RenderQueue()
+{
+}
+
+RenderQueue::~RenderQueue()
+{
+}
+
+void RenderQueue::clear()
+{
+	mViews.clear();
+	mCommands.clear();
+	mItems.clear();
+
+	// keep the per-view storage for the next frame
+	for (size_t i = 0; i < mSubmissions.size(); i++)
+	{
+		mSubmissions[i].commands.clear();
+		mSubmissions[i].items.clear();
+	}
+}
+
+int RenderQueue::addView(int x, int y, int width, int height, const glm::mat4& projViewMatrix, const glm::vec3& viewpoint,
+	bool depthPrepass)
+{
+	// a further view would alias the multi-view group in the sort key
+	if (mViews.size() >= kMaxViews)
+	{
+		std::cerr << "RenderQueue: more than " << kMaxViews << " views" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	RenderView view;
+	view.x = x;
+	view.y = y;
+	view.width = width;
+	view.height = height;
+	view.projViewMatrix = projViewMatrix;
+	view.viewpoint = viewpoint;
+	view.depthPrepass = depthPrepass;
+
+	// distance from the viewpoint to the near plane, for perspective and orthographic projections alike
+	glm::vec4 nearPlane = extractFrustum(projViewMatrix).planes[4];
+	view.nearDistance = fabsf(glm::dot(nearPlane, glm::vec4(viewpoint, 1.0f)));
+
+	mViews.push_back(view);
+	if (mSubmissions.size() < mViews.size())
+		mSubmissions.resize(mViews.size());
+
+	return static_cast<int>(mViews.size()) - 1;
+}
+
+void RenderQueue::setViewStatsScope(int view, int scope)
+{
+	mViews[view].statsScope = scope;
+}
+
+void RenderQueue::setViewGpuZone(int view, const char* zone)
+{
+	mViews[view].gpuZone = zone;
+}
+
+void RenderQueue::setLight(Light* light)
+{
+	mLight = light;
+}
+
+void RenderQueue::setClusterLights(const Light* lights, size_t count)
+{
+	mClusters.setLights(lights, count);
+}
+
+void RenderQueue::setShadowMap(ShadowCubeMap* shadowMap)
+{
+	mShadowMap = shadowMap;
+}
+
+void RenderQueue::setStreamBuffer(StreamBuffer* streamBuffer)
+{
+	mStreamBuffer = (streamBuffer != nullptr && streamBuffer->isValid()) ? streamBuffer : nullptr;
+}
+
+void RenderQueue::setInstancedProgram(ShaderProgram* program, ShaderProgram* instancedProgram)
+{
+	mInstancedPrograms.push_back(std::make_pair(program, instancedProgram));
+}
+
+void RenderQueue::setMultiViewProgram(ShaderProgram* program, ShaderProgram* multiViewProgram)
+{
+	mMultiViewPrograms.push_back(std::make_pair(program, multiViewProgram));
+}
+
+void RenderQueue::setDepthProgram(ShaderProgram* depthProgram)
+{
+	mDepthProgram = depthProgram;
+	reserveSlots(depthProgram, nullptr);
+}
+
+void RenderQueue::reserveSlots(ShaderProgram* program, SimpleModel* model)
+{
+	std::lock_guard<std::mutex> lock(mSlotMutex);
+	if (program != nullptr)
+		mReservedPrograms[program] = programSlot(program);
+	if (model != nullptr)
+		mReservedMaterials[model->GetMesh()] = materialSlot(model->GetMesh());
+}
+
+void RenderQueue::setMultiView(bool enabled)
+{
+	mMultiView = enabled;
+}
+
+void RenderQueue::submit(int view, RenderPass pass, ShaderProgram* program, SimpleModel* model, uint32_t object,
+	const glm::mat4& modelMatrix, const glm::mat3& normalMatrix, GLenum topology)
+{
+	if (!model->mIsValid)
+		return;
+
+	DrawCommand command;
+	command.program = program;
+	command.model = model;
+	command.topology = topology;
+	command.object = object;
+	command.view = view;
+	command.modelMatrix = modelMatrix;
+	command.normalMatrix = normalMatrix;
+
+	// sort opaque draws front to back by distance of the model origin from the viewpoint
+	glm::vec3 toModel = glm::vec3(modelMatrix[3]) - mViews[view].viewpoint;
+	float depth = glm::dot(toModel, toModel);
+
+	bool depthPrepass = mViews[view].depthPrepass && mDepthProgram != nullptr;
+
+	// slots are shared by all views, which may be submitted to from other threads
+	uint32_t material = findMaterialSlot(model->GetMesh());
+	uint32_t programIndex = findProgramSlot(program);
+	uint32_t depthProgramIndex = depthPrepass ? findProgramSlot(mDepthProgram) : 0;
+
+	// draws that can be rendered for all views at once go to the shared multi-view group;
+	// views with a depth pre-pass need their own depth state and are drawn separately
+	uint32_t viewGroup = static_cast<uint32_t>(view);
+	if (mMultiView && view < kMaxMultiViews && !depthPrepass && findVariant(mMultiViewPrograms, program) != nullptr)
+		viewGroup = kMultiViewGroup;
+
+	// commands are numbered within the view until sort() merges the views
+	ViewSubmissions& submissions = mSubmissions[view];
+
+	RenderItem item;
+	item.key = makeKey(viewGroup, pass, programIndex, material, depth);
+	item.command = static_cast<uint32_t>(submissions.commands.size());
+
+	submissions.commands.push_back(command);
+	submissions.items.push_back(item);
+
+	// depth-only copy of the draw, sorted before the occluder and opaque passes of the view
+	if (pass != PASS_DEPTH && depthPrepass)
+	{
+		command.program = mDepthProgram;
+
+		item.key = makeKey(viewGroup, PASS_DEPTH, depthProgramIndex, material, depth);
+		item.command = static_cast<uint32_t>(submissions.commands.size());
+
+		submissions.commands.push_back(command);
+		submissions.items.push_back(item);
+	}
+}
+
+uint64_t RenderQueue::makeKey(uint32_t view, uint32_t pass, uint32_t program, uint32_t material, float depth)
+{
+	// the bit pattern of a non-negative float sorts like the float itself
+	uint32_t depthBits;
+	std::memcpy(&depthBits, &depth, sizeof(depthBits));
+
+	uint64_t key = view & ((1u << kViewBits) - 1);
+	key = (key << kPassBits) | (pass & ((1u << kPassBits) - 1));
+	key = (key << kProgramBits) | (program & ((1u << kProgramBits) - 1));
+	key = (key << kMaterialBits) | (material & ((1u << kMaterialBits) - 1));
+	key = (key << 32) | depthBits;
+	return key;
+}
+
+void RenderQueue::sort()
+{
+	// merge the draws of all views
+	mCommands.clear();
+	mItems.clear();
+	for (size_t v = 0; v < mViews.size(); v++)
+	{
+		const ViewSubmissions& submissions = mSubmissions[v];
+		uint32_t offset = static_cast<uint32_t>(mCommands.size());
+
+		mCommands.insert(mCommands.end(), submissions.commands.begin(), submissions.commands.end());
+		for (size_t i = 0; i < submissions.items.size(); i++)
+		{
+			RenderItem item = submissions.items[i];
+			item.command += offset;
+			mItems.push_back(item);
+		}
+	}
+
+	const size_t count = mItems.size();
+	if (count < 2)
+		return;
+
+	mSortScratch.resize(count);
+
+	// histogram all eight key bytes in a single pass
+	size_t histogram[8][256];
+	std::memset(histogram, 0, sizeof(histogram));
+
+	for (size_t i = 0; i < count; i++)
+	{
+		uint64_t key = mItems[i].key;
+		for (int b = 0; b < 8; b++)
+			histogram[b][(key >> (b * 8)) & 0xFF]++;
+	}
+
+	RenderItem* src = mItems.data();
+	RenderItem* dst = mSortScratch.data();
+
+	// least significant byte first, stable scatter per byte
+	for (int b = 0; b < 8; b++)
+	{
+		// skip bytes that are identical for every item (e.g. unused view and pass bits)
+		if (histogram[b][(src[0].key >> (b * 8)) & 0xFF] == count)
+			continue;
+
+		size_t offset = 0;
+		for (int d = 0; d < 256; d++)
+		{
+			size_t n = histogram[b][d];
+			histogram[b][d] = offset;
+			offset += n;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t digit = (src[i].key >> (b * 8)) & 0xFF;
+			dst[histogram[b][digit]++] = src[i];
+		}
+
+		std::swap(src, dst);
+	}
+
+	// result ended up in the scratch buffer
+	if (src != mItems.data())
+		mItems.swap(mSortScratch);
+}
+
+void RenderQueue::execute()
+{
+	PROFILE_ZONE("RenderQueue::execute");
+	const uint64_t kViewMask = ~0ull << (64 - kViewBits);
+
+	// assign the cluster lights for every view
+	ClusterView clusterViews[LightClusters::kMaxViews];
+	int numClusterViews = static_cast<int>(std::min(mViews.size(), static_cast<size_t>(LightClusters::kMaxViews)));
+	for (int v = 0; v < numClusterViews; v++)
+	{
+		clusterViews[v].projViewMatrix = mViews[v].projViewMatrix;
+		clusterViews[v].viewpoint = mViews[v].viewpoint;
+		clusterViews[v].viewport = glm::vec4(mViews[v].x, mViews[v].y, mViews[v].width, mViews[v].height);
+	}
+	mClusters.build(clusterViews, numClusterViews);
+	mClusters.bind();
+
+	updateMaterials();
+	mMaterialBuffer.bind();
+
+	if (mShadowMap)
+		mShadowMap->bind();
+
+	// read back the query results before recording decides which draws are conditional
+	if (mOcclusionQueriesEnabled && mDepthProgram != nullptr)
+		mOcclusionQueries.beginFrame();
+
+	// record every view group into its own buffer
+	auto startTime = std::chrono::steady_clock::now();
+
+	mGroupStarts.clear();
+	for (size_t i = 0; i < mItems.size(); i++)
+	{
+		if (i == 0 || (mItems[i].key & kViewMask) != (mItems[i - 1].key & kViewMask))
+			mGroupStarts.push_back(i);
+	}
+	size_t numGroups = mGroupStarts.size();
+	mGroupStarts.push_back(mItems.size());
+
+	if (mCommandBuffers.size() < numGroups)
+		mCommandBuffers.resize(numGroups);
+
+	auto recordGroups = [this](size_t begin, size_t end)
+	{
+		for (size_t g = begin; g < end; g++)
+			record(mGroupStarts[g], mGroupStarts[g + 1], mCommandBuffers[g]);
+	};
+	if (mJobs)
+		mJobs->parallelFor(numGroups, 1, recordGroups);
+	else
+		recordGroups(0, numGroups);
+
+	std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+	mRecordTime = elapsed.count();
+
+	// issue the buffers in sorted order
+	mRecordedCommands = 0;
+	int depthMode = DEPTH_NORMAL;
+	for (size_t g = 0; g < numGroups; g++)
+	{
+		replay(mCommandBuffers[g], depthMode);
+		mRecordedCommands += mCommandBuffers[g].commands.size();
+	}
+
+	// restore the default depth state for whatever is drawn next
+	if (depthMode != DEPTH_NORMAL)
+	{
+		GLState::setColorMask(true);
+		GLState::setDepthFunc(GL_LESS);
+		GLState::setDepthMask(true);
+	}
+}
+
+void RenderQueue::record(size_t begin, size_t end, CommandBuffer& buffer)
+{
+	PROFILE_ZONE("RenderQueue::record");
+	const uint64_t kStateMask = ~0ull << 32;	// everything but depth
+
+	buffer.clear();
+
+	// the group shares one view (or the multi-view group), so viewport and per-view uniforms are set once
+	uint32_t viewGroup = static_cast<uint32_t>(mItems[begin].key >> (64 - kViewBits));
+	bool multiView = viewGroup == kMultiViewGroup;
+
+	RenderCommand beginView;
+	beginView.op = OP_BEGIN_VIEW;
+	beginView.view = viewGroup;
+	beginView.flags = multiView ? OP_FLAG_MULTI_VIEW : 0;
+	beginView.index = mCommands[mItems[begin].command].view;
+	buffer.commands.push_back(beginView);
+
+	// the depth state left by the previous group is unknown here, so the first draw always sets it
+	ShaderProgram* lastProgram = nullptr;
+	const Mesh* lastMaterial = nullptr;
+	int lastDepthMode = -1;
+
+	bool occlusionQueries = mOcclusionQueriesEnabled && mDepthProgram != nullptr;
+	bool queriedView = false;
+
+	size_t i = begin;
+	while (i < end)
+	{
+		const RenderItem& item = mItems[i];
+		const DrawCommand& command = mCommands[item.command];
+		const RenderView& view = mViews[command.view];
+		uint32_t pass = static_cast<uint32_t>(item.key >> (64 - kViewBits - kPassBits)) & ((1u << kPassBits) - 1);
+		bool depthPass = pass == PASS_DEPTH;
+
+		// query the boxes of the view's opaque draws once its occluders are in the depth buffer
+		bool queried = occlusionQueries && pass == PASS_OPAQUE && !multiView && !view.depthPrepass;
+		if (queried && !queriedView)
+		{
+			queriedView = true;
+
+			RenderCommand queries;
+			queries.op = OP_OCCLUSION_QUERIES;
+			queries.view = command.view;
+			queries.first = static_cast<uint32_t>(i);
+			buffer.commands.push_back(queries);
+
+			// the queries leave their program bound and the normal depth state
+			lastProgram = nullptr;
+			lastDepthMode = DEPTH_NORMAL;
+		}
+
+		// objects that stayed hidden are drawn on their own, conditionally on this frame's query
+		bool conditional = queried && mOcclusionQueries.isHidden(command.view, command.object);
+
+		// find the run of items drawing the same mesh with the same state
+		size_t runEnd = i + 1;
+		while (runEnd < end && !conditional
+			&& (mItems[runEnd].key & kStateMask) == (item.key & kStateMask)
+			&& mCommands[mItems[runEnd].command].topology == command.topology
+			&& (!queried || !mOcclusionQueries.isHidden(command.view, mCommands[mItems[runEnd].command].object)))
+		{
+			runEnd++;
+		}
+
+		ShaderProgram* program = command.program;
+		bool drawInstanced = multiView;
+		if (multiView)
+		{
+			program = findVariant(mMultiViewPrograms, program);
+		}
+		else
+		{
+			ShaderProgram* instanced = findVariant(mInstancedPrograms, program);
+			// with a stream buffer even single draws take their matrices from it rather than from uniforms
+			drawInstanced = (instanced != nullptr && (runEnd - i >= kMinInstances || mStreamBuffer != nullptr));
+			if (drawInstanced)
+				program = instanced;
+			else
+				runEnd = i + 1;
+		}
+
+		// depth pre-pass writes depth only, the following opaque pass only shades the visible surface
+		int depthMode = DEPTH_NORMAL;
+		if (depthPass)
+			depthMode = DEPTH_PREPASS;
+		else if (!multiView && view.depthPrepass && mDepthProgram != nullptr)
+			depthMode = DEPTH_EQUAL;
+
+		if (depthMode != lastDepthMode)
+		{
+			lastDepthMode = depthMode;
+
+			RenderCommand state;
+			state.op = OP_DEPTH_MODE;
+			state.mode = static_cast<uint16_t>(depthMode);
+			buffer.commands.push_back(state);
+		}
+
+		uint8_t flags = (depthPass ? OP_FLAG_DEPTH_PASS : 0) | (multiView ? OP_FLAG_MULTI_VIEW : 0);
+
+		// new program, set light and camera
+		if (program != lastProgram)
+		{
+			lastProgram = program;
+			lastMaterial = nullptr;
+
+			RenderCommand use;
+			use.op = OP_PROGRAM;
+			use.flags = flags;
+			use.view = command.view;
+			use.program = program;
+			buffer.commands.push_back(use);
+		}
+
+		// new material, set the material index and textures (not needed for depth only)
+		const Mesh* mesh = command.model->GetMesh();
+		uint32_t material = static_cast<uint32_t>(item.key >> 32) & ((1u << kMaterialBits) - 1);
+		if (mesh != lastMaterial && !depthPass)
+		{
+			lastMaterial = mesh;
+
+			RenderCommand materialCommand;
+			materialCommand.op = OP_MATERIAL;
+			materialCommand.index = static_cast<uint32_t>(mMaterialIndices[material]);
+			materialCommand.program = program;
+			materialCommand.model = command.model;
+			buffer.commands.push_back(materialCommand);
+		}
+
+		RenderCommand draw;
+		draw.op = drawInstanced ? OP_DRAW_INSTANCED : OP_DRAW;
+		draw.flags = flags | (conditional ? OP_FLAG_CONDITIONAL : 0);
+		draw.view = command.view;
+		draw.index = command.object;
+		draw.topology = command.topology;
+		draw.program = program;
+		draw.model = command.model;
+		draw.first = static_cast<uint32_t>(buffer.instances.size());
+
+		// per-instance data of the whole run, one instance per object
+		buffer.objectInstances.clear();
+		for (size_t j = i; j < runEnd; j++)
+		{
+			const DrawCommand& instance = mCommands[mItems[j].command];
+
+			// in multi-view mode an object submitted by several views becomes one instance
+			if (multiView)
+			{
+				auto found = buffer.objectInstances.find(instance.object);
+				if (found != buffer.objectInstances.end())
+				{
+					buffer.instances[found->second].viewMask |= 1 << instance.view;
+					continue;
+				}
+				buffer.objectInstances[instance.object] = buffer.instances.size();
+			}
+
+			InstanceData data;
+			data.modelMatrix = instance.modelMatrix;
+			data.normalMatrix = instance.normalMatrix;
+			data.materialIndex = mMaterialIndices[material];
+			data.viewMask = multiView ? (1 << instance.view) : ~0;
+			buffer.instances.push_back(data);
+		}
+
+		draw.count = static_cast<uint32_t>(buffer.instances.size()) - draw.first;
+		// in multi-view mode every instance is repeated once per view
+		draw.mode = static_cast<uint16_t>(multiView && !depthPass ? multiViewCount() : 1);
+		buffer.commands.push_back(draw);
+
+		i = runEnd;
+	}
+}
+
+void RenderQueue::replay(const CommandBuffer& buffer, int& depthMode)
+{
+	PROFILE_ZONE("RenderQueue::replay");
+	ShaderProgram* program = nullptr;
+
+	// GPU zones of the view and of the current shader group within it
+	int viewZone = -1;
+	int programZone = -1;
+	// views switch the statistics scope, the caller's is restored afterwards
+	RenderStatsScope statsScope(RenderStats::getScope());
+
+	for (size_t c = 0; c < buffer.commands.size(); c++)
+	{
+		const RenderCommand& command = buffer.commands[c];
+		bool depthPass = (command.flags & OP_FLAG_DEPTH_PASS) != 0;
+
+		switch (command.op)
+		{
+		case OP_BEGIN_VIEW:
+			GpuProfiler::endZone(programZone);
+			GpuProfiler::endZone(viewZone);
+			programZone = -1;
+			if (command.flags & OP_FLAG_MULTI_VIEW)
+				viewZone = GpuProfiler::beginZone(kMultiViewGpuZone);
+			else if (mViews[command.index].gpuZone != nullptr)
+				viewZone = GpuProfiler::beginZone(mViews[command.index].gpuZone);
+			else
+				viewZone = -1;
+
+			if (command.flags & OP_FLAG_MULTI_VIEW)
+				RenderStats::setScope(RenderStats::kMultiViewScope);
+			else if (mViews[command.index].statsScope >= 0)
+				RenderStats::setScope(mViews[command.index].statsScope);
+
+			if (command.flags & OP_FLAG_MULTI_VIEW)
+			{
+				// one viewport per view, selected by gl_ViewportIndex
+				GLfloat viewports[kMaxMultiViews * 4];
+				int numViews = multiViewCount();
+				for (int v = 0; v < numViews; v++)
+				{
+					viewports[v * 4 + 0] = static_cast<GLfloat>(mViews[v].x);
+					viewports[v * 4 + 1] = static_cast<GLfloat>(mViews[v].y);
+					viewports[v * 4 + 2] = static_cast<GLfloat>(mViews[v].width);
+					viewports[v * 4 + 3] = static_cast<GLfloat>(mViews[v].height);
+				}
+				glViewportArrayv(0, numViews, viewports);
+			}
+			else
+			{
+				const RenderView& view = mViews[command.index];
+				glViewport(view.x, view.y, view.width, view.height);
+			}
+			break;
+
+		case OP_DEPTH_MODE:
+			depthMode = command.mode;
+			GLState::setColorMask(depthMode != DEPTH_PREPASS);
+			GLState::setDepthFunc(depthMode == DEPTH_EQUAL ? GL_EQUAL : GL_LESS);
+			GLState::setDepthMask(depthMode != DEPTH_EQUAL);
+			break;
+
+		case OP_PROGRAM:
+			program = command.program;
+			GpuProfiler::endZone(programZone);
+			programZone = GpuProfiler::beginZone(program->getName());
+			program->use();
+			if (depthPass)
+				program->setUniform("uProjViewMatrix", mViews[command.view].projViewMatrix);
+			else if (command.flags & OP_FLAG_MULTI_VIEW)
+				setMultiViewUniforms(*program);
+			else
+				setViewUniforms(*program, command.view);
+			break;
+
+		case OP_MATERIAL:
+			setMaterialUniforms(*command.program, *command.model->GetMesh(), command.index);
+			break;
+
+		case OP_OCCLUSION_QUERIES:
+			GpuProfiler::endZone(programZone);
+			programZone = GpuProfiler::beginZone("Occlusion Queries");
+			issueOcclusionQueries(command.first, mViews[command.view]);
+			depthMode = DEPTH_NORMAL;
+			break;
+
+		case OP_DRAW:
+		{
+			const InstanceData& instance = buffer.instances[command.first];
+			program->setUniform("uModelMatrix", instance.modelMatrix);
+
+			if (depthPass)
+			{
+				command.model->drawDepth(command.topology);
+			}
+			else
+			{
+				program->setUniform("uNormalMatrix", instance.normalMatrix);
+
+				GLuint conditionalQuery = (command.flags & OP_FLAG_CONDITIONAL)
+					? mOcclusionQueries.getConditionalQuery(command.view, command.index) : 0;
+				if (conditionalQuery != 0)
+					glBeginConditionalRender(conditionalQuery, GL_QUERY_WAIT);
+				command.model->drawModel(command.topology);
+				if (conditionalQuery != 0)
+					glEndConditionalRender();
+			}
+			break;
+		}
+
+		case OP_DRAW_INSTANCED:
+		{
+			const InstanceData* instances = &buffer.instances[command.first];
+			int numInstances = static_cast<int>(command.count);
+			size_t instanceBytes = sizeof(InstanceData) * command.count;
+
+			// stream the instances through the ring buffer, or upload them to the model's own buffer if it is full
+			GLintptr offset = 0;
+			void* streamed = mStreamBuffer ? mStreamBuffer->allocate(instanceBytes, kInstanceAlignment, offset) : nullptr;
+			if (streamed)
+			{
+				memcpy(streamed, instances, instanceBytes);
+				mStreamBuffer->flush();
+				RenderStats::add(STAT_BUFFER_BYTES, instanceBytes);
+			}
+
+			GLuint conditionalQuery = (command.flags & OP_FLAG_CONDITIONAL)
+				? mOcclusionQueries.getConditionalQuery(command.view, command.index) : 0;
+			if (conditionalQuery != 0)
+				glBeginConditionalRender(conditionalQuery, GL_QUERY_WAIT);
+
+			if (depthPass)
+			{
+				if (streamed)
+					command.model->drawDepthInstanced(mStreamBuffer->getBuffer(), offset, numInstances, command.topology);
+				else
+					command.model->drawDepthInstanced(instances, numInstances, command.topology);
+			}
+			else
+			{
+				if (streamed)
+					command.model->drawInstanced(mStreamBuffer->getBuffer(), offset, numInstances, command.topology, command.mode);
+				else
+					command.model->drawInstanced(instances, numInstances, command.topology, command.mode);
+			}
+
+			if (conditionalQuery != 0)
+				glEndConditionalRender();
+			break;
+		}
+		}
+	}
+
+	GpuProfiler::endZone(programZone);
+	GpuProfiler::endZone(viewZone);
+}
+
+void RenderQueue::issueOcclusionQueries(size_t begin, const RenderView& view)
+{
+	const uint64_t kGroupMask = ~0ull << (64 - kViewBits - kPassBits);	// view and pass
+
+	// boxes only test depth; equal depth counts as visible so boxes touching an occluder are kept
+	mDepthProgram->use();
+	mDepthProgram->setUniform("uProjViewMatrix", view.projViewMatrix);
+	GLState::setColorMask(false);
+	GLState::setDepthMask(false);
+	GLState::setDepthFunc(GL_LEQUAL);
+
+	uint64_t group = mItems[begin].key & kGroupMask;
+	for (size_t i = begin; i < mItems.size() && (mItems[i].key & kGroupMask) == group; i++)
+	{
+		const DrawCommand& command = mCommands[mItems[i].command];
+		mOcclusionQueries.issue(command.view, command.object, command.model, *mDepthProgram, command.modelMatrix,
+			view.viewpoint, view.nearDistance);
+	}
+
+	// queried views use the normal depth state
+	GLState::setColorMask(true);
+	GLState::setDepthMask(true);
+	GLState::setDepthFunc(GL_LESS);
+}
+
+float RenderQueue::getViewTime(int view) const
+{
+	if (view < 0 || view >= static_cast<int>(mViews.size()) || mViews[view].gpuZone == nullptr)
+		return 0.0f;
+	return GpuProfiler::getLastTime(mViews[view].gpuZone);
+}
+
+float RenderQueue::getMultiViewTime() const
+{
+	return GpuProfiler::getLastTime(kMultiViewGpuZone);
+}
+
+uint32_t RenderQueue::findProgramSlot(ShaderProgram* program)
+{
+	auto reserved = mReservedPrograms.find(program);
+	if (reserved != mReservedPrograms.end())
+		return reserved->second;
+
+	std::lock_guard<std::mutex> lock(mSlotMutex);
+	return programSlot(program);
+}
+
+uint32_t RenderQueue::findMaterialSlot(const Mesh* mesh)
+{
+	auto reserved = mReservedMaterials.find(mesh);
+	if (reserved != mReservedMaterials.end())
+		return reserved->second;
+
+	std::lock_guard<std::mutex> lock(mSlotMutex);
+	return materialSlot(mesh);
+}
+
+uint32_t RenderQueue::programSlot(ShaderProgram* program)
+{
+	for (size_t i = 0; i < mPrograms.size(); i++)
+	{
+		if (mPrograms[i] == program)
+			return static_cast<uint32_t>(i);
+	}
+
+	// an aliased slot would sort and batch draws of different programs together
+	if (mPrograms.size() >= kMaxPrograms)
+	{
+		std::cerr << "RenderQueue: more than " << kMaxPrograms << " programs" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	mPrograms.push_back(program);
+	return static_cast<uint32_t>(mPrograms.size()) - 1;
+}
+
+uint32_t RenderQueue::materialSlot(const Mesh* mesh)
+{
+	for (size_t i = 0; i < mMaterials.size(); i++)
+	{
+		if (mMaterials[i] == mesh)
+			return static_cast<uint32_t>(i);
+	}
+
+	// an aliased slot would batch different meshes and read the wrong material buffer entry
+	if (mMaterials.size() >= kMaxMaterials)
+	{
+		std::cerr << "RenderQueue: more than " << kMaxMaterials << " materials" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	mMaterials.push_back(mesh);
+	return static_cast<uint32_t>(mMaterials.size()) - 1;
+}
+
+void RenderQueue::updateMaterials()
+{
+	// a material edited after its slot was added means the entries no longer match, start over
+	bool changed = false;
+	for (size_t i = 0; i < mSlotMaterials.size() && !changed; i++)
+	{
+		const Material& material = mMaterials[i]->material;
+		const Material& added = mSlotMaterials[i];
+		changed = material.Ka != added.Ka || material.Kd != added.Kd || material.Ks != added.Ks
+			|| material.emission != added.emission || material.shininess != added.shininess;
+	}
+
+	if (changed)
+	{
+		mMaterialBuffer.clear();
+		mMaterialIndices.clear();
+		mSlotMaterials.clear();
+	}
+
+	// entries for slots added since the last frame
+	for (size_t i = mMaterialIndices.size(); i < mMaterials.size(); i++)
+	{
+		mMaterialIndices.push_back(mMaterialBuffer.add(mMaterials[i]->material));
+		mSlotMaterials.push_back(mMaterials[i]->material);
+	}
+}
+
+ShaderProgram* RenderQueue::findVariant(const std::vector<std::pair<ShaderProgram*, ShaderProgram*>>& variants, ShaderProgram* program)
+{
+	for (size_t i = 0; i < variants.size(); i++)
+	{
+		if (variants[i].first == program)
+			return variants[i].second;
+	}
+
+	return nullptr;
+}
+
+void RenderQueue::setViewUniforms(ShaderProgram& program, int view)
+{
+	setLightingUniforms(program);
+
+	// views past the cluster limit share the clusters of the last view
+	program.setUniform("uViewIndex", glm::min(view, LightClusters::kMaxViews - 1));
+	program.setUniform("uViewpoint", mViews[view].viewpoint);
+	program.setUniform("uProjViewMatrix", mViews[view].projViewMatrix);
+}
+
+void RenderQueue::setLightingUniforms(ShaderProgram& program)
+{
+	if (mLight)
+		mLight->setLightUniforms(program, "uLight.");
+	mClusters.setUniforms(program);
+	mMaterialBuffer.setUniforms(program);
+
+	if (mShadowMap)
+		mShadowMap->setUniforms(program);
+	else
+		program.setUniform("uShadowsEnabled", false);
+}
+
+int RenderQueue::multiViewCount() const
+{
+	return mViews.size() < kMaxMultiViews ? static_cast<int>(mViews.size()) : kMaxMultiViews;
+}
+
+void RenderQueue::setMultiViewUniforms(ShaderProgram& program)
+{
+	setLightingUniforms(program);
+
+	int numViews = multiViewCount();
+	program.setUniform("uNumViews", numViews);
+
+	// gather the views so each array goes up in one call without building element names
+	glm::mat4 projViewMatrices[kMaxMultiViews];
+	glm::vec3 viewpoints[kMaxMultiViews];
+	for (int v = 0; v < numViews; v++)
+	{
+		projViewMatrices[v] = mViews[v].projViewMatrix;
+		viewpoints[v] = mViews[v].viewpoint;
+	}
+
+	if (numViews > 0)
+	{
+		program.setUniform("uProjViewMatrices", projViewMatrices, numViews);
+		program.setUniform("uViewpoints", viewpoints, numViews);
+	}
+}
+
+void RenderQueue::setMaterialUniforms(ShaderProgram& program, Mesh& mesh, int materialIndex)
+{
+	// instanced programs take the index from the instance data instead
+	program.setUniform("uMaterialIndex", materialIndex);
+
+	// cube map textures are used as environment maps, everything else as a 2D texture
+	// uniforms that a program does not declare are ignored by OpenGL
+	bool hasEnvMap = (mesh.texture.getTarget() == GL_TEXTURE_CUBE_MAP);
+	program.setUniform("uTextureSampler", hasEnvMap ? 1 : 0);
+	program.setUniform("uEnvironmentMap", hasEnvMap ? 0 : 1);
+	program.setUniform("hasEnvMap", hasEnvMap);
+	program.setUniform("uNormalSampler", 1);
+
+	mesh.texture.bind(0);
+	mesh.normalTexture.bind(1);
+}
@@ -0,0 +1,130 @@
+#include "RenderStats.h"
+
+#include <fstream>
+
+namespace
+{
+	const char* const kStatNames[STAT_COUNT] = {
+		"drawCalls", "triangles", "vertices", "programSwitches",
+		"vertexArrayBinds", "textureBinds", "uniformUploads", "bufferBytes"
+	};
+
+	const char* const kScopeNames[RenderStats::kScopeCount] = {
+		"Viewport 0", "Viewport 1", "Viewport 2", "Viewport 3", "Multi-View", "Other"
+	};
+
+	struct Counts
+	{
+		uint64_t counts[RenderStats::kScopeCount][STAT_COUNT];
+	};
+
+	int currentScope = RenderStats::kOtherScope;
+	Counts current = {};
+	Counts finished = {};	// of the last frame
+	uint64_t frames = 0;
+
+	uint64_t triangleCount(GLenum topology, uint64_t vertices)
+	{
+		switch (topology)
+		{
+		case GL_TRIANGLES:
+			return vertices / 3;
+		case GL_TRIANGLE_STRIP:
+		case GL_TRIANGLE_FAN:
+			return vertices > 2 ? vertices - 2 : 0;
+		default:
+			return 0;
+		}
+	}
+
+	void writeCounts(std::ostream& out, const uint64_t* counts)
+	{
+		out << "{";
+		for (int s = 0; s < STAT_COUNT; s++)
+			out << (s > 0 ? ", " : "") << "\"" << kStatNames[s] << "\": " << counts[s];
+		out << "}";
+	}
+}
+
+void RenderStats::add(RenderStat stat, uint64_t amount)
+{
+	current.counts[currentScope][stat] += amount;
+}
+
+void RenderStats::addDraw(GLenum topology, uint64_t vertices, uint64_t instances)
+{
+	uint64_t* counts = current.counts[currentScope];
+	counts[STAT_DRAW_CALLS]++;
+	counts[STAT_VERTICES] += vertices * instances;
+	counts[STAT_TRIANGLES] += triangleCount(topology, vertices) * instances;
+}
+
+int RenderStats::setScope(int scope)
+{
+	int previous = currentScope;
+	currentScope = (scope >= 0 && scope < kScopeCount) ? scope : kOtherScope;
+	return previous;
+}
+
+int RenderStats::getScope()
+{
+	return currentScope;
+}
+
+void RenderStats::endFrame()
+{
+	finished = current;
+	current = Counts();
+	frames++;
+}
+
+uint64_t RenderStats::get(int scope, RenderStat stat)
+{
+	return finished.counts[scope][stat];
+}
+
+uint64_t RenderStats::getTotal(RenderStat stat)
+{
+	uint64_t total = 0;
+	for (int s = 0; s < kScopeCount; s++)
+		total += finished.counts[s][stat];
+	return total;
+}
+
+const char* RenderStats::getStatName(RenderStat stat)
+{
+	return kStatNames[stat];
+}
+
+const char* RenderStats::getScopeName(int scope)
+{
+	return kScopeNames[scope];
+}
+
+bool RenderStats::writeJson(const std::string& filename)
+{
+	std::ofstream out(filename);
+	if (!out)
+		return false;
+
+	writeJson(out);
+	out << "\n";
+	return static_cast<bool>(out);
+}
+
+void RenderStats::writeJson(std::ostream& out)
+{
+	uint64_t totals[STAT_COUNT];
+	for (int s = 0; s < STAT_COUNT; s++)
+		totals[s] = getTotal(static_cast<RenderStat>(s));
+
+	out << "{\n\t\"frame\": " << frames << ",\n\t\"total\": ";
+	writeCounts(out, totals);
+	out << ",\n\t\"scopes\": {";
+	for (int scope = 0; scope < kScopeCount; scope++)
+	{
+		out << (scope > 0 ? ",\n" : "\n") << "\t\t\"" << kScopeNames[scope] << "\": ";
+		writeCounts(out, finished.counts[scope]);
+	}
+	out << "\n\t}\n}";
+}
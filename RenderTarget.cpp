@@ -0,0 +1,104 @@
+#include "RenderTarget.h"
+#include "GLState.h"
+
+RenderTarget::RenderTarget()
+{}
+
+RenderTarget::~RenderTarget()
+{
+	destroy();
+}
+
+bool RenderTarget::resize(int width, int height)
+{
+	if (width == mWidth && height == mHeight && mFramebuffer != 0)
+		return false;
+
+	destroy();
+
+	mWidth = width;
+	mHeight = height;
+	if (width <= 0 || height <= 0)
+		return true;
+
+	// colour texture, sampled or blitted by the caller
+	glGenTextures(1, &mColorTexture);
+	GLState::bindTexture(GL_TEXTURE_2D, mColorTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	GLState::bindTexture(GL_TEXTURE_2D, 0);
+
+	// depth/stencil in the same format as the window so it can be blitted
+	glGenRenderbuffers(1, &mDepthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, mDepthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &mFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mColorTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, mDepthRenderbuffer);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "Framebuffer is incomplete" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	return true;
+}
+
+void RenderTarget::bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glViewport(0, 0, mWidth, mHeight);
+}
+
+void RenderTarget::blitTo(int x, int y, GLuint framebuffer)
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, mFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+
+	// depth must be copied with nearest filtering, so copy everything that way
+	glBlitFramebuffer(0, 0, mWidth, mHeight, x, y, x + mWidth, y + mHeight,
+		GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::blitColorTo(int srcX, int srcY, int srcWidth, int srcHeight,
+	int x, int y, int width, int height, GLuint framebuffer)
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, mFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+
+	glBlitFramebuffer(srcX, srcY, srcX + srcWidth, srcY + srcHeight, x, y, x + width, y + height,
+		GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::destroy()
+{
+	if (mFramebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &mFramebuffer);
+		mFramebuffer = 0;
+	}
+	if (mColorTexture != 0)
+	{
+		glDeleteTextures(1, &mColorTexture);
+		GLState::textureDeleted(mColorTexture);
+		mColorTexture = 0;
+	}
+	if (mDepthRenderbuffer != 0)
+	{
+		glDeleteRenderbuffers(1, &mDepthRenderbuffer);
+		mDepthRenderbuffer = 0;
+	}
+}
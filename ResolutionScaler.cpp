@@ -0,0 +1,59 @@
+#include "ResolutionScaler.h"
+
+#include <algorithm>
+#include <cmath>
+
+// weight of a new measurement in the smoothed GPU time
+static const float kSmoothing = 0.2f;
+// fraction of the way to the ideal scale taken per update
+static const float kGain = 0.5f;
+// the scale only rises while the time is below this fraction of the budget
+static const float kHeadroom = 0.8f;
+// scales are multiples of this step
+static const float kStep = 1.0f / 32.0f;
+
+ResolutionScaler::ResolutionScaler()
+{}
+
+ResolutionScaler::~ResolutionScaler()
+{}
+
+void ResolutionScaler::setRange(float minScale, float maxScale)
+{
+	mMinScale = minScale;
+	mMaxScale = std::max(minScale, maxScale);
+	mScale = std::min(std::max(mScale, mMinScale), mMaxScale);
+}
+
+float ResolutionScaler::update(float gpuTime)
+{
+	if (gpuTime <= 0.0f || mBudget <= 0.0f)
+		return mScale;
+
+	mSmoothedTime = (mSmoothedTime > 0.0f) ? mSmoothedTime + kSmoothing * (gpuTime - mSmoothedTime) : gpuTime;
+
+	// inside the band between the headroom and the budget the scale stays put
+	if (mSmoothedTime <= mBudget && mSmoothedTime >= mBudget * kHeadroom)
+		return mScale;
+
+	float ideal = mScale * std::sqrt(mBudget / mSmoothedTime);
+	ideal = std::min(std::max(ideal, mMinScale), mMaxScale);
+
+	// move part of the way, at least one step
+	float scale = std::round((mScale + kGain * (ideal - mScale)) / kStep) * kStep;
+	if (scale == mScale && std::fabs(ideal - mScale) >= kStep)
+		scale += (ideal > mScale) ? kStep : -kStep;
+
+	scale = std::min(std::max(scale, mMinScale), mMaxScale);
+
+	// measurements arrive a few frames late, so predict the time at the new scale
+	mSmoothedTime *= (scale * scale) / (mScale * mScale);
+	mScale = scale;
+	return mScale;
+}
+
+void ResolutionScaler::reset()
+{
+	mScale = mMaxScale;
+	mSmoothedTime = 0.0f;
+}
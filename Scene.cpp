@@ -0,0 +1,208 @@
+#include "Scene.h"
+#include "Transform.h"
+#include "Profiler.h"
+
+#include <chrono>
+
+// entities per job
+static const size_t kTransformGrainSize = 1024;
+static const size_t kBoundsGrainSize = 1024;
+
+// updates without movement before a dynamic renderable is treated as static again
+static const uint32_t kStaticUpdates = 120;
+
+Scene::Scene()
+{}
+
+Scene::~Scene()
+{}
+
+Entity Scene::createEntity(Entity parent)
+{
+	Entity entity = static_cast<Entity>(mParent.size());
+
+	mPosition.push_back(glm::vec3(0.0f));
+	mRotation.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+	mScale.push_back(glm::vec3(1.0f));
+	mParent.push_back(parent);
+	mLocalDirty.push_back(1);
+	mWorldChanged.push_back(0);
+	mWorldMatrix.push_back(glm::mat4(1.0f));
+	mNormalMatrix.push_back(glm::mat3(1.0f));
+	mVersion.push_back(0);
+
+	// children are one level below their parent
+	uint32_t depth = (parent == kNoEntity) ? 0 : mDepth[parent] + 1;
+	mDepth.push_back(depth);
+	if (mLevels.size() <= depth)
+		mLevels.resize(depth + 1);
+	mLevels[depth].push_back(entity);
+
+	return entity;
+}
+
+void Scene::setLocalTransform(Entity entity, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+	mPosition[entity] = position;
+	mRotation[entity] = rotation;
+	mScale[entity] = scale;
+	mLocalDirty[entity] = 1;
+}
+
+void Scene::setPosition(Entity entity, const glm::vec3& position)
+{
+	mPosition[entity] = position;
+	mLocalDirty[entity] = 1;
+}
+
+void Scene::setRotation(Entity entity, const glm::quat& rotation)
+{
+	mRotation[entity] = rotation;
+	mLocalDirty[entity] = 1;
+}
+
+void Scene::setScale(Entity entity, const glm::vec3& scale)
+{
+	mScale[entity] = scale;
+	mLocalDirty[entity] = 1;
+}
+
+int Scene::addRenderable(Entity entity, ShaderProgram* program, SimpleModel* model, GLenum topology)
+{
+	mRenderEntity.push_back(entity);
+	mRenderProgram.push_back(program);
+	mRenderModel.push_back(model);
+	mRenderTopology.push_back(topology);
+	mRenderStatic.push_back(1);
+	mRenderLastMoved.push_back(0);
+	mStaticVersion++;
+
+	// bounds are filled in by the next update
+	mBounds.add(glm::vec3(0.0f), 0.0f);
+	mLocalDirty[entity] = 1;
+
+	return static_cast<int>(mRenderEntity.size()) - 1;
+}
+
+int Scene::addLight(Entity entity, const Light& light)
+{
+	mLightEntity.push_back(entity);
+	mLights.push_back(light);
+	mLocalDirty[entity] = 1;
+
+	return static_cast<int>(mLights.size()) - 1;
+}
+
+void Scene::update()
+{
+	PROFILE_ZONE("Scene::update");
+	auto startTime = std::chrono::steady_clock::now();
+
+	// transforms, level by level so that parents are always done before their children
+	for (size_t level = 0; level < mLevels.size(); level++)
+	{
+		const std::vector<Entity>& entities = mLevels[level];
+		parallelFor(entities.size(), kTransformGrainSize, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+				updateTransform(entities[i]);
+		});
+	}
+
+	mUpdateCount++;
+
+	// world bounding spheres of moved renderables, and which renderables are static
+	std::atomic<bool> staticChanged(false);
+	parallelFor(mRenderEntity.size(), kBoundsGrainSize, [&](size_t begin, size_t end)
+	{
+		bool changed = false;
+		for (size_t i = begin; i < end; i++)
+		{
+			Entity entity = mRenderEntity[i];
+			if (!mWorldChanged[entity])
+			{
+				// settled down again
+				if (!mRenderStatic[i] && mUpdateCount - mRenderLastMoved[i] > kStaticUpdates)
+				{
+					mRenderStatic[i] = 1;
+					changed = true;
+				}
+				continue;
+			}
+
+			const Mesh* mesh = mRenderModel[i]->GetMesh();
+			mBounds.update(static_cast<int>(i), mesh->sphereCenter, mesh->sphereRadius, mWorldMatrix[entity]);
+
+			// the first placement keeps the renderable static, later moves make it dynamic
+			if (mVersion[entity] > 1)
+			{
+				mRenderLastMoved[i] = mUpdateCount;
+				if (mRenderStatic[i])
+					mRenderStatic[i] = 0;
+				else
+					continue;
+			}
+			changed = true;
+		}
+
+		if (changed)
+			staticChanged = true;
+	});
+
+	if (staticChanged)
+		mStaticVersion++;
+
+	// lights follow their entity
+	for (size_t i = 0; i < mLights.size(); i++)
+	{
+		Entity entity = mLightEntity[i];
+		if (!mWorldChanged[entity])
+			continue;
+
+		mLights[i].pos = glm::vec3(mWorldMatrix[entity][3]);
+		mLights[i].dir = glm::normalize(-glm::vec3(mWorldMatrix[entity][2]));
+		mLightVersion++;
+	}
+
+	std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+	mUpdateTime = elapsed.count();
+}
+
+void Scene::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& function)
+{
+	if (mJobs != nullptr)
+		mJobs->parallelFor(count, grainSize, function);
+	else if (count > 0)
+		function(0, count);
+}
+
+void Scene::updateTransform(Entity entity)
+{
+	Entity parent = mParent[entity];
+	bool changed = mLocalDirty[entity] || (parent != kNoEntity && mWorldChanged[parent]);
+
+	mWorldChanged[entity] = changed;
+	if (!changed)
+		return;
+
+	mLocalDirty[entity] = 0;
+
+	// local matrices straight from translation, rotation and scale
+	glm::mat4 localMatrix;
+	glm::mat3 localNormalMatrix;
+	buildTransformMatrices(mPosition[entity], mRotation[entity], mScale[entity], localMatrix, localNormalMatrix);
+
+	// the inverse transpose of a product is the product of the inverse transposes
+	if (parent == kNoEntity)
+	{
+		mWorldMatrix[entity] = localMatrix;
+		mNormalMatrix[entity] = localNormalMatrix;
+	}
+	else
+	{
+		mWorldMatrix[entity] = mWorldMatrix[parent] * localMatrix;
+		mNormalMatrix[entity] = mNormalMatrix[parent] * localNormalMatrix;
+	}
+
+	mVersion[entity]++;
+}
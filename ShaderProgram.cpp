@@ -1,216 +1,269 @@
-#include "ShaderProgram.h"
-
-ShaderProgram::ShaderProgram() : mProgramID(0)
-{}
-
-ShaderProgram::~ShaderProgram()
-{
-	// check if shader program exists
-	if (mProgramID != 0)
-	{
-		// delete the shader program
-		glDeleteProgram(mProgramID);
-	}
-}
-
-// compile and link a vertex and fragment shader pair
-void ShaderProgram::compileAndLink(const std::string vShaderFilename, const std::string fShaderFilename)
-{
-	GLint status;	// used for checking compile and link status
-
-/****************************************************************
- * Step 1: read vertex and fragment shader source code from files
- ****************************************************************/
-	std::string vShaderString;	// to store vertex shader code
-	std::string fShaderString;	// to store fragment shader code
-	std::ifstream vShaderFile(vShaderFilename, std::ios::in); 	// open file
-	std::ifstream fShaderFile(fShaderFilename, std::ios::in); 	// open file
-
-	// if file successfully opened, get the shader source code
-	if (vShaderFile.is_open())
-	{
-		std::stringstream stream;
-		stream << vShaderFile.rdbuf();	// read buffer contents
-		vShaderString = stream.str();	// convert stream into string
-		vShaderFile.close();			// close file
-	}
-	else
-	{
-		// output error message and exit
-		std::cerr << "Failed to open: " << vShaderFilename << std::endl;
-		exit(EXIT_FAILURE);
-	}
-
-	// if file successfully opened, get the shader source code
-	if (fShaderFile.is_open())
-	{
-		std::stringstream stream;
-		stream << fShaderFile.rdbuf();	// read buffer contents
-		fShaderString = stream.str();	// convert stream into string
-		fShaderFile.close();			// close file
-	}
-	else
-	{
-		// output error message and exit
-		std::cerr << "Failed to open: " << fShaderFilename << std::endl;
-		exit(EXIT_FAILURE);
-	}
-
-	/****************************************************************
-	 * Step 2: Create and compile shader objects
-	 ****************************************************************/
-	 // create shader objects
-	GLuint vShaderID = glCreateShader(GL_VERTEX_SHADER);
-	GLuint fShaderID = glCreateShader(GL_FRAGMENT_SHADER);
-
-	// provide source code for shaders
-	const GLchar* vShaderCode = vShaderString.c_str();
-	const GLchar* fShaderCode = fShaderString.c_str();
-	glShaderSource(vShaderID, 1, &vShaderCode, nullptr);
-	glShaderSource(fShaderID, 1, &fShaderCode, nullptr);
-
-	// compile shaders
-	glCompileShader(vShaderID);
-	glCompileShader(fShaderID);
-
-	// check vertex shader compile status
-	status = GL_FALSE;
-	glGetShaderiv(vShaderID, GL_COMPILE_STATUS, &status);
-
-	if (status == GL_FALSE)
-	{
-		// output error message
-		std::cerr << "Failed to compile " << vShaderFilename << std::endl;
-
-		// output error log
-		int infoLogLength;
-		glGetShaderiv(vShaderID, GL_INFO_LOG_LENGTH, &infoLogLength);
-		std::string errorMessage(infoLogLength, ' ');
-		glGetShaderInfoLog(vShaderID, infoLogLength, nullptr, &errorMessage[0]);
-		std::cerr << errorMessage << std::endl;
-
-		exit(EXIT_FAILURE);
-	}
-
-	// check fragment shader compile status
-	status = GL_FALSE;
-	glGetShaderiv(fShaderID, GL_COMPILE_STATUS, &status);
-
-	if (status == GL_FALSE)
-	{
-		// output error message
-		std::cerr << "Failed to compile " << fShaderFilename << std::endl;
-
-		// output error log
-		int infoLogLength;
-		glGetShaderiv(fShaderID, GL_INFO_LOG_LENGTH, &infoLogLength);
-		std::string errorMessage(infoLogLength, ' ');
-		glGetShaderInfoLog(fShaderID, infoLogLength, nullptr, &errorMessage[0]);
-		std::cerr << errorMessage << std::endl;
-
-		exit(EXIT_FAILURE);
-	}
-
-	/****************************************************************
-	 * Step 3: Attach shaders to program object and link
-	 ****************************************************************/
-	 // create program object
-	mProgramID = glCreateProgram();
-
-	// attach shaders to the program object
-	glAttachShader(mProgramID, vShaderID);
-	glAttachShader(mProgramID, fShaderID);
-
-	// link program object
-	glLinkProgram(mProgramID);
-
-	// check link status
-	status = GL_FALSE;
-	glGetProgramiv(mProgramID, GL_LINK_STATUS, &status);
-
-	if (status == GL_FALSE)
-	{
-		// output error message
-		std::cerr << "Failed to link shader program." << std::endl;
-
-		// output error log
-		int infoLogLength;
-		glGetShaderiv(mProgramID, GL_INFO_LOG_LENGTH, &infoLogLength);
-		std::string errorMessage(infoLogLength, ' ');
-		glGetShaderInfoLog(mProgramID, infoLogLength, nullptr, &errorMessage[0]);
-		std::cerr << errorMessage << std::endl;
-
-		exit(EXIT_FAILURE);
-	}
-
-	// flag shaders for deletion (will not actually be deleted until detached from program)
-	glDeleteShader(vShaderID);
-	glDeleteShader(fShaderID);
-}
-
-// use the shader program
-void ShaderProgram::use()
-{
-	// use the shader program
-	glUseProgram(mProgramID);
-}
-
-void ShaderProgram::setUniform(const char* name, const glm::vec2& vector)
-{
-	glUniform2fv(getUniformLocation(name), 1, &vector[0]);
-}
-
-void ShaderProgram::setUniform(const char* name, const glm::vec3& vector)
-{
-	glUniform3fv(getUniformLocation(name), 1, &vector[0]);
-}
-
-void ShaderProgram::setUniform(const char* name, const glm::vec4& vector)
-{
-	glUniform4fv(getUniformLocation(name), 1, &vector[0]);
-}
-
-void ShaderProgram::setUniform(const char* name, const glm::mat3& matrix)
-{
-	glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &matrix[0][0]);
-}
-
-void ShaderProgram::setUniform(const char* name, const glm::mat4& matrix)
-{
-	glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &matrix[0][0]);
-}
-
-void ShaderProgram::setUniform(const char* name, float value)
-{
-	glUniform1f(getUniformLocation(name), value);
-}
-
-void ShaderProgram::setUniform(const char* name, int value)
-{
-	glUniform1i(getUniformLocation(name), value);
-}
-
-void ShaderProgram::setUniform(const char* name, bool value)
-{
-	glUniform1i(getUniformLocation(name), value);
-}
-
-// get uniform variable locations
-GLint ShaderProgram::getUniformLocation(const char* name)
-{
-	// find whether location already stored
-	auto position = mUniformLocations.find(name);
-
-	// if not stored
-	if (position == mUniformLocations.end()) {
-		// find the uniform's location
-		GLint location = glGetUniformLocation(mProgramID, name);
-
-		// store location in map
-		mUniformLocations[name] = location;
-		return location;
-	}
-
-	// return uniform's location
-	return position->second;
+#include "ShaderProgram.h"
+#include "GLState.h"
+#include "RenderStats.h"
+
+#include <set>
+
+namespace
+{
+	// program names live until exit, so profilers can keep the pointers
+	const char* internName(const std::string& name)
+	{
+		static std::set<std::string> names;
+		return names.insert(name).first->c_str();
+	}
+}
+
+ShaderProgram::ShaderProgram() : mProgramID(0)
+{}
+
+ShaderProgram::~ShaderProgram()
+{
+	// check if shader program exists
+	if (mProgramID != 0)
+	{
+		// delete the shader program
+		glDeleteProgram(mProgramID);
+		GLState::programDeleted(mProgramID);
+	}
+}
+
+// compile and link a vertex and fragment shader pair
+void ShaderProgram::compileAndLink(const std::string vShaderFilename, const std::string fShaderFilename)
+{
+	/****************************************************************
+	 * Step 1: read, create and compile shader objects
+	 ****************************************************************/
+	GLuint vShaderID = compileShader(GL_VERTEX_SHADER, vShaderFilename);
+	GLuint fShaderID = compileShader(GL_FRAGMENT_SHADER, fShaderFilename);
+
+	/****************************************************************
+	 * Step 2: Attach shaders to program object and link
+	 ****************************************************************/
+	GLuint shaderIDs[] = { vShaderID, fShaderID };
+	link(shaderIDs, 2);
+	setName(vShaderFilename, fShaderFilename);
+}
+
+// compile and link a vertex, geometry and fragment shader
+void ShaderProgram::compileAndLink(const std::string vShaderFilename, const std::string gShaderFilename, const std::string fShaderFilename)
+{
+	/****************************************************************
+	 * Step 1: read, create and compile shader objects
+	 ****************************************************************/
+	GLuint vShaderID = compileShader(GL_VERTEX_SHADER, vShaderFilename);
+	GLuint gShaderID = compileShader(GL_GEOMETRY_SHADER, gShaderFilename);
+	GLuint fShaderID = compileShader(GL_FRAGMENT_SHADER, fShaderFilename);
+
+	/****************************************************************
+	 * Step 2: Attach shaders to program object and link
+	 ****************************************************************/
+	GLuint shaderIDs[] = { vShaderID, gShaderID, fShaderID };
+	link(shaderIDs, 3);
+	setName(vShaderFilename, fShaderFilename);
+}
+
+// read shader source code from a file and compile it
+GLuint ShaderProgram::compileShader(GLenum type, const std::string& filename)
+{
+	GLint status;	// used for checking compile status
+
+	std::string shaderString;	// to store shader code
+	std::ifstream shaderFile(filename, std::ios::in); 	// open file
+
+	// if file successfully opened, get the shader source code
+	if (shaderFile.is_open())
+	{
+		std::stringstream stream;
+		stream << shaderFile.rdbuf();	// read buffer contents
+		shaderString = stream.str();	// convert stream into string
+		shaderFile.close();				// close file
+	}
+	else
+	{
+		// output error message and exit
+		std::cerr << "Failed to open: " << filename << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	// create shader object
+	GLuint shaderID = glCreateShader(type);
+
+	// provide source code for shader
+	const GLchar* shaderCode = shaderString.c_str();
+	glShaderSource(shaderID, 1, &shaderCode, nullptr);
+
+	// compile shader
+	glCompileShader(shaderID);
+
+	// check shader compile status
+	status = GL_FALSE;
+	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
+
+	if (status == GL_FALSE)
+	{
+		// output error message
+		std::cerr << "Failed to compile " << filename << std::endl;
+
+		// output error log
+		int infoLogLength;
+		glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &infoLogLength);
+		std::string errorMessage(infoLogLength, ' ');
+		glGetShaderInfoLog(shaderID, infoLogLength, nullptr, &errorMessage[0]);
+		std::cerr << errorMessage << std::endl;
+
+		exit(EXIT_FAILURE);
+	}
+
+	return shaderID;
+}
+
+// attach compiled shaders to a new program object and link it
+void ShaderProgram::link(const GLuint* shaderIDs, int numShaders)
+{
+	GLint status;	// used for checking link status
+
+	// create program object
+	mProgramID = glCreateProgram();
+
+	// attach shaders to the program object
+	for (int i = 0; i < numShaders; i++)
+		glAttachShader(mProgramID, shaderIDs[i]);
+
+	// link program object
+	glLinkProgram(mProgramID);
+
+	// check link status
+	status = GL_FALSE;
+	glGetProgramiv(mProgramID, GL_LINK_STATUS, &status);
+
+	if (status == GL_FALSE)
+	{
+		// output error message
+		std::cerr << "Failed to link shader program." << std::endl;
+
+		// output error log
+		int infoLogLength;
+		glGetProgramiv(mProgramID, GL_INFO_LOG_LENGTH, &infoLogLength);
+		std::string errorMessage(infoLogLength, ' ');
+		glGetProgramInfoLog(mProgramID, infoLogLength, nullptr, &errorMessage[0]);
+		std::cerr << errorMessage << std::endl;
+
+		exit(EXIT_FAILURE);
+	}
+
+	// flag shaders for deletion (will not actually be deleted until detached from program)
+	for (int i = 0; i < numShaders; i++)
+		glDeleteShader(shaderIDs[i]);
+}
+
+// name the program after its shader files without directories and extensions
+void ShaderProgram::setName(const std::string& vShaderFilename, const std::string& fShaderFilename)
+{
+	auto baseName = [](const std::string& filename)
+	{
+		size_t start = filename.find_last_of("/\\");
+		start = (start == std::string::npos) ? 0 : start + 1;
+		size_t end = filename.find_last_of('.');
+		if (end == std::string::npos || end < start)
+			end = filename.size();
+		return filename.substr(start, end - start);
+	};
+
+	std::string vShaderName = baseName(vShaderFilename);
+	std::string fShaderName = baseName(fShaderFilename);
+	mName = internName((vShaderName == fShaderName) ? vShaderName : vShaderName + "+" + fShaderName);
+}
+
+// use the shader program
+void ShaderProgram::use()
+{
+	// use the shader program, unless it already is
+	GLState::useProgram(mProgramID);
+}
+
+void ShaderProgram::setUniform(const char* name, const glm::vec2& vector)
+{
+	RenderStats::add(STAT_UNIFORM_UPLOADS);
+	glUniform2fv(getUniformLocation(name), 1, &vector[0]);
+}
+
+void ShaderProgram::setUniform(const char* name, const glm::vec3& vector)
+{
+	RenderStats::add(STAT_UNIFORM_UPLOADS);
+	glUniform3fv(getUniformLocation(name), 1, &vector[0]);
+}
+
+void ShaderProgram::setUniform(const char* name, const glm::vec4& vector)
+{
+	RenderStats::add(STAT_UNIFORM_UPLOADS);
+	glUniform4fv(getUniformLocation(name), 1, &vector[0]);
+}
+
+void ShaderProgram::setUniform(const char* name, const glm::mat3& matrix)
+{
+	RenderStats::add(STAT_UNIFORM_UPLOADS);
+	glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &matrix[0][0]);
+}
+
+void ShaderProgram::setUniform(const char* name, const glm::mat4& matrix)
+{
+	RenderStats::add(STAT_UNIFORM_UPLOADS);
+	glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &matrix[0][0]);
+}
+
+void ShaderProgram::setUniform(const char* name, float value)
+{
+	RenderStats::add(STAT_UNIFORM_UPLOADS);
+	glUniform1f(getUniformLocation(name), value);
+}
+
+void ShaderProgram::setUniform(const char* name, int value)
+{
+	RenderStats::add(STAT_UNIFORM_UPLOADS);
+	glUniform1i(getUniformLocation(name), value);
+}
+
+void ShaderProgram::setUniform(const char* name, bool value)
+{
+	RenderStats::add(STAT_UNIFORM_UPLOADS);
+	glUniform1i(getUniformLocation(name), value);
+}
+
+void ShaderProgram::setUniform(const char* name, const glm::vec3* vectors, int count)
+{
+	RenderStats::add(STAT_UNIFORM_UPLOADS);
+	glUniform3fv(getUniformLocation(name), count, &vectors[0][0]);
+}
+
+void ShaderProgram::setUniform(const char* name, const glm::vec4* vectors, int count)
+{
+	RenderStats::add(STAT_UNIFORM_UPLOADS);
+	glUniform4fv(getUniformLocation(name), count, &vectors[0][0]);
+}
+
+void ShaderProgram::setUniform(const char* name, const glm::mat4* matrices, int count)
+{
+	RenderStats::add(STAT_UNIFORM_UPLOADS);
+	glUniformMatrix4fv(getUniformLocation(name), count, GL_FALSE, &matrices[0][0][0]);
+}
+
+// get uniform variable locations
+GLint ShaderProgram::getUniformLocation(const char* name)
+{
+	// find whether location already stored
+	auto position = mUniformLocations.find(name);
+
+	// if not stored
+	if (position == mUniformLocations.end()) {
+		// find the uniform's location
+		GLint location = glGetUniformLocation(mProgramID, name);
+
+		// store location in map
+		mUniformLocations[name] = location;
+		return location;
+	}
+
+	// return uniform's location
+	return position->second;
 }
\ No newline at end of file
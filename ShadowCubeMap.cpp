@@ -0,0 +1,182 @@
+#include "ShadowCubeMap.h"
+#include "GLState.h"
+#include "Profiler.h"
+
+// near plane of the face projections
+static const float kNearPlane = 0.05f;
+
+ShadowCubeMap::ShadowCubeMap()
+	: mLightPosition(0.0f)
+{}
+
+ShadowCubeMap::~ShadowCubeMap()
+{
+	if (mFramebuffer != 0)
+		glDeleteFramebuffers(1, &mFramebuffer);
+	if (mTexture != 0)
+	{
+		glDeleteTextures(1, &mTexture);
+		GLState::textureDeleted(mTexture);
+	}
+}
+
+void ShadowCubeMap::create(int size, float farPlane)
+{
+	mSize = size;
+	mFarPlane = farPlane;
+
+	// depth cube map with hardware depth comparison (filtered 2x2 with GL_LINEAR)
+	glGenTextures(1, &mTexture);
+	GLState::bindTexture(GL_TEXTURE_CUBE_MAP, mTexture);
+	for (int face = 0; face < 6; face++)
+	{
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_DEPTH_COMPONENT24, size, size, 0,
+			GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+	}
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	GLState::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+	// depth only framebuffer, faces are attached when rendered
+	glGenFramebuffers(1, &mFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X, mTexture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "Shadow map framebuffer is incomplete" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	invalidate();
+}
+
+void ShadowCubeMap::invalidate()
+{
+	for (int face = 0; face < 6; face++)
+		mFaces[face].valid = false;
+}
+
+void ShadowCubeMap::setupFaces()
+{
+	// cube map face directions and their up vectors
+	static const glm::vec3 kDirections[6] = {
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+	};
+	static const glm::vec3 kUps[6] = {
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+	};
+
+	glm::mat4 projMatrix = glm::perspective(glm::radians(90.0f), 1.0f, kNearPlane, mFarPlane);
+	for (int face = 0; face < 6; face++)
+	{
+		glm::mat4 viewMatrix = glm::lookAt(mLightPosition, mLightPosition + kDirections[face], kUps[face]);
+		mFaces[face].projViewMatrix = projMatrix * viewMatrix;
+		mFaces[face].frustum = extractFrustum(mFaces[face].projViewMatrix);
+	}
+}
+
+int ShadowCubeMap::update(const Light& light, const Scene& scene, ShaderProgram& depthProgram)
+{
+	PROFILE_ZONE("ShadowCubeMap::update");
+	// only point lights cast shadows through the cube map
+	mReady = false;
+	if (mFramebuffer == 0 || light.type != 1)
+		return 0;
+
+	// a moved light changes every face
+	if (light.pos != mLightPosition || !mFaces[0].valid)
+	{
+		mLightPosition = light.pos;
+		setupFaces();
+		invalidate();
+	}
+
+	const size_t count = scene.getRenderableCount();
+	int facesRendered = 0;
+
+	for (int f = 0; f < 6; f++)
+	{
+		Face& face = mFaces[f];
+		scene.getBounds().cull(face.frustum, mVisible);
+
+		// dirty if a caster moved that is inside the face now or was inside when it was rendered
+		bool dirty = !face.valid || face.versions.size() != count;
+		for (size_t i = 0; i < count && !dirty; i++)
+		{
+			uint32_t version = scene.getTransformVersion(scene.getRenderEntity(i));
+			dirty = version != face.versions[i] && (mVisible[i] || face.inside[i]);
+		}
+
+		if (!dirty)
+			continue;
+
+		// render the distance to the light of every caster inside the face
+		if (facesRendered == 0)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+			glViewport(0, 0, mSize, mSize);
+
+			depthProgram.use();
+			depthProgram.setUniform("uLightPosition", mLightPosition);
+			depthProgram.setUniform("uFarPlane", mFarPlane);
+		}
+
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, mTexture, 0);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		depthProgram.setUniform("uProjViewMatrix", face.projViewMatrix);
+
+		face.versions.resize(count);
+		face.inside.resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			Entity entity = scene.getRenderEntity(i);
+			face.versions[i] = scene.getTransformVersion(entity);
+			face.inside[i] = mVisible[i];
+
+			if (!mVisible[i])
+				continue;
+
+			depthProgram.setUniform("uModelMatrix", scene.getWorldMatrix(entity));
+			scene.getRenderModel(i)->drawDepth(scene.getRenderTopology(i));
+		}
+
+		face.valid = true;
+		facesRendered++;
+	}
+
+	if (facesRendered > 0)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		mVersion++;
+	}
+
+	// every face not rendered above was still valid for this light
+	mReady = true;
+	return facesRendered;
+}
+
+void ShadowCubeMap::bind()
+{
+	GLState::bindTexture(kTextureUnit, GL_TEXTURE_CUBE_MAP, mTexture);
+}
+
+void ShadowCubeMap::setUniforms(ShaderProgram& program) const
+{
+	program.setUniform("uShadowsEnabled", mReady);
+	program.setUniform("uShadowMap", kTextureUnit);
+	program.setUniform("uShadowFar", mFarPlane);
+}
@@ -1,222 +1,532 @@
-#include "SimpleModel.h"
-
-SimpleModel::SimpleModel()
-{}
-
-SimpleModel::~SimpleModel()
-{
-	// delete mesh buffers
-	if (mMesh.VBO != 0)
-		glDeleteBuffers(1, &mMesh.VBO);
-	if (mMesh.IBO != 0)
-		glDeleteBuffers(1, &mMesh.IBO);
-	if (mMesh.VAO != 0)
-		glDeleteVertexArrays(1, &mMesh.VAO);
-
-	mIsValid = false;
-}
-
-void SimpleModel::loadModel(const char *filename, bool texture)
-{
-	// Create an instance of the Importer class
-	Assimp::Importer importer;
-
-	// load model file with assimp 
-	const aiScene *scene = importer.ReadFile(filename,
-		aiProcess_Triangulate |
-		aiProcess_GenSmoothNormals |
-		aiProcess_JoinIdenticalVertices);
-
-	// check whether scene was loaded
-	if (!scene)
-	{
-		// output error message and exit
-		std::cerr << "Failed to open: " << filename << std::endl;
-		exit(EXIT_FAILURE);
-	}
-
-	// only loads first mesh
-	if(!texture)
-		LoadMesh(scene->mMeshes[0]);
-	else
-		loadMeshWithTexture(scene->mMeshes[0]);
-
-	// importer's destructor will clean up
-}
-
-void SimpleModel::drawModel(GLenum topology)
-{
-	if (mIsValid)
-	{
-		glBindVertexArray(mMesh.VAO);		// make mesh VAO active
-
-		if (mMesh.numOfIndices != 0)
-			glDrawElements(topology, mMesh.numOfIndices, GL_UNSIGNED_INT, 0);	// render vertices
-		else
-			glDrawArrays(topology, 0, mMesh.numOfVertices);
-	}
-}
-
-void SimpleModel::LoadMesh(const aiMesh *mesh)
-{
-	// mesh data
-	std::vector<VertexNormal> vertices;
-	std::vector<GLint> indices;
-
-	// check if mesh contains vertex coordinates, normals and faces
-	if (!mesh->HasPositions() || !mesh->HasNormals() || !mesh->HasFaces())
-	{
-		mIsValid = false;
-		return;
-	}
-
-	// get vertex data
-	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
-	{
-		VertexNormal vertex;	// for vertex data
-
-		// get vertex position
-		vertex.position[0] = mesh->mVertices[i].x;
-		vertex.position[1] = mesh->mVertices[i].y;
-		vertex.position[2] = mesh->mVertices[i].z;
-
-		// get vertex normal
-		vertex.normal[0] = mesh->mNormals[i].x;
-		vertex.normal[1] = mesh->mNormals[i].y;
-		vertex.normal[2] = mesh->mNormals[i].z;
-
-		// append vertex data
-		vertices.push_back(vertex);
-	}
-
-	// get face data
-	for (unsigned int i = 0; i < mesh->mNumFaces; i++)
-	{
-		for (unsigned int j = 0; j < mesh->mFaces[i].mNumIndices; j++)
-		{
-			// append face index
-			indices.push_back(mesh->mFaces[i].mIndices[j]);
-		}
-	}
-
-	// store total number of indices
-	mMesh.numOfIndices = static_cast<int>(indices.size());
-
-	// generate identifier for VBOs and copy data to GPU
-	glGenBuffers(1, &mMesh.VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, mMesh.VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(VertexNormal) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
-
-	// generate identifier for IBO and copy data to GPU
-	glGenBuffers(1, &mMesh.IBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mMesh.IBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLint) * indices.size(), &indices[0], GL_STATIC_DRAW);
-
-	// generate identifiers for VAO and supply information
-	glGenVertexArrays(1, &mMesh.VAO);
-	glBindVertexArray(mMesh.VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, mMesh.VBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mMesh.IBO);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexNormal), reinterpret_cast<void*>(offsetof(VertexNormal, position)));
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VertexNormal), reinterpret_cast<void*>(offsetof(VertexNormal, normal)));
-
-	// enable vertex attributes
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-
-	// unbind VAO
-	glBindVertexArray(0);
-
-	mIsValid = true;
-}
-
-void SimpleModel::loadMeshWithTexture(const aiMesh* mesh)
-{
-	// mesh data
-	std::vector<VertexNormTex> vertices;
-	std::vector<GLint> indices;
-
-	// check if mesh contains vertex coordinates, normals and faces
-	if (!mesh->HasPositions() || !mesh->HasNormals() || !mesh->HasFaces())
-	{
-		mIsValid = false;
-		return;
-	}
-	// check if mesh contains texture coordinates (i.e. index 0)
-	if (mesh->HasTextureCoords(0))
-	{
-		mMesh.hasTexCoords = true;
-	}
-
-	// get vertex data
-	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
-	{
-		VertexNormTex vertex;	// for vertex data
-
-		// get vertex position
-		vertex.position[0] = mesh->mVertices[i].x;
-		vertex.position[1] = mesh->mVertices[i].y;
-		vertex.position[2] = mesh->mVertices[i].z;
-
-		// get vertex normal
-		vertex.normal[0] = mesh->mNormals[i].x;
-		vertex.normal[1] = mesh->mNormals[i].y;
-		vertex.normal[2] = mesh->mNormals[i].z;
-
-		// get first vertex texture coordinate (i.e. index 0)
-		if (mMesh.hasTexCoords)
-		{
-			vertex.texCoord[0] = mesh->mTextureCoords[0][i].x;
-			vertex.texCoord[1] = mesh->mTextureCoords[0][i].y;
-		}
-		else
-		{
-			vertex.texCoord[0] = vertex.texCoord[1] = 0.0f;
-		}
-
-		// append vertex data
-		vertices.push_back(vertex);
-	}
-
-	// get face data
-	for (unsigned int i = 0; i < mesh->mNumFaces; i++)
-	{
-		for (unsigned int j = 0; j < mesh->mFaces[i].mNumIndices; j++)
-		{
-			// append face index
-			indices.push_back(mesh->mFaces[i].mIndices[j]);
-		}
-	}
-
-	// store total number of indices
-    mMesh.numOfIndices = static_cast<int>(indices.size());
-
-	// generate identifier for VBOs and copy data to GPU
-	glGenBuffers(1, &mMesh.VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, mMesh.VBO);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(VertexNormTex), &vertices[0], GL_STATIC_DRAW);
-
-	// generate identifier for IBO and copy data to GPU
-	glGenBuffers(1, &mMesh.IBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mMesh.IBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLint), &indices[0], GL_STATIC_DRAW);
-
-	// generate identifiers for VAO and supply information
-	glGenVertexArrays(1, &mMesh.VAO);
-	glBindVertexArray(mMesh.VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, mMesh.VBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mMesh.IBO);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexNormTex), reinterpret_cast<void*>(offsetof(VertexNormTex, position)));
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VertexNormTex), reinterpret_cast<void*>(offsetof(VertexNormTex, normal)));
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VertexNormTex), reinterpret_cast<void*>(offsetof(VertexNormTex, texCoord)));
-
-	// enable vertex attributes
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
-
-	// unbind VAO
-	glBindVertexArray(0);
-
-	mIsValid = true;
-}
+#include "SimpleModel.h"
+#include "GLState.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+
+SimpleModel::SimpleModel()
+{}
+
+SimpleModel::~SimpleModel()
+{
+	// delete mesh buffers
+	if (mMesh.VBO != 0)
+		glDeleteBuffers(1, &mMesh.VBO);
+	if (mMesh.IBO != 0)
+		glDeleteBuffers(1, &mMesh.IBO);
+	if (mMesh.VAO != 0)
+	{
+		glDeleteVertexArrays(1, &mMesh.VAO);
+		GLState::vertexArrayDeleted(mMesh.VAO);
+	}
+	if (mMesh.positionVBO != 0)
+		glDeleteBuffers(1, &mMesh.positionVBO);
+	if (mMesh.depthVAO != 0)
+	{
+		glDeleteVertexArrays(1, &mMesh.depthVAO);
+		GLState::vertexArrayDeleted(mMesh.depthVAO);
+	}
+	if (mInstanceVBO != 0)
+		glDeleteBuffers(1, &mInstanceVBO);
+	if (mBoundsVBO != 0)
+		glDeleteBuffers(1, &mBoundsVBO);
+	if (mBoundsIBO != 0)
+		glDeleteBuffers(1, &mBoundsIBO);
+	if (mBoundsVAO != 0)
+	{
+		glDeleteVertexArrays(1, &mBoundsVAO);
+		GLState::vertexArrayDeleted(mBoundsVAO);
+	}
+
+	mIsValid = false;
+}
+
+void SimpleModel::loadModel(const char *filename, bool texture)
+{
+	if (!importModel(filename, texture))
+	{
+		// output error message and exit
+		std::cerr << "Failed to open: " << filename << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	upload();
+}
+
+bool SimpleModel::importModel(const char *filename, bool texture)
+{
+	PROFILE_ZONE("SimpleModel::importModel");
+
+	// Create an instance of the Importer class
+	Assimp::Importer importer;
+
+	// load model file with assimp 
+	const aiScene *scene = importer.ReadFile(filename,
+		aiProcess_Triangulate |
+		aiProcess_GenSmoothNormals |
+		aiProcess_JoinIdenticalVertices);
+
+	// check whether scene was loaded
+	if (!scene || scene->mNumMeshes == 0)
+		return false;
+
+	// only loads first mesh
+	if(!texture)
+		LoadMesh(scene->mMeshes[0]);
+	else
+		loadMeshWithTexture(scene->mMeshes[0]);
+
+	// importer's destructor will clean up
+	return !mPendingVertices.empty();
+}
+
+void SimpleModel::upload()
+{
+	if (mPendingVertices.empty())
+		return;
+
+	PROFILE_ZONE("SimpleModel::upload");
+
+	const GLsizei stride = mPendingStride * sizeof(GLfloat);
+	const int numVertices = static_cast<int>(mPendingVertices.size()) / mPendingStride;
+
+	// generate identifier for VBOs and copy data to GPU
+	glGenBuffers(1, &mMesh.VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, mMesh.VBO);
+	glBufferData(GL_ARRAY_BUFFER, mPendingVertices.size() * sizeof(GLfloat), &mPendingVertices[0], GL_STATIC_DRAW);
+
+	// generate identifier for IBO and copy data to GPU
+	glGenBuffers(1, &mMesh.IBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mMesh.IBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mPendingIndices.size() * sizeof(GLint), &mPendingIndices[0], GL_STATIC_DRAW);
+	RenderStats::add(STAT_BUFFER_BYTES, mPendingVertices.size() * sizeof(GLfloat) + mPendingIndices.size() * sizeof(GLint));
+
+	// position-only stream for depth passes
+	createPositionStream(&mPendingVertices[0], numVertices, mPendingStride);
+
+	// generate identifiers for VAO and supply information
+	glGenVertexArrays(1, &mMesh.VAO);
+	GLState::bindVertexArray(mMesh.VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, mMesh.VBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mMesh.IBO);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(0));
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(3 * sizeof(GLfloat)));
+
+	// enable vertex attributes
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+
+	// texture coordinates follow the normal
+	if (mPendingStride > 6)
+	{
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(6 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(2);
+	}
+
+	// unbind VAO
+	GLState::bindVertexArray(0);
+
+	// free the imported data
+	std::vector<GLfloat>().swap(mPendingVertices);
+	std::vector<GLint>().swap(mPendingIndices);
+
+	mIsValid = true;
+}
+
+void SimpleModel::drawModel(GLenum topology)
+{
+	if (mIsValid)
+	{
+		GLState::bindVertexArray(mMesh.VAO);		// make mesh VAO active
+		RenderStats::addDraw(topology, mMesh.numOfIndices != 0 ? mMesh.numOfIndices : mMesh.numOfVertices);
+
+		if (mMesh.numOfIndices != 0)
+			glDrawElements(topology, mMesh.numOfIndices, GL_UNSIGNED_INT, 0);	// render vertices
+		else
+			glDrawArrays(topology, 0, mMesh.numOfVertices);
+	}
+}
+
+void SimpleModel::computeBounds(const GLfloat* vertexData, int numVertices, int stride)
+{
+	if (numVertices <= 0)
+		return;
+
+	// axis aligned bounding box
+	glm::vec3 aabbMin(vertexData[0], vertexData[1], vertexData[2]);
+	glm::vec3 aabbMax = aabbMin;
+	for (int i = 1; i < numVertices; i++)
+	{
+		const GLfloat* position = vertexData + i * stride;
+		glm::vec3 p(position[0], position[1], position[2]);
+		aabbMin = glm::min(aabbMin, p);
+		aabbMax = glm::max(aabbMax, p);
+	}
+
+	// bounding sphere around the box centre, radius from the farthest vertex
+	glm::vec3 center = (aabbMin + aabbMax) * 0.5f;
+	float radiusSquared = 0.0f;
+	for (int i = 0; i < numVertices; i++)
+	{
+		const GLfloat* position = vertexData + i * stride;
+		glm::vec3 d = glm::vec3(position[0], position[1], position[2]) - center;
+		radiusSquared = glm::max(radiusSquared, glm::dot(d, d));
+	}
+
+	mMesh.aabbMin = aabbMin;
+	mMesh.aabbMax = aabbMax;
+	mMesh.sphereCenter = center;
+	mMesh.sphereRadius = sqrtf(radiusSquared);
+}
+
+void SimpleModel::createPositionStream(const GLfloat* vertexData, int numVertices, int stride)
+{
+	if (numVertices <= 0)
+		return;
+
+	// gather positions so depth-only draws fetch 12 bytes per vertex
+	std::vector<GLfloat> positions(numVertices * 3);
+	for (int i = 0; i < numVertices; i++)
+	{
+		const GLfloat* position = vertexData + i * stride;
+		positions[i * 3 + 0] = position[0];
+		positions[i * 3 + 1] = position[1];
+		positions[i * 3 + 2] = position[2];
+	}
+
+	glGenBuffers(1, &mMesh.positionVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, mMesh.positionVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * positions.size(), positions.data(), GL_STATIC_DRAW);
+	RenderStats::add(STAT_BUFFER_BYTES, sizeof(GLfloat) * positions.size());
+
+	glGenVertexArrays(1, &mMesh.depthVAO);
+	GLState::bindVertexArray(mMesh.depthVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, mMesh.positionVBO);
+	if (mMesh.IBO != 0)
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mMesh.IBO);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
+	glEnableVertexAttribArray(0);
+
+	// unbind VAO
+	GLState::bindVertexArray(0);
+}
+
+void SimpleModel::drawDepth(GLenum topology)
+{
+	if (mIsValid)
+	{
+		GLState::bindVertexArray(mMesh.depthVAO != 0 ? mMesh.depthVAO : mMesh.VAO);
+		DrawVertices(topology, 0);
+	}
+}
+
+void SimpleModel::drawBounds()
+{
+	if (!mIsValid)
+		return;
+
+	if (mBoundsVAO == 0)
+	{
+		// corners of the box, bit 0 = x, bit 1 = y, bit 2 = z
+		GLfloat corners[8 * 3];
+		for (int i = 0; i < 8; i++)
+		{
+			corners[i * 3 + 0] = (i & 1) ? mMesh.aabbMax.x : mMesh.aabbMin.x;
+			corners[i * 3 + 1] = (i & 2) ? mMesh.aabbMax.y : mMesh.aabbMin.y;
+			corners[i * 3 + 2] = (i & 4) ? mMesh.aabbMax.z : mMesh.aabbMin.z;
+		}
+
+		// two triangles per face
+		const GLubyte indices[36] = {
+			0, 2, 1, 1, 2, 3,	// -z
+			4, 5, 6, 5, 7, 6,	// +z
+			0, 1, 4, 1, 5, 4,	// -y
+			2, 6, 3, 3, 6, 7,	// +y
+			0, 4, 2, 2, 4, 6,	// -x
+			1, 3, 5, 3, 7, 5,	// +x
+		};
+
+		glGenVertexArrays(1, &mBoundsVAO);
+		GLState::bindVertexArray(mBoundsVAO);
+
+		glGenBuffers(1, &mBoundsVBO);
+		glBindBuffer(GL_ARRAY_BUFFER, mBoundsVBO);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
+		glEnableVertexAttribArray(0);
+
+		glGenBuffers(1, &mBoundsIBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mBoundsIBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+	}
+
+	GLState::bindVertexArray(mBoundsVAO);
+	RenderStats::addDraw(GL_TRIANGLES, 36);
+	glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, 0);
+}
+
+void SimpleModel::drawDepthInstanced(const InstanceData* instances, int instanceCount, GLenum topology)
+{
+	if (!mIsValid || instanceCount <= 0)
+		return;
+
+	UploadInstances(instances, instanceCount);
+	drawDepthInstanced(mInstanceVBO, 0, instanceCount, topology);
+}
+
+void SimpleModel::drawDepthInstanced(GLuint instanceBuffer, GLintptr offset, int instanceCount, GLenum topology)
+{
+	if (!mIsValid || instanceCount <= 0)
+		return;
+
+	// the position-only VAO keeps an instance divisor of 1
+	if (mMesh.depthVAO == 0)
+	{
+		drawInstanced(instanceBuffer, offset, instanceCount, topology);
+		return;
+	}
+
+	BindInstanceAttributes(mMesh.depthVAO, instanceBuffer, offset);
+	DrawVertices(topology, instanceCount);
+}
+
+void SimpleModel::drawInstanced(const InstanceData* instances, int instanceCount, GLenum topology, int instanceDivisor)
+{
+	if (!mIsValid || instanceCount <= 0)
+		return;
+
+	UploadInstances(instances, instanceCount);
+	drawInstanced(mInstanceVBO, 0, instanceCount, topology, instanceDivisor);
+}
+
+void SimpleModel::drawInstanced(GLuint instanceBuffer, GLintptr offset, int instanceCount, GLenum topology, int instanceDivisor)
+{
+	if (!mIsValid || instanceCount <= 0)
+		return;
+
+	BindInstanceAttributes(mMesh.VAO, instanceBuffer, offset);	// also makes the mesh VAO active
+
+	// advance instance attributes every instanceDivisor instances
+	if (instanceDivisor != mInstanceDivisor)
+	{
+		mInstanceDivisor = instanceDivisor;
+		for (GLuint i = 4; i <= 12; i++)
+			glVertexAttribDivisor(i, instanceDivisor);
+	}
+
+	DrawVertices(topology, instanceCount * instanceDivisor);
+}
+
+void SimpleModel::UploadInstances(const InstanceData* instances, int instanceCount)
+{
+	if (mInstanceVBO == 0)
+		glGenBuffers(1, &mInstanceVBO);
+
+	// upload instance data, reallocating (and orphaning the old storage) when it grows
+	glBindBuffer(GL_ARRAY_BUFFER, mInstanceVBO);
+	if (instanceCount > mInstanceCapacity)
+	{
+		mInstanceCapacity = instanceCount;
+		glBufferData(GL_ARRAY_BUFFER, sizeof(InstanceData) * instanceCount, instances, GL_STREAM_DRAW);
+	}
+	else
+	{
+		glBufferData(GL_ARRAY_BUFFER, sizeof(InstanceData) * mInstanceCapacity, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(InstanceData) * instanceCount, instances);
+	}
+	RenderStats::add(STAT_BUFFER_BYTES, sizeof(InstanceData) * instanceCount);
+}
+
+void SimpleModel::DrawVertices(GLenum topology, int instanceCount)
+{
+	// instanceCount = 0 for a plain draw of the bound VAO
+	RenderStats::addDraw(topology, mMesh.numOfIndices != 0 ? mMesh.numOfIndices : mMesh.numOfVertices,
+		instanceCount == 0 ? 1 : instanceCount);
+
+	if (instanceCount == 0)
+	{
+		if (mMesh.numOfIndices != 0)
+			glDrawElements(topology, mMesh.numOfIndices, GL_UNSIGNED_INT, 0);
+		else
+			glDrawArrays(topology, 0, mMesh.numOfVertices);
+	}
+	else
+	{
+		if (mMesh.numOfIndices != 0)
+			glDrawElementsInstanced(topology, mMesh.numOfIndices, GL_UNSIGNED_INT, 0, instanceCount);
+		else
+			glDrawArraysInstanced(topology, 0, mMesh.numOfVertices, instanceCount);
+	}
+}
+
+void SimpleModel::BindInstanceAttributes(GLuint VAO, GLuint buffer, GLintptr offset)
+{
+	GLState::bindVertexArray(VAO);
+
+	// attribute pointers only change when the data moves to another buffer or offset
+	int slot = (VAO == mMesh.VAO) ? 0 : 1;
+	if (mInstanceSource[slot] == buffer && mInstanceOffset[slot] == offset)
+		return;
+
+	mInstanceSource[slot] = buffer;
+	mInstanceOffset[slot] = offset;
+	SetupInstanceAttributes(VAO, buffer, offset);
+}
+
+void SimpleModel::SetupInstanceAttributes(GLuint VAO, GLuint buffer, GLintptr offset)
+{
+	// the mesh VAO keeps its current divisor, the position-only VAO always uses 1
+	GLuint divisor = (VAO == mMesh.VAO) ? mInstanceDivisor : 1;
+
+	GLState::bindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	// model matrix, one vec4 column per attribute location
+	for (GLuint i = 0; i < 4; i++)
+	{
+		glVertexAttribPointer(4 + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+			reinterpret_cast<void*>(offset + offsetof(InstanceData, modelMatrix) + sizeof(glm::vec4) * i));
+		glEnableVertexAttribArray(4 + i);
+		glVertexAttribDivisor(4 + i, divisor);
+	}
+
+	// normal matrix, one vec3 column per attribute location
+	for (GLuint i = 0; i < 3; i++)
+	{
+		glVertexAttribPointer(8 + i, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+			reinterpret_cast<void*>(offset + offsetof(InstanceData, normalMatrix) + sizeof(glm::vec3) * i));
+		glEnableVertexAttribArray(8 + i);
+		glVertexAttribDivisor(8 + i, divisor);
+	}
+
+	// material index
+	glVertexAttribIPointer(11, 1, GL_INT, sizeof(InstanceData),
+		reinterpret_cast<void*>(offset + offsetof(InstanceData, materialIndex)));
+	glEnableVertexAttribArray(11);
+	glVertexAttribDivisor(11, divisor);
+
+	// view mask
+	glVertexAttribIPointer(12, 1, GL_INT, sizeof(InstanceData),
+		reinterpret_cast<void*>(offset + offsetof(InstanceData, viewMask)));
+	glEnableVertexAttribArray(12);
+	glVertexAttribDivisor(12, divisor);
+
+	// the VAO stays bound for the draw that follows
+}
+
+void SimpleModel::LoadMesh(const aiMesh *mesh)
+{
+	// mesh data
+	std::vector<VertexNormal> vertices;
+	std::vector<GLint> indices;
+
+	// check if mesh contains vertex coordinates, normals and faces
+	if (!mesh->HasPositions() || !mesh->HasNormals() || !mesh->HasFaces())
+		return;
+
+	// get vertex data
+	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+	{
+		VertexNormal vertex;	// for vertex data
+
+		// get vertex position
+		vertex.position[0] = mesh->mVertices[i].x;
+		vertex.position[1] = mesh->mVertices[i].y;
+		vertex.position[2] = mesh->mVertices[i].z;
+
+		// get vertex normal
+		vertex.normal[0] = mesh->mNormals[i].x;
+		vertex.normal[1] = mesh->mNormals[i].y;
+		vertex.normal[2] = mesh->mNormals[i].z;
+
+		// append vertex data
+		vertices.push_back(vertex);
+	}
+
+	// get face data
+	for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+	{
+		for (unsigned int j = 0; j < mesh->mFaces[i].mNumIndices; j++)
+		{
+			// append face index
+			indices.push_back(mesh->mFaces[i].mIndices[j]);
+		}
+	}
+
+	// store total number of indices
+	mMesh.numOfIndices = static_cast<int>(indices.size());
+
+	// bounding volumes for culling
+	computeBounds(vertices[0].position, static_cast<int>(vertices.size()), sizeof(VertexNormal) / sizeof(GLfloat));
+
+	// keep the data for upload()
+	mPendingStride = sizeof(VertexNormal) / sizeof(GLfloat);
+	mPendingVertices.assign(vertices[0].position, vertices[0].position + vertices.size() * mPendingStride);
+	mPendingIndices.swap(indices);
+}
+
+void SimpleModel::loadMeshWithTexture(const aiMesh* mesh)
+{
+	// mesh data
+	std::vector<VertexNormTex> vertices;
+	std::vector<GLint> indices;
+
+	// check if mesh contains vertex coordinates, normals and faces
+	if (!mesh->HasPositions() || !mesh->HasNormals() || !mesh->HasFaces())
+		return;
+	// check if mesh contains texture coordinates (i.e. index 0)
+	if (mesh->HasTextureCoords(0))
+	{
+		mMesh.hasTexCoords = true;
+	}
+
+	// get vertex data
+	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+	{
+		VertexNormTex vertex;	// for vertex data
+
+		// get vertex position
+		vertex.position[0] = mesh->mVertices[i].x;
+		vertex.position[1] = mesh->mVertices[i].y;
+		vertex.position[2] = mesh->mVertices[i].z;
+
+		// get vertex normal
+		vertex.normal[0] = mesh->mNormals[i].x;
+		vertex.normal[1] = mesh->mNormals[i].y;
+		vertex.normal[2] = mesh->mNormals[i].z;
+
+		// get first vertex texture coordinate (i.e. index 0)
+		if (mMesh.hasTexCoords)
+		{
+			vertex.texCoord[0] = mesh->mTextureCoords[0][i].x;
+			vertex.texCoord[1] = mesh->mTextureCoords[0][i].y;
+		}
+		else
+		{
+			vertex.texCoord[0] = vertex.texCoord[1] = 0.0f;
+		}
+
+		// append vertex data
+		vertices.push_back(vertex);
+	}
+
+	// get face data
+	for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+	{
+		for (unsigned int j = 0; j < mesh->mFaces[i].mNumIndices; j++)
+		{
+			// append face index
+			indices.push_back(mesh->mFaces[i].mIndices[j]);
+		}
+	}
+
+	// store total number of indices
+    mMesh.numOfIndices = static_cast<int>(indices.size());
+
+	// bounding volumes for culling
+	computeBounds(vertices[0].position, static_cast<int>(vertices.size()), sizeof(VertexNormTex) / sizeof(GLfloat));
+
+	// keep the data for upload()
+	mPendingStride = sizeof(VertexNormTex) / sizeof(GLfloat);
+	mPendingVertices.assign(vertices[0].position, vertices[0].position + vertices.size() * mPendingStride);
+	mPendingIndices.swap(indices);
+}
@@ -0,0 +1,73 @@
+#include "SimulationThread.h"
+#include "Profiler.h"
+
+#include <chrono>
+
+SimulationThread::SimulationThread()
+	: mStepTime(0.0f), mStepCount(0)
+{}
+
+SimulationThread::~SimulationThread()
+{
+	stop();
+}
+
+void SimulationThread::start(const std::function<void(float)>& step)
+{
+	if (isRunning())
+		return;
+
+	mStep = step;
+	mQuit = false;
+	mStepRequested = true;
+	mThread = std::thread(&SimulationThread::threadLoop, this);
+}
+
+void SimulationThread::stop()
+{
+	if (!isRunning())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mCondition.notify_one();
+	mThread.join();
+}
+
+void SimulationThread::frameConsumed()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStepRequested = true;
+	}
+	mCondition.notify_one();
+}
+
+void SimulationThread::threadLoop()
+{
+	Profiler::setThreadName("Simulation");
+	auto lastStep = std::chrono::steady_clock::now();
+
+	while (true)
+	{
+		// sleep until the renderer wants the next snapshot
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this] { return mQuit || mStepRequested; });
+			if (mQuit)
+				return;
+			mStepRequested = false;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		float seconds = std::chrono::duration<float>(start - lastStep).count();
+		lastStep = start;
+
+		mStep(seconds);
+
+		mStepTime.store(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+		mStepCount++;
+	}
+}
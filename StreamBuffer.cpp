@@ -0,0 +1,129 @@
+#include "StreamBuffer.h"
+#include "GLState.h"
+
+#include <cstring>
+
+// longest single wait for a fence before waiting again, in nanoseconds
+static const GLuint64 kFenceTimeout = 1000000;
+
+StreamBuffer::StreamBuffer()
+{
+	for (int i = 0; i < kFrames; i++)
+		mFences[i] = 0;
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	for (int i = 0; i < kFrames; i++)
+	{
+		if (mFences[i] != 0)
+			glDeleteSync(mFences[i]);
+	}
+
+	if (mBuffer != 0)
+	{
+		if (mMapped != nullptr)
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffer);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		}
+		glDeleteBuffers(1, &mBuffer);
+	}
+}
+
+void StreamBuffer::create(size_t frameSize)
+{
+	mFrameSize = frameSize;
+	GLsizeiptr size = static_cast<GLsizeiptr>(frameSize * kFrames);
+
+	glGenBuffers(1, &mBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffer);
+
+	if (GLState::isVersionAtLeast(4, 4) || GLState::isExtensionSupported("GL_ARB_buffer_storage"))
+	{
+		// immutable storage, mapped for the lifetime of the buffer
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+		mMapped = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+	}
+
+	if (mMapped == nullptr)
+	{
+		glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		mStaging.resize(frameSize);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void StreamBuffer::beginFrame()
+{
+	mUsed = 0;
+	mFlushed = 0;
+
+	GLsync fence = mFences[mFrame];
+	if (fence == 0)
+		return;
+
+	// the GPU is normally done with a region written kFrames frames ago
+	GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if (result == GL_TIMEOUT_EXPIRED)
+	{
+		mWaitCount++;
+		do
+		{
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeout);
+		} while (result == GL_TIMEOUT_EXPIRED);
+	}
+
+	glDeleteSync(fence);
+	mFences[mFrame] = 0;
+}
+
+void* StreamBuffer::allocate(size_t size, size_t alignment, GLintptr& offset)
+{
+	if (mBuffer == 0)
+		return nullptr;
+
+	size_t begin = (mUsed + alignment - 1) / alignment * alignment;
+	if (begin + size > mFrameSize)
+		return nullptr;
+
+	mUsed = begin + size;
+	offset = static_cast<GLintptr>(mFrame * mFrameSize + begin);
+
+	return mMapped != nullptr ? mMapped + offset : mStaging.data() + begin;
+}
+
+void StreamBuffer::flush()
+{
+	// coherent persistent mappings need no flush
+	if (mMapped != nullptr || mUsed <= mFlushed)
+		return;
+
+	// the range is fenced, so the driver need not synchronise or copy
+	GLintptr offset = static_cast<GLintptr>(mFrame * mFrameSize + mFlushed);
+	GLsizeiptr size = static_cast<GLsizeiptr>(mUsed - mFlushed);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffer);
+	void* target = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size,
+		GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	if (target != nullptr)
+	{
+		memcpy(target, mStaging.data() + mFlushed, size);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	mFlushed = mUsed;
+}
+
+void StreamBuffer::endFrame()
+{
+	if (mBuffer == 0)
+		return;
+
+	mFences[mFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	mLastUsage = mUsed;
+	mFrame = (mFrame + 1) % kFrames;
+}
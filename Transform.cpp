@@ -0,0 +1,18 @@
+#include "Transform.h"
+
+void buildTransformMatrices(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale,
+	glm::mat4& worldMatrix, glm::mat3& normalMatrix)
+{
+	glm::mat3 r = glm::mat3_cast(rotation);
+
+	// world = T * R * S, built column by column
+	worldMatrix[0] = glm::vec4(r[0] * scale.x, 0.0f);
+	worldMatrix[1] = glm::vec4(r[1] * scale.y, 0.0f);
+	worldMatrix[2] = glm::vec4(r[2] * scale.z, 0.0f);
+	worldMatrix[3] = glm::vec4(position, 1.0f);
+
+	// only the scale has to be inverted
+	normalMatrix[0] = r[0] / scale.x;
+	normalMatrix[1] = r[1] / scale.y;
+	normalMatrix[2] = r[2] / scale.z;
+}
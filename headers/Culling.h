@@ -0,0 +1,53 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// six normalised planes (left, right, bottom, top, near, far), inside is dot(plane, p) >= 0
+struct Frustum
+{
+	glm::vec4 planes[6];
+};
+
+// extract the frustum planes of a projection * view matrix (perspective or orthographic)
+Frustum extractFrustum(const glm::mat4& projViewMatrix);
+
+/*****************************************************************
+ * tests world space bounding spheres against a frustum
+ *
+ * spheres are stored as structure of arrays and tested 8 (AVX)
+ * or 4 (SSE) at a time, with a scalar loop for the remainder
+ *****************************************************************/
+
+class FrustumCuller
+{
+public:
+	FrustumCuller();
+	~FrustumCuller();
+
+	// remove all spheres
+	void clear();
+	// add a world space sphere, returns its index
+	int add(const glm::vec3& center, float radius);
+	// add a model space sphere transformed by a model matrix, returns its index
+	int add(const glm::vec3& center, float radius, const glm::mat4& modelMatrix);
+	// replace a sphere with a model space sphere transformed by a model matrix
+	void update(int index, const glm::vec3& center, float radius, const glm::mat4& modelMatrix);
+
+	// set visible[i] to 1 for every sphere that intersects the frustum, returns the visible count
+	int cull(const Frustum& frustum, std::vector<uint8_t>& visible) const;
+
+	inline int getCount() const { return static_cast<int>(mRadius.size()); }
+	inline glm::vec3 getCenter(int index) const { return glm::vec3(mCenterX[index], mCenterY[index], mCenterZ[index]); }
+	inline float getRadius(int index) const { return mRadius[index]; }
+
+private:
+	std::vector<float> mCenterX;
+	std::vector<float> mCenterY;
+	std::vector<float> mCenterZ;
+	std::vector<float> mRadius;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef FRAME_HISTOGRAM_H
+#define FRAME_HISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*****************************************************************
+ * fixed memory histogram of durations in the style of
+ * HdrHistogram
+ *
+ * values (microseconds) below kSubBuckets have a bucket each;
+ * above, every power of two is split into kSubBuckets / 2 linear
+ * buckets, so any value is known to within 1 / 128 of itself
+ * however large it is. values from 2^kMaxExponent on share the
+ * last bucket. recording and removing are O(1), which is what
+ * lets a sliding window drop its oldest values
+ *****************************************************************/
+
+class FrameHistogram
+{
+public:
+	static const int kSubBucketBits = 8;
+	static const int kSubBuckets = 1 << kSubBucketBits;
+	static const int kMaxExponent = 36;		// a little over 19 hours in microseconds
+	static const int kBucketCount = kSubBuckets + (kMaxExponent - kSubBucketBits) * (kSubBuckets / 2);
+
+	FrameHistogram();
+
+	void record(uint64_t value);
+	// take back a value recorded earlier
+	void remove(uint64_t value);
+	void clear();
+
+	inline uint64_t getCount() const { return mTotalCount; }
+	// exact, from the sum of the values
+	double getMean() const;
+	// highest value of the bucket holding the given percentile (0 to 100) of the values, 0 if empty
+	uint64_t getPercentile(double percentile) const;
+
+	// buckets, for export
+	inline uint32_t getBucketCount(int bucket) const { return mCounts[bucket]; }
+	static uint64_t getLowestValue(int bucket);
+	static uint64_t getHighestValue(int bucket);
+
+private:
+	uint32_t mCounts[kBucketCount];
+	uint64_t mTotalCount = 0;
+	uint64_t mSum = 0;
+
+	static int bucketIndex(uint64_t value);
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef FRAME_TIME_RECORDER_H
+#define FRAME_TIME_RECORDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "FrameHistogram.h"
+
+/*****************************************************************
+ * distribution of one per-frame time (CPU or GPU)
+ *
+ * every frame goes into a histogram of the whole run and into a
+ * histogram of a sliding window of the last frames, which takes
+ * the oldest frame back out as each new one arrives; a ring of
+ * the window's frames makes that possible and gives its exact
+ * maximum. frames over the budget count as hitches. all memory is
+ * allocated up front
+ *****************************************************************/
+
+class FrameTimeRecorder
+{
+public:
+	static const size_t kDefaultWindowFrames = 600;
+
+	explicit FrameTimeRecorder(const std::string& name, size_t windowFrames = kDefaultWindowFrames);
+
+	void record(float milliseconds);
+	void clear();
+
+	// frames longer than the budget are hitches; only applies to frames recorded after the change
+	inline void setBudget(float milliseconds) { mBudget = milliseconds; }
+	inline float getBudget() const { return mBudget; }
+
+	inline const std::string& getName() const { return mName; }
+	inline size_t getWindowFrames() const { return mWindow.size(); }
+
+	// whole run
+	inline uint64_t getCount() const { return mTotal.getCount(); }
+	inline uint64_t getHitchCount() const { return mHitches; }
+	float getPercentile(double percentile) const;
+	inline float getMax() const { return toMilliseconds(mMax); }
+
+	// sliding window
+	inline uint64_t getWindowCount() const { return mWindowHistogram.getCount(); }
+	inline uint64_t getWindowHitchCount() const { return mWindowHitches; }
+	float getWindowPercentile(double percentile) const;
+	float getWindowMax() const;
+
+	// one row per histogram under the header of writeCsvHeader()
+	static void writeCsvHeader(std::ostream& out);
+	void writeCsv(std::ostream& out) const;
+	// JSON object with the summaries and the non-empty buckets of the whole run
+	void writeJson(std::ostream& out) const;
+
+private:
+	struct WindowFrame
+	{
+		uint64_t value;		// microseconds
+		bool hitch;
+	};
+
+	std::string mName;
+	float mBudget = 1000.0f / 60.0f;
+
+	FrameHistogram mTotal;
+	uint64_t mMax = 0;
+	uint64_t mHitches = 0;
+
+	FrameHistogram mWindowHistogram;
+	std::vector<WindowFrame> mWindow;	// ring of the last frames
+	size_t mWindowNext = 0;
+	uint64_t mWindowHitches = 0;
+
+	static inline float toMilliseconds(uint64_t microseconds) { return microseconds * 1.0e-3f; }
+	void writeSummary(std::ostream& out, const char* scope, const FrameHistogram& histogram, uint64_t hitches, float max) const;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include "utilities.h"
+
+/*****************************************************************
+ * cache of the OpenGL binding and fixed function state
+ *
+ * programs, vertex arrays, texture units and the depth, colour,
+ * blend and cull state are changed through here, and calls that
+ * would set what is already set never reach the driver. the cache
+ * starts out unknown, so the first call of each kind always goes
+ * through; after code that changes state behind its back (the
+ * tweak bar) invalidate() forgets everything
+ *****************************************************************/
+
+class GLState
+{
+public:
+	static const int kMaxTextureUnits = 16;
+
+	static void useProgram(GLuint program);
+	static void bindVertexArray(GLuint vertexArray);
+	static void activeTexture(int unit);
+	// bind a texture to the active unit
+	static void bindTexture(GLenum target, GLuint texture);
+	// bind a texture to a unit, only making the unit active if the binding changes
+	static void bindTexture(int unit, GLenum target, GLuint texture);
+
+	static void setDepthTest(bool enabled);
+	static void setDepthFunc(GLenum func);
+	static void setDepthMask(bool write);
+	static void setColorMask(bool write);
+	static void setBlend(bool enabled);
+	static void setBlendFunc(GLenum sourceFactor, GLenum destinationFactor);
+	static void setCullFace(bool enabled);
+	static void setCullFaceMode(GLenum mode);
+
+	// deleting a bound object resets the binding to 0, and its name may be reused
+	static void programDeleted(GLuint program);
+	static void vertexArrayDeleted(GLuint vertexArray);
+	static void textureDeleted(GLuint texture);
+
+	// forget all cached state
+	static void invalidate();
+
+	// with filtering off every call is passed on, for comparison
+	static void setFiltering(bool enabled);
+	static bool getFiltering();
+
+	// calls passed on to OpenGL and calls filtered out since the last resetCounters()
+	static void resetCounters();
+	static int getIssuedCount();
+	static int getSkippedCount();
+
+	// capabilities of the current context, asked of OpenGL itself: GLEW's version and extension
+	// flags are not reliable on a core profile context
+	static bool isVersionAtLeast(int major, int minor);
+	static bool isExtensionSupported(const char* name);
+};
+
+#endif
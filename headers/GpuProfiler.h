@@ -0,0 +1,85 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "utilities.h"
+
+// time the GPU commands of the rest of the enclosing scope; name must be a string literal (or outlive the profiler)
+#define PROFILE_GPU_CONCAT_INNER(a, b) a##b
+#define PROFILE_GPU_CONCAT(a, b) PROFILE_GPU_CONCAT_INNER(a, b)
+#define PROFILE_GPU(name) GpuProfileZone PROFILE_GPU_CONCAT(gpuProfileZone, __LINE__)(name)
+
+/*****************************************************************
+ * GPU zone profiler
+ *
+ * every zone puts a GL_TIMESTAMP query into the command stream
+ * where it begins and where it ends. the queries of a frame come
+ * from a ring of kFrames sets, and a set is only read when the
+ * frame comes round again, so results arrive a few frames late
+ * and the CPU never waits on them; a frame whose last query still
+ * is not available by then is dropped. timestamps rather than
+ * GL_TIME_ELAPSED are used so zones can nest
+ *
+ * the results are folded into a rolling per-zone average, and
+ * passed to the CPU profiler on a GPU track of the trace, moved
+ * onto its clock by a GPU and CPU time taken together at the
+ * start of the frame
+ *
+ * GL thread only
+ *****************************************************************/
+
+class GpuProfiler
+{
+public:
+	static const int kFrames = 4;			// frames in flight before the results are read
+	static const int kMaxZones = 256;		// per frame, later zones are not timed
+	static const int kRollingFrames = 60;
+
+	static void setEnabled(bool enabled);
+	static bool isEnabled();
+
+	// read the oldest frame of the ring and start timing a new one
+	static void beginFrame();
+	// close the frame, its zones are read kFrames frames later
+	static void endFrame();
+
+	// begin a zone, returns its handle, or -1 if it is not timed
+	static int beginZone(const char* name);
+	static void endZone(int zone);
+
+	// zones seen so far and their average GPU milliseconds per frame over the last kRollingFrames results
+	static size_t getZoneCount();
+	static const char* getZoneName(size_t zone);
+	static float getZoneTime(size_t zone);
+	// GPU milliseconds of a zone in the last frame read, 0 if it was not timed in that frame
+	static float getLastTime(const char* name);
+	// frames whose results were not available in time
+	static int getDroppedFrames();
+	// frames read so far, and the GPU time of the last one from the start of its first zone to the end of its last
+	static uint64_t getFramesRead();
+	static float getFrameTime();
+};
+
+// times the GPU commands from its construction to the end of its scope
+class GpuProfileZone
+{
+public:
+	explicit GpuProfileZone(const char* name)
+		: mZone(GpuProfiler::beginZone(name))
+	{}
+
+	~GpuProfileZone()
+	{
+		GpuProfiler::endZone(mZone);
+	}
+
+private:
+	int mZone;
+
+	GpuProfileZone(const GpuProfileZone&);
+	GpuProfileZone& operator=(const GpuProfileZone&);
+};
+
+#endif
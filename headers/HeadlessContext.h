@@ -0,0 +1,39 @@
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+/*****************************************************************
+ * OpenGL context without a window, for benchmarks on machines
+ * without a display
+ *
+ * uses EGL on Linux: the Mesa surfaceless platform where the
+ * driver offers it (software rendering with llvmpipe works), the
+ * default display otherwise. the context is OpenGL 3.3 core and
+ * renders into a pbuffer, which stands in for the window's
+ * default framebuffer, so framebuffer 0 works as usual and never
+ * waits for vsync. other platforms cannot create one
+ *****************************************************************/
+
+class HeadlessContext
+{
+public:
+	HeadlessContext();
+	~HeadlessContext();
+
+	// create the context with a width x height default framebuffer and make it current,
+	// false (with the reason on std::cerr) if that is not possible
+	bool create(int width, int height);
+	void destroy();
+
+	inline bool isCreated() const { return mContext != nullptr; }
+
+private:
+	// EGL handles, kept opaque so users need no EGL headers
+	void* mDisplay = nullptr;
+	void* mSurface = nullptr;
+	void* mContext = nullptr;
+
+	HeadlessContext(const HeadlessContext&);
+	HeadlessContext& operator=(const HeadlessContext&);
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef JOB_BENCHMARK_H
+#define JOB_BENCHMARK_H
+
+#include <ostream>
+
+/*****************************************************************
+ * microbenchmarks of the job system
+ *
+ * measures the cost of scheduling an empty job, of a dependency
+ * chain of continuations, and how a compute bound parallelFor
+ * scales from 1 to all hardware threads
+ *****************************************************************/
+
+void RunJobBenchmarks(std::ostream& out);
+
+#endif
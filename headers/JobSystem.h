@@ -0,0 +1,131 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+// counts unfinished jobs; jobs can be scheduled to run once a counter reaches zero.
+// a counter jobs were added to must outlive them, i.e. be waited on before it is destroyed
+class JobCounter
+{
+public:
+	JobCounter() : mCount(0) {}
+
+	inline bool isDone() const { return mCount.load(std::memory_order_acquire) == 0; }
+	inline int getCount() const { return mCount.load(std::memory_order_relaxed); }
+
+private:
+	friend class JobSystem;
+
+	std::atomic<int> mCount;
+	std::mutex mMutex;	// guards mContinuations
+	std::vector<std::pair<std::function<void()>, JobCounter*>> mContinuations;
+
+	JobCounter(const JobCounter&);
+	JobCounter& operator=(const JobCounter&);
+};
+
+/*****************************************************************
+ * work-stealing job scheduler
+ *
+ * every worker thread and the main thread own a deque of jobs;
+ * they push and pop at the back of their own deque and steal from
+ * the front of the others when it runs dry, so recently spawned
+ * (cache-warm) jobs run first locally and the oldest, usually
+ * largest, jobs are the ones that move. threads waiting on a
+ * counter keep running jobs instead of blocking, which makes
+ * nested parallelism safe. jobs that need the GL context are
+ * queued for the main thread and run while it waits or when it
+ * calls runMainThreadJobs()
+ *
+ * the thread that creates the job system is its main thread;
+ * jobs spawned from threads it does not know go to the main
+ * thread's deque, where the workers steal them
+ *****************************************************************/
+
+class JobSystem
+{
+public:
+	// numWorkers < 0 uses one worker per hardware thread besides the main thread
+	explicit JobSystem(int numWorkers = -1);
+	~JobSystem();
+
+	// run a job on any thread; the counter, if any, counts it until it has finished
+	void run(const std::function<void()>& job, JobCounter* counter = nullptr);
+	// run a job once dependency reaches zero (straight away if it already has)
+	void runAfter(JobCounter& dependency, const std::function<void()>& job, JobCounter* counter = nullptr);
+	// run a job on the main thread, e.g. to create GL objects from data loaded by a worker
+	void runOnMainThread(const std::function<void()>& job, JobCounter* counter = nullptr);
+
+	// run jobs until the counter reaches zero (main thread jobs too, when called on the main thread)
+	void wait(JobCounter& counter);
+	// run the main thread jobs queued so far; main thread only
+	void runMainThreadJobs();
+
+	// call function(begin, end) for chunks of [0, count) no smaller than grainSize, and return
+	// when all are done; the range is split in halves that idle threads steal
+	void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& function);
+
+	// number of threads running jobs, including the main thread
+	inline unsigned getThreadCount() const { return static_cast<unsigned>(mThreads.size()) + 1; }
+	inline bool isMainThread() const { return std::this_thread::get_id() == mMainThread; }
+
+	// jobs run and jobs taken from another thread's deque since the last resetCounters()
+	void resetCounters();
+	inline uint64_t getJobCount() const { return mJobCount.load(std::memory_order_relaxed); }
+	inline uint64_t getStealCount() const { return mStealCount.load(std::memory_order_relaxed); }
+
+private:
+	struct Job
+	{
+		std::function<void()> function;
+		JobCounter* counter = nullptr;
+	};
+
+	struct JobQueue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	std::vector<std::thread> mThreads;
+	std::vector<std::unique_ptr<JobQueue>> mQueues;	// queue 0 belongs to the main thread
+	std::thread::id mMainThread;
+
+	std::mutex mMainMutex;
+	std::vector<Job> mMainJobs;
+
+	// sleeping workers wake up when jobs are queued
+	std::mutex mSleepMutex;
+	std::condition_variable mWakeCondition;
+	std::atomic<int> mQueuedJobs;
+	std::atomic<int> mSleepingWorkers;
+	bool mQuit = false;
+
+	std::atomic<uint64_t> mJobCount;
+	std::atomic<uint64_t> mStealCount;
+
+	int queueIndex() const;
+	void push(Job&& job);
+	bool takeJob(Job& job);
+	bool runOneJob();
+	void execute(Job& job);
+	void finish(JobCounter& counter);
+	void splitRange(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& function,
+		JobCounter& counter);
+	void workerLoop(int index);
+
+	JobSystem(const JobSystem&);
+	JobSystem& operator=(const JobSystem&);
+};
+
+#endif
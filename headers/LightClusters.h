@@ -0,0 +1,95 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include "utilities.h"
+
+// view that lights are assigned for
+struct ClusterView
+{
+	glm::mat4 projViewMatrix;
+	glm::vec3 viewpoint;
+	glm::vec4 viewport;		// x, y, width, height in window pixels
+};
+
+/*****************************************************************
+ * clustered forward lighting
+ *
+ * every view is divided into screen tiles and depth slices
+ * (logarithmic for perspective, linear for orthographic views);
+ * lights are assigned to the clusters their bounding sphere
+ * touches, 4 lights at a time with SSE, and the light data, the
+ * per-cluster offset/count grid and the light index list are
+ * uploaded to texture buffers that the fragment shaders iterate
+ *
+ * grid dimensions must match the constants in the fragment shaders
+ *****************************************************************/
+
+class LightClusters
+{
+public:
+	static const int kTilesX = 16;
+	static const int kTilesY = 9;
+	static const int kSlices = 24;
+	static const int kClusterCount = kTilesX * kTilesY * kSlices;
+	static const int kMaxViews = 4;
+
+	LightClusters();
+	~LightClusters();
+
+	// lights to assign, lights with type 0 are skipped
+	void setLights(const Light* lights, size_t count);
+	// assign the lights to the clusters of every view and upload the result
+	void build(const ClusterView* views, int numViews);
+	// bind the texture buffers (units 2 to 4)
+	void bind();
+	// set samplers and per-view cluster parameters
+	void setUniforms(ShaderProgram& program);
+
+	inline int getActiveLightCount() const { return mActiveLights; }
+	inline int getIndexCount() const { return static_cast<int>(mIndices.size()); }
+	// cost of the last build() in milliseconds
+	inline float getBuildTime() const { return mBuildTime; }
+
+private:
+	// cluster range touched by a light in one view, empty if minX > maxX
+	struct ClusterRange
+	{
+		int16_t minX, maxX;
+		int16_t minY, maxY;
+		int16_t minZ, maxZ;
+	};
+
+	const Light* mLights = nullptr;
+	size_t mLightCount = 0;
+	int mActiveLights = 0;
+	int mNumViews = 0;
+
+	// bounding spheres of the active lights (structure of arrays)
+	std::vector<float> mLightX;
+	std::vector<float> mLightY;
+	std::vector<float> mLightZ;
+	std::vector<float> mLightRadius;
+
+	// data uploaded to the texture buffers
+	std::vector<glm::vec4> mLightData;
+	std::vector<GLuint> mGrid;		// offset and count per cluster
+	std::vector<GLuint> mIndices;
+	std::vector<ClusterRange> mRanges;
+
+	// per-view shader parameters
+	glm::vec4 mViewports[kMaxViews];
+	glm::vec4 mDepthPlanes[kMaxViews];
+	glm::vec3 mDepthParams[kMaxViews];
+
+	// texture buffers: lights, grid, indices
+	GLuint mBuffers[3] = { 0, 0, 0 };
+	GLuint mTextures[3] = { 0, 0, 0 };
+
+	float mBuildTime = 0.0f;
+
+	void packLights();
+	void assignView(int view, const ClusterView& clusterView, ClusterRange* ranges);
+	void upload();
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef MATERIAL_BUFFER_H
+#define MATERIAL_BUFFER_H
+
+#include "utilities.h"
+
+/*****************************************************************
+ * all materials of a render queue in one texture buffer
+ *
+ * identical materials share an entry, and draws only pass the
+ * index of their entry (a uniform for single draws, the instance
+ * attribute for instanced ones), so switching between materials
+ * costs nothing at draw time. every material takes four RGBA32F
+ * texels: Ka and shininess, Kd, Ks, emission
+ *****************************************************************/
+
+class MaterialBuffer
+{
+public:
+	static const int kTextureUnit = 6;
+	static const int kTexelsPerMaterial = 4;
+
+	MaterialBuffer();
+	~MaterialBuffer();
+
+	// index of the entry of a material, added if no identical material is stored yet
+	int add(const Material& material);
+	// remove all entries, indices returned before are no longer valid
+	void clear();
+	// upload the entries if they changed and bind the texture buffer
+	void bind();
+	// set the sampler of the texture buffer
+	void setUniforms(ShaderProgram& program);
+
+	inline int getCount() const { return static_cast<int>(mMaterials.size()); }
+
+private:
+	std::vector<Material> mMaterials;
+	std::vector<glm::vec4> mData;
+	GLuint mBuffer = 0;
+	GLuint mTexture = 0;
+	bool mDirty = true;
+
+	// material buffers own GL objects and cannot be copied
+	MaterialBuffer(const MaterialBuffer&);
+	MaterialBuffer& operator=(const MaterialBuffer&);
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef OCCLUSION_BUFFER_H
+#define OCCLUSION_BUFFER_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "JobSystem.h"
+
+// low polygon stand-in for an occluding model, in model space
+struct OccluderMesh
+{
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> indices;		// triangle list
+};
+
+/*****************************************************************
+ * software depth buffer for occlusion culling
+ *
+ * occluder triangles are transformed, clipped against the near
+ * plane and binned on the calling thread, then rasterised into a
+ * small depth buffer tile by tile as parallel jobs, 4 pixels at a
+ * time with SSE. every tile also reduces its depth to a
+ * hierarchical-Z of 8x8 pixel blocks holding the farthest depth,
+ * which bounding spheres are tested against before submission
+ *
+ * occluders are double sided, as the scene is drawn without face
+ * culling
+ *****************************************************************/
+
+class OcclusionBuffer
+{
+public:
+	static const int kMaxWidth = 256;
+	static const int kTileSize = 32;
+	static const int kBlockSize = 8;
+
+	OcclusionBuffer();
+	~OcclusionBuffer();
+
+	// start a frame for a view, the buffer keeps the aspect ratio of the viewport
+	void begin(const glm::mat4& projViewMatrix, int viewportWidth, int viewportHeight);
+	// add the triangles of an occluder placed by a model matrix
+	void addOccluder(const OccluderMesh& mesh, const glm::mat4& modelMatrix);
+	// rasterise the occluders and build the hierarchical-Z
+	void rasterize(JobSystem& jobs);
+
+	// false if a world space sphere is entirely behind the occluders
+	bool isVisible(const glm::vec3& center, float radius) const;
+
+	inline int getWidth() const { return mWidth; }
+	inline int getHeight() const { return mHeight; }
+	inline int getTriangleCount() const { return static_cast<int>(mTriangles.size()); }
+	// cost of the last begin() to rasterize() in milliseconds
+	inline float getRasterTime() const { return mRasterTime; }
+
+private:
+	// screen space triangle with edge functions and depth plane, all in pixels
+	struct Triangle
+	{
+		float edgeA[3], edgeB[3], edgeC[3];	// inside is A * x + B * y + C >= 0
+		float depthA, depthB, depthC;		// depth = A * x + B * y + C
+		int minX, minY, maxX, maxY;		// pixel bounds, inclusive
+	};
+
+	glm::mat4 mProjViewMatrix;
+	int mWidth = 0;
+	int mHeight = 0;
+	int mTilesX = 0;
+	int mTilesY = 0;
+	int mBlocksX = 0;
+	int mBlocksY = 0;
+
+	std::vector<float> mDepth;	// nearest occluder depth per pixel, 0 to 1
+	std::vector<float> mHiZ;	// farthest depth per block
+	std::vector<Triangle> mTriangles;
+	std::vector<std::vector<uint32_t>> mBins;	// triangles touching each tile
+
+	std::chrono::steady_clock::time_point mStartTime;
+	float mRasterTime = 0.0f;
+
+	void addTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2);
+	void setupTriangle(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2);
+	void rasterizeTile(int tileX, int tileY);
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef OCCLUSION_QUERIES_H
+#define OCCLUSION_QUERIES_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "utilities.h"
+#include "SimpleModel.h"
+
+/*****************************************************************
+ * hardware occlusion queries of object bounding boxes
+ *
+ * every object gets a GL_ANY_SAMPLES_PASSED query of its bounding
+ * box per view and frame, issued after the occluders of the view;
+ * results are read at the start of the next frame, and only once
+ * the GPU reports them available, so the CPU never waits
+ *
+ * an object whose box was hidden for a view's hysteresis worth of
+ * results in a row (to avoid toggling on single frames) is drawn
+ * inside conditional rendering on the query of the current frame,
+ * which lets the GPU skip it while it stays hidden and draw it the
+ * moment it becomes visible again. a box the
+ * viewpoint is inside (or within the near plane distance of) is
+ * clipped by the near plane and could report hidden while the
+ * object fills the view, so it is not queried and counts as visible
+ *****************************************************************/
+
+class OcclusionQueries
+{
+public:
+	static const int kQueryFrames = 3;
+	static const int kDefaultHysteresis = 4;
+
+	OcclusionQueries();
+	~OcclusionQueries();
+
+	// start a new frame, reset the statistics and read the results that became available
+	void beginFrame();
+	// issue the bounding box query of an object in a view seen from viewpoint; the caller binds a position-only
+	// program with the view's uProjViewMatrix and disables colour and depth writes
+	void issue(int view, uint32_t object, SimpleModel* model, ShaderProgram& program, const glm::mat4& modelMatrix,
+		const glm::vec3& viewpoint, float nearDistance);
+	// query to render the object conditionally on, or 0 if it should be drawn normally
+	GLuint getConditionalQuery(int view, uint32_t object) const;
+	// whether the object will be drawn conditionally once it is issued this frame; only reads
+	// state, so draws can be recorded on other threads between beginFrame() and issue()
+	bool isHidden(int view, uint32_t object) const;
+
+	// hidden results in a row before an object is drawn conditionally in a view, kDefaultHysteresis until set
+	void setHysteresis(int view, int results);
+	inline int getHysteresis(int view) const
+	{
+		return view < static_cast<int>(mHysteresis.size()) ? mHysteresis[view] : kDefaultHysteresis;
+	}
+
+	// statistics of the current frame
+	inline int getQueryCount() const { return mQueryCount; }
+	inline int getResultCount() const { return mResultCount; }
+	inline int getHiddenCount() const { return mHiddenCount; }
+	inline int getDroppedCount() const { return mDroppedCount; }
+	inline int getInsideCount() const { return mInsideCount; }
+
+private:
+	struct ObjectQueries
+	{
+		GLuint queries[kQueryFrames];
+		bool pending[kQueryFrames];
+		uint32_t lastFrame = 0;		// frame of the last issue()
+		int hiddenResults = 0;		// hidden results in a row
+	};
+
+	std::unordered_map<uint64_t, ObjectQueries> mObjects;	// keyed by view and object
+	uint32_t mFrame = 0;
+	std::vector<int> mHysteresis;	// per view
+
+	int mQueryCount = 0;
+	int mResultCount = 0;
+	int mHiddenCount = 0;
+	int mDroppedCount = 0;
+	int mInsideCount = 0;
+
+	static inline uint64_t objectKey(int view, uint32_t object) { return (static_cast<uint64_t>(view) << 32) | object; }
+	void readResults(ObjectQueries& queries);
+};
+
+#endif
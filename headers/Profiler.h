@@ -0,0 +1,84 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// time the rest of the enclosing scope; name must be a string literal (or outlive the profiler)
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__func__)
+
+/*****************************************************************
+ * scoped CPU zone profiler
+ *
+ * every thread records its zones into its own ring of events,
+ * which only that thread writes, so recording takes no locks;
+ * timestamps are nanoseconds of the steady clock. once per frame
+ * the main thread folds the new events of all threads into a
+ * rolling per-zone average, and on demand all events still in the
+ * rings are written as a Chrome trace_event JSON file (load it in
+ * chrome://tracing or Perfetto)
+ *
+ * zones running on several threads in a frame add up, so the
+ * breakdown is CPU time rather than wall time
+ *****************************************************************/
+
+class Profiler
+{
+public:
+	static const size_t kEventCapacity = 1 << 15;	// per thread, older events are overwritten
+	static const int kRollingFrames = 60;
+
+	// nanoseconds since the profiler started
+	static uint64_t now();
+	// add a zone of the calling thread
+	static void record(const char* name, uint64_t start, uint64_t end);
+	// add a zone measured on the GPU, already converted to the profiler's clock; GL thread only.
+	// GPU zones are exported on their own track but left out of the CPU breakdown
+	static void recordGpu(const char* name, uint64_t start, uint64_t end);
+
+	static void setEnabled(bool enabled);
+	static bool isEnabled();
+	// name of the calling thread in exported traces
+	static void setThreadName(const std::string& name);
+
+	// fold the events since the last call into the rolling breakdown; main thread only
+	static void endFrame();
+	// zones seen so far and their average per frame in milliseconds over the last kRollingFrames frames
+	static size_t getZoneCount();
+	static const char* getZoneName(size_t zone);
+	static float getZoneTime(size_t zone);
+
+	// write all recorded events as Chrome trace JSON, false if the file cannot be written
+	static bool exportChromeTrace(const std::string& filename);
+	// write text as a quoted and escaped JSON string, for the other JSON writers as well
+	static void writeJsonString(std::ostream& out, const std::string& text);
+};
+
+// records a zone from its construction to the end of its scope
+class ProfileZone
+{
+public:
+	explicit ProfileZone(const char* name)
+		: mName(Profiler::isEnabled() ? name : nullptr), mStart(mName ? Profiler::now() : 0)
+	{}
+
+	~ProfileZone()
+	{
+		if (mName)
+			Profiler::record(mName, mStart, Profiler::now());
+	}
+
+private:
+	const char* mName;
+	uint64_t mStart;
+
+	ProfileZone(const ProfileZone&);
+	ProfileZone& operator=(const ProfileZone&);
+};
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "utilities.h"
+#include "SimpleModel.h"
+#include "LightClusters.h"
+#include "ShadowCubeMap.h"
+#include "OcclusionQueries.h"
+#include "StreamBuffer.h"
+#include "MaterialBuffer.h"
+#include "JobSystem.h"
+
+// render passes, executed in this order within a viewport
+enum RenderPass
+{
+	PASS_DEPTH = 0,		// depth-only pre-pass, generated by the queue for views that enable it
+	PASS_OCCLUDER = 1,	// large opaque objects that hide others, drawn before the occlusion queries
+	PASS_OPAQUE = 2,
+};
+
+// per-viewport data shared by every draw submitted to that view
+struct RenderView
+{
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+	glm::mat4 projViewMatrix;
+	glm::vec3 viewpoint;
+	float nearDistance = 0.0f;	// from the viewpoint to the near plane, worked out by addView()
+	bool depthPrepass = false;	// lay down depth first, then shade with GL_EQUAL
+	int statsScope = -1;		// RenderStats scope its draws count towards, -1 for the current one
+	const char* gpuZone = nullptr;	// GpuProfiler zone of its draws, nullptr to time them only as part of the caller's
+};
+
+// everything needed to issue a single draw call
+struct DrawCommand
+{
+	ShaderProgram* program = nullptr;
+	SimpleModel* model = nullptr;
+	GLenum topology = GL_TRIANGLES;
+	uint32_t object = 0;	// identifies the same object across views
+	int view = 0;
+	glm::mat4 modelMatrix;
+	glm::mat3 normalMatrix;
+};
+
+// compact sortable reference to a draw command
+struct RenderItem
+{
+	uint64_t key;
+	uint32_t command;
+};
+
+// operations recorded from the sorted draws and replayed on the GL thread
+enum RenderOp : uint8_t
+{
+	OP_BEGIN_VIEW,		// timestamp and viewport of a view group
+	OP_DEPTH_MODE,		// depth test for normal, pre-pass or shading after a pre-pass
+	OP_PROGRAM,		// use a program and set its light and view uniforms
+	OP_MATERIAL,		// material index and textures of a mesh
+	OP_OCCLUSION_QUERIES,	// query the boxes of a view's opaque draws, starting at an item
+	OP_DRAW,		// single draw, matrices in the instance data
+	OP_DRAW_INSTANCED,	// instanced draw of a range of the instance data
+};
+
+// flags of a recorded operation
+enum RenderOpFlags : uint8_t
+{
+	OP_FLAG_DEPTH_PASS = 1,		// position-only draw of a depth pre-pass
+	OP_FLAG_MULTI_VIEW = 2,		// draw for all views of the multi-view group
+	OP_FLAG_CONDITIONAL = 4,	// draw conditionally on the object's occlusion query
+};
+
+// one recorded operation; programs and models are referenced by pointer, never by GL name
+struct RenderCommand
+{
+	RenderOp op = OP_DRAW;
+	uint8_t flags = 0;
+	uint16_t mode = 0;		// depth mode, or instance divisor of an instanced draw
+	uint32_t view = 0;		// view of the draw, or view group of OP_BEGIN_VIEW
+	uint32_t first = 0;		// first instance, or first item of OP_OCCLUSION_QUERIES
+	uint32_t count = 0;		// number of instances
+	uint32_t index = 0;		// material index, or object of a conditional draw
+	GLenum topology = GL_TRIANGLES;
+	ShaderProgram* program = nullptr;
+	SimpleModel* model = nullptr;
+};
+
+// operations and per-instance data recorded for the draws of one view group
+struct CommandBuffer
+{
+	std::vector<RenderCommand> commands;
+	std::vector<InstanceData> instances;
+	std::unordered_map<uint32_t, size_t> objectInstances;	// multi-view scratch
+
+	inline void clear() { commands.clear(); instances.clear(); }
+};
+
+/*****************************************************************
+ * collects draws for all viewports, sorts them by a 64-bit key
+ * and executes them with as few state changes as possible
+ *
+ * once all views are added, views can be submitted to from
+ * several threads at once. execution records a command buffer per
+ * view group, in parallel on the job system if one is set, which
+ * resolves state changes, material indices, instance runs and
+ * matrices; the GL thread then only replays the buffers
+ *
+ * key layout (most significant first):
+ *   view 4 | pass 4 | program 8 | material 16 | depth 32
+ *
+ * the last view value is the multi-view group, which leaves 15
+ * views per frame; at most 256 programs and 65536 material slots
+ * are handed out over the queue's lifetime. going past any of
+ * them is reported and exits rather than aliasing keys
+ *
+ * material slots stand for a mesh's textures and material; the
+ * material values themselves live in a shared material buffer and
+ * every draw only passes the index of its entry
+ *
+ * consecutive items that only differ in depth draw the same mesh
+ * and are grouped into a single instanced draw; with a stream
+ * buffer, the instance data of every draw with an instanced program
+ * is written to the ring buffer instead of uniforms
+ *
+ * views with a depth pre-pass get a depth-only copy of every opaque
+ * draw, and their opaque draws are shaded with GL_EQUAL depth tests
+ * so every pixel runs the full fragment shader once
+ *
+ * with occlusion queries enabled, the bounding boxes of a view's
+ * opaque draws are queried after its occluder pass, and objects
+ * that stayed hidden are drawn with conditional rendering; views
+ * with a depth pre-pass and the multi-view group are not queried
+ *
+ * in multi-view mode, draws of programs with a multi-view variant
+ * share one view group and every object is drawn once for all
+ * views, instanced per view and routed with gl_ViewportIndex
+ *****************************************************************/
+
+class RenderQueue
+{
+public:
+	RenderQueue();
+	~RenderQueue();
+
+	// drop all views and draws of the previous frame
+	void clear();
+	// add a viewport, returns the view index used by submit(); at most 15 per frame
+	int addView(int x, int y, int width, int height, const glm::mat4& projViewMatrix, const glm::vec3& viewpoint,
+		bool depthPrepass = false);
+	// count the draws of a view towards a RenderStats scope; multi-view draws count towards its own scope
+	void setViewStatsScope(int view, int scope);
+	// time the draws of a view as a GpuProfiler zone; zone must be a string literal (or outlive the profiler).
+	// multi-view draws are timed as the "Multi-View" zone
+	void setViewGpuZone(int view, const char* zone);
+	// light used by every lit program
+	void setLight(Light* light);
+	// additional lights, assigned to clusters of every view when the queue is executed
+	void setClusterLights(const Light* lights, size_t count);
+	inline const LightClusters& getLightClusters() const { return mClusters; }
+	inline const MaterialBuffer& getMaterialBuffer() const { return mMaterialBuffer; }
+	// shadow map of the main light, nullptr for no shadows
+	void setShadowMap(ShadowCubeMap* shadowMap);
+	// ring buffer that per-draw instance data is streamed through, nullptr to upload it per model
+	void setStreamBuffer(StreamBuffer* streamBuffer);
+	// program used instead of program when several copies of a mesh can be drawn instanced
+	void setInstancedProgram(ShaderProgram* program, ShaderProgram* instancedProgram);
+	// program used for single-pass rendering of all views (needs GL_ARB_viewport_array)
+	void setMultiViewProgram(ShaderProgram* program, ShaderProgram* multiViewProgram);
+	// position-only program for depth pre-passes (its instanced variant is set with setInstancedProgram)
+	void setDepthProgram(ShaderProgram* depthProgram);
+	// give a program and the material of a model their sort key slots now; submit() adds missing ones in the
+	// order draws arrive, which varies from run to run when views are submitted from several threads.
+	// reserved slots are looked up without locking, so this must not be called while views are submitted
+	void reserveSlots(ShaderProgram* program, SimpleModel* model);
+	// draw all views in a single pass where a multi-view program is available
+	void setMultiView(bool enabled);
+	inline bool isMultiView() const { return mMultiView; }
+	// query the bounding boxes of opaque draws and skip hidden objects on the GPU (needs the depth program)
+	inline void setOcclusionQueries(bool enabled) { mOcclusionQueriesEnabled = enabled; }
+	inline OcclusionQueries& getOcclusionQueries() { return mOcclusionQueries; }
+	// queue a draw of a model with the given program; object identifies it across views
+	void submit(int view, RenderPass pass, ShaderProgram* program, SimpleModel* model, uint32_t object,
+		const glm::mat4& modelMatrix, const glm::mat3& normalMatrix, GLenum topology = GL_TRIANGLES);
+	// radix sort the queued items by key
+	void sort();
+	// record the sorted draws into command buffers and replay them
+	void execute();
+	// job system the command buffers are recorded on, nullptr to record on the calling thread
+	inline void setJobSystem(JobSystem* jobs) { mJobs = jobs; }
+
+	inline size_t getItemCount() const { return mItems.size(); }
+	// recorded operations and cost of recording them in the last execute(), in milliseconds
+	inline size_t getRecordedCommandCount() const { return mRecordedCommands; }
+	inline float getRecordTime() const { return mRecordTime; }
+	inline const RenderView& getView(int view) const { return mViews[view]; }
+
+	// GPU time of a view's zone in milliseconds, as read back by the GpuProfiler a few frames late
+	// (0 if the view has no zone, the profiler is disabled or the view was drawn in the multi-view pass)
+	float getViewTime(int view) const;
+	// GPU time of all views drawn in the multi-view pass
+	float getMultiViewTime() const;
+
+	// build a sort key from its fields
+	static uint64_t makeKey(uint32_t view, uint32_t pass, uint32_t program, uint32_t material, float depth);
+
+private:
+	// draws submitted to each view, merged into mCommands and mItems by sort()
+	struct ViewSubmissions
+	{
+		std::vector<DrawCommand> commands;
+		std::vector<RenderItem> items;
+	};
+
+	std::vector<RenderView> mViews;
+	std::vector<ViewSubmissions> mSubmissions;
+	std::vector<DrawCommand> mCommands;
+	std::vector<RenderItem> mItems;
+	std::vector<RenderItem> mSortScratch;
+
+	// dense slots so that programs and materials fit in the key; the mutex guards both
+	std::mutex mSlotMutex;
+	std::vector<ShaderProgram*> mPrograms;
+	std::vector<const Mesh*> mMaterials;
+	// slots given out by reserveSlots(), only changed between frames and read by submit() without the lock
+	std::unordered_map<const ShaderProgram*, uint32_t> mReservedPrograms;
+	std::unordered_map<const Mesh*, uint32_t> mReservedMaterials;
+
+	// material buffer entry of every material slot, and the material it was added with
+	MaterialBuffer mMaterialBuffer;
+	std::vector<int> mMaterialIndices;
+	std::vector<Material> mSlotMaterials;
+
+	Light* mLight = nullptr;
+	LightClusters mClusters;
+	ShadowCubeMap* mShadowMap = nullptr;
+	ShaderProgram* mDepthProgram = nullptr;
+
+	// instanced and multi-view variants of programs
+	std::vector<std::pair<ShaderProgram*, ShaderProgram*>> mInstancedPrograms;
+	std::vector<std::pair<ShaderProgram*, ShaderProgram*>> mMultiViewPrograms;
+	StreamBuffer* mStreamBuffer = nullptr;
+	bool mMultiView = false;
+
+	OcclusionQueries mOcclusionQueries;
+	bool mOcclusionQueriesEnabled = false;
+
+	// one command buffer per view group, recorded in parallel
+	JobSystem* mJobs = nullptr;
+	std::vector<CommandBuffer> mCommandBuffers;
+	std::vector<size_t> mGroupStarts;
+	size_t mRecordedCommands = 0;
+	float mRecordTime = 0.0f;
+
+	uint32_t programSlot(ShaderProgram* program);
+	uint32_t materialSlot(const Mesh* mesh);
+	// reserved slot if there is one, otherwise the slot added (or found) under the lock
+	uint32_t findProgramSlot(ShaderProgram* program);
+	uint32_t findMaterialSlot(const Mesh* mesh);
+	void updateMaterials();
+	static ShaderProgram* findVariant(const std::vector<std::pair<ShaderProgram*, ShaderProgram*>>& variants, ShaderProgram* program);
+
+	void setLightingUniforms(ShaderProgram& program);
+	void setViewUniforms(ShaderProgram& program, int view);
+	int multiViewCount() const;
+	void setMultiViewUniforms(ShaderProgram& program);
+	void setMaterialUniforms(ShaderProgram& program, Mesh& mesh, int materialIndex);
+	void issueOcclusionQueries(size_t begin, const RenderView& view);
+
+	// record the sorted items [begin, end) of a single view group
+	void record(size_t begin, size_t end, CommandBuffer& buffer);
+	// issue the GL calls of a recorded buffer; depthMode carries the depth state between buffers
+	void replay(const CommandBuffer& buffer, int& depthMode);
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "utilities.h"
+
+// counted per frame and scope
+enum RenderStat
+{
+	STAT_DRAW_CALLS,
+	STAT_TRIANGLES,			// of all instances
+	STAT_VERTICES,			// vertices or indices, of all instances
+	STAT_PROGRAM_SWITCHES,
+	STAT_VERTEX_ARRAY_BINDS,
+	STAT_TEXTURE_BINDS,
+	STAT_UNIFORM_UPLOADS,
+	STAT_BUFFER_BYTES,		// vertex, instance and texture buffer data uploaded
+	STAT_COUNT
+};
+
+/*****************************************************************
+ * per-frame rendering statistics
+ *
+ * draws, binds, uniform uploads and buffer uploads are counted
+ * where they reach OpenGL, against the scope that is current at
+ * the time: one per viewport, one for the multi-view pass that
+ * draws several viewports at once, and one for everything else
+ * (shadow map, upscaling, the border). binds are counted by the
+ * state cache, so filtered redundant calls are not included.
+ * endFrame() keeps the counts of the finished frame for display
+ * and starts counting from zero
+ *
+ * GL thread only
+ *****************************************************************/
+
+class RenderStats
+{
+public:
+	static const int kViewportScopes = 4;
+	static const int kMultiViewScope = kViewportScopes;
+	static const int kOtherScope = kViewportScopes + 1;
+	static const int kScopeCount = kViewportScopes + 2;
+
+	static void add(RenderStat stat, uint64_t amount = 1);
+	// a draw call of vertices (or indices) per instance, with its triangles worked out from the topology
+	static void addDraw(GLenum topology, uint64_t vertices, uint64_t instances = 1);
+
+	// scope the following calls count towards, returns the previous one
+	static int setScope(int scope);
+	static int getScope();
+
+	// keep the counts of this frame and start the next one
+	static void endFrame();
+
+	// counts of the last finished frame
+	static uint64_t get(int scope, RenderStat stat);
+	static uint64_t getTotal(RenderStat stat);
+
+	static const char* getStatName(RenderStat stat);
+	static const char* getScopeName(int scope);
+
+	// write the counts of the last finished frame as JSON, false if the file cannot be written
+	static bool writeJson(const std::string& filename);
+	static void writeJson(std::ostream& out);
+};
+
+// makes a scope current until the end of the enclosing block
+class RenderStatsScope
+{
+public:
+	explicit RenderStatsScope(int scope) : mPrevious(RenderStats::setScope(scope)) {}
+	~RenderStatsScope() { RenderStats::setScope(mPrevious); }
+
+private:
+	int mPrevious;
+
+	RenderStatsScope(const RenderStatsScope&);
+	RenderStatsScope& operator=(const RenderStatsScope&);
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include "utilities.h"
+
+/*****************************************************************
+ * offscreen framebuffer with a colour texture and a depth/stencil
+ * renderbuffer
+ *
+ * the depth format matches the default framebuffer (24 bit depth,
+ * 8 bit stencil) so both colour and depth can be blitted into a
+ * window viewport
+ *****************************************************************/
+
+class RenderTarget
+{
+public:
+	RenderTarget();
+	~RenderTarget();
+
+	// (re)create the attachments if the size changed, returns true if they were recreated
+	bool resize(int width, int height);
+
+	// render into the target, with the viewport covering all of it
+	void bind();
+	// copy colour and depth into a region of the same size of another framebuffer (default: the window)
+	void blitTo(int x, int y, GLuint framebuffer = 0);
+	// copy a region of the colour into a region of another framebuffer, scaled with linear filtering
+	void blitColorTo(int srcX, int srcY, int srcWidth, int srcHeight,
+		int x, int y, int width, int height, GLuint framebuffer = 0);
+
+	inline bool isValid() const { return mFramebuffer != 0; }
+	inline int getWidth() const { return mWidth; }
+	inline int getHeight() const { return mHeight; }
+	inline GLuint getColorTexture() const { return mColorTexture; }
+	inline GLuint getFramebuffer() const { return mFramebuffer; }
+
+private:
+	GLuint mFramebuffer = 0;
+	GLuint mColorTexture = 0;
+	GLuint mDepthRenderbuffer = 0;
+	int mWidth = 0;
+	int mHeight = 0;
+
+	// render targets own GL objects and cannot be copied
+	RenderTarget(const RenderTarget&);
+	RenderTarget& operator=(const RenderTarget&);
+
+	void destroy();
+};
+
+#endif
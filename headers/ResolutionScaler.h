@@ -0,0 +1,40 @@
+#ifndef RESOLUTION_SCALER_H
+#define RESOLUTION_SCALER_H
+
+/*****************************************************************
+ * picks a render resolution scale from measured GPU time
+ *
+ * the GPU time is smoothed and compared with a budget; as the cost
+ * of a view grows with the square of its scale, the scale moves
+ * towards scale * sqrt(budget / time). it drops as soon as the
+ * budget is exceeded but only rises again with some headroom left,
+ * and snaps to fixed steps so targets are not resized every frame
+ *****************************************************************/
+
+class ResolutionScaler
+{
+public:
+	ResolutionScaler();
+	~ResolutionScaler();
+
+	// GPU time to aim for, in milliseconds
+	inline void setBudget(float milliseconds) { mBudget = milliseconds; }
+	// allowed range of the scale
+	void setRange(float minScale, float maxScale);
+	// feed the latest GPU time (0 while no measurement is available), returns the new scale
+	float update(float gpuTime);
+	// back to full resolution, e.g. after a resize
+	void reset();
+
+	inline float getScale() const { return mScale; }
+	inline float getSmoothedTime() const { return mSmoothedTime; }
+
+private:
+	float mScale = 1.0f;
+	float mMinScale = 0.5f;
+	float mMaxScale = 1.0f;
+	float mBudget = 4.0f;
+	float mSmoothedTime = 0.0f;
+};
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <atomic>
+#include <cstdint>
+#include <glm/gtc/quaternion.hpp>
+
+#include "utilities.h"
+#include "SimpleModel.h"
+#include "Culling.h"
+#include "JobSystem.h"
+
+typedef uint32_t Entity;
+const Entity kNoEntity = 0xFFFFFFFF;
+
+/*****************************************************************
+ * entity/component storage for the scene
+ *
+ * every entity has a transform; renderables, lights and bounds
+ * are optional components. each component is kept as structure of
+ * arrays, and transforms are propagated down the hierarchy one
+ * depth level at a time, with every level split across the jobs
+ * of the job system (on the calling thread if none is set)
+ *
+ * renderables are static until they move after their initial
+ * placement, and become static again once they have not moved for
+ * a while; the static version changes whenever the set of static
+ * renderables or their placement changes, so views can cache them
+ *****************************************************************/
+
+class Scene
+{
+public:
+	Scene();
+	~Scene();
+
+	// create an entity, optionally as child of an existing entity
+	Entity createEntity(Entity parent = kNoEntity);
+	inline size_t getEntityCount() const { return mParent.size(); }
+
+	// local transform relative to the parent
+	void setLocalTransform(Entity entity, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+	void setPosition(Entity entity, const glm::vec3& position);
+	void setRotation(Entity entity, const glm::quat& rotation);
+	void setScale(Entity entity, const glm::vec3& scale);
+	inline const glm::vec3& getPosition(Entity entity) const { return mPosition[entity]; }
+
+	// world transform, valid after update()
+	inline const glm::mat4& getWorldMatrix(Entity entity) const { return mWorldMatrix[entity]; }
+	inline const glm::mat3& getNormalMatrix(Entity entity) const { return mNormalMatrix[entity]; }
+	// incremented whenever the world matrix of the entity changes
+	inline uint32_t getTransformVersion(Entity entity) const { return mVersion[entity]; }
+
+	// renderable component with its world bounding sphere, returns the renderable index
+	int addRenderable(Entity entity, ShaderProgram* program, SimpleModel* model, GLenum topology = GL_TRIANGLES);
+	inline size_t getRenderableCount() const { return mRenderEntity.size(); }
+	inline Entity getRenderEntity(size_t index) const { return mRenderEntity[index]; }
+	inline ShaderProgram* getRenderProgram(size_t index) const { return mRenderProgram[index]; }
+	inline SimpleModel* getRenderModel(size_t index) const { return mRenderModel[index]; }
+	inline GLenum getRenderTopology(size_t index) const { return mRenderTopology[index]; }
+	// world bounding spheres of all renderables, in renderable order
+	inline const FrustumCuller& getBounds() const { return mBounds; }
+	// static renderables can be cached, dynamic ones must be drawn every frame
+	inline bool isRenderStatic(size_t index) const { return mRenderStatic[index] != 0; }
+	// incremented whenever a static renderable is added, moved, or changes between static and dynamic
+	inline uint32_t getStaticVersion() const { return mStaticVersion; }
+
+	// light component that follows the entity position (and -z direction), returns the light index
+	int addLight(Entity entity, const Light& light);
+	inline size_t getLightCount() const { return mLights.size(); }
+	inline Light& getLight(size_t index) { return mLights[index]; }
+	// incremented whenever a light moves or is invalidated
+	inline uint32_t getLightVersion() const { return mLightVersion; }
+	// call after changing light properties through getLight()
+	inline void invalidateLights() { mLightVersion++; }
+
+	// propagate transforms and update bounds and lights of changed entities
+	void update();
+
+	// cost of the last update() in milliseconds
+	inline float getUpdateTime() const { return mUpdateTime; }
+	// job system the scene update runs on, nullptr to update on the calling thread
+	inline void setJobSystem(JobSystem* jobs) { mJobs = jobs; }
+
+private:
+	// transforms
+	std::vector<glm::vec3> mPosition;
+	std::vector<glm::quat> mRotation;
+	std::vector<glm::vec3> mScale;
+	std::vector<Entity> mParent;
+	std::vector<uint8_t> mLocalDirty;
+	std::vector<uint8_t> mWorldChanged;
+	std::vector<glm::mat4> mWorldMatrix;
+	std::vector<glm::mat3> mNormalMatrix;
+	std::vector<uint32_t> mVersion;
+
+	// entities grouped by hierarchy depth, parents always in a lower level
+	std::vector<uint32_t> mDepth;
+	std::vector<std::vector<Entity>> mLevels;
+
+	// renderables
+	std::vector<Entity> mRenderEntity;
+	std::vector<ShaderProgram*> mRenderProgram;
+	std::vector<SimpleModel*> mRenderModel;
+	std::vector<GLenum> mRenderTopology;
+	std::vector<uint8_t> mRenderStatic;
+	std::vector<uint32_t> mRenderLastMoved;	// update in which the renderable last moved
+	uint32_t mStaticVersion = 0;
+
+	// bounds (one sphere per renderable)
+	FrustumCuller mBounds;
+
+	// lights
+	std::vector<Entity> mLightEntity;
+	std::vector<Light> mLights;
+	uint32_t mLightVersion = 0;
+
+	JobSystem* mJobs = nullptr;
+	uint32_t mUpdateCount = 0;
+	float mUpdateTime = 0.0f;
+
+	void updateTransform(Entity entity);
+	// split the range across the job system, or run it in one piece without one
+	void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& function);
+};
+
+#endif
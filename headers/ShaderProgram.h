@@ -1,40 +1,53 @@
-#ifndef SHADER_PROGRAM_H
-#define SHADER_PROGRAM_H
-
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include <string>
-#include <map>
-#include <GLEW/glew.h>
-#include <glm/glm.hpp>
-
-class ShaderProgram
-{
-public:
-	ShaderProgram();
-	~ShaderProgram();
-
-	// compile and link a vertex and fragment shader pair
-	void compileAndLink(const std::string vShaderFilename, const std::string fShaderFilename);
-	// use the shader program
-	void use();
-
-	// functions to set shader uniform variables
-	void setUniform(const char* name, const glm::vec2& vector);
-	void setUniform(const char* name, const glm::vec3& vector);
-	void setUniform(const char* name, const glm::vec4& vector);
-	void setUniform(const char* name, const glm::mat3& matrix);
-	void setUniform(const char* name, const glm::mat4& matrix);
-	void setUniform(const char* name, float value);
-	void setUniform(const char* name, int value);
-	void setUniform(const char* name, bool value);
-
-private:
-	GLuint mProgramID = 0;							// shader program handle
-	std::map<std::string, GLint> mUniformLocations;	// uniform locations
-
-	GLint getUniformLocation(const char* name);		// get uniform variable locations
-};
-
-#endif
+#ifndef SHADER_PROGRAM_H
+#define SHADER_PROGRAM_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <map>
+#include <GLEW/glew.h>
+#include <glm/glm.hpp>
+
+class ShaderProgram
+{
+public:
+	ShaderProgram();
+	~ShaderProgram();
+
+	// compile and link a vertex and fragment shader pair
+	void compileAndLink(const std::string vShaderFilename, const std::string fShaderFilename);
+	// compile and link a vertex, geometry and fragment shader
+	void compileAndLink(const std::string vShaderFilename, const std::string gShaderFilename, const std::string fShaderFilename);
+	// use the shader program
+	void use();
+	// name made of the shader file names, e.g. for profiling; interned, so it stays valid after the program is gone
+	inline const char* getName() const { return mName; }
+
+	// functions to set shader uniform variables
+	void setUniform(const char* name, const glm::vec2& vector);
+	void setUniform(const char* name, const glm::vec3& vector);
+	void setUniform(const char* name, const glm::vec4& vector);
+	void setUniform(const char* name, const glm::mat3& matrix);
+	void setUniform(const char* name, const glm::mat4& matrix);
+	void setUniform(const char* name, float value);
+	void setUniform(const char* name, int value);
+	void setUniform(const char* name, bool value);
+	// set count elements of a uniform array, starting at its first, in a single call
+	void setUniform(const char* name, const glm::vec3* vectors, int count);
+	void setUniform(const char* name, const glm::vec4* vectors, int count);
+	void setUniform(const char* name, const glm::mat4* matrices, int count);
+
+private:
+	GLuint mProgramID = 0;							// shader program handle
+	std::map<std::string, GLint> mUniformLocations;	// uniform locations
+	const char* mName = "";							// vertex and fragment shader names
+
+	GLint getUniformLocation(const char* name);		// get uniform variable locations
+
+	GLuint compileShader(GLenum type, const std::string& filename);	// read and compile one shader
+	void link(const GLuint* shaderIDs, int numShaders);				// link compiled shaders into the program
+	void setName(const std::string& vShaderFilename, const std::string& fShaderFilename);
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef SHADOW_CUBE_MAP_H
+#define SHADOW_CUBE_MAP_H
+
+#include "utilities.h"
+#include "Culling.h"
+#include "Scene.h"
+
+/*****************************************************************
+ * omnidirectional shadow map of a point light
+ *
+ * the distance to the light is rendered into the six faces of a
+ * depth cube map with the position-only stream of every model;
+ * a face is only rendered again when the light moved or a shadow
+ * caster that is (or was) inside the face frustum moved, so the
+ * shadows of a static scene cost nothing after the first frame
+ *****************************************************************/
+
+class ShadowCubeMap
+{
+public:
+	static const int kTextureUnit = 5;
+
+	ShadowCubeMap();
+	~ShadowCubeMap();
+
+	// create the cube map with faces of size x size texels, covering distances up to farPlane
+	void create(int size, float farPlane);
+	// re-render changed faces for a point light, returns the number of faces rendered
+	int update(const Light& light, const Scene& scene, ShaderProgram& depthProgram);
+	// render every face again on the next update
+	void invalidate();
+
+	// bind the cube map to kTextureUnit
+	void bind();
+	// set the shadow uniforms of a lit program; shadows are off unless the last update() was for a point light
+	void setUniforms(ShaderProgram& program) const;
+	// whether the faces match the light of the last update()
+	inline bool isReady() const { return mReady; }
+
+	// incremented whenever a face was rendered again
+	inline uint32_t getVersion() const { return mVersion; }
+
+private:
+	// shadow casters a face was rendered with
+	struct Face
+	{
+		bool valid = false;
+		glm::mat4 projViewMatrix;
+		Frustum frustum;
+		std::vector<uint32_t> versions;		// transform version of every renderable
+		std::vector<uint8_t> inside;		// renderables inside the face frustum
+	};
+
+	GLuint mTexture = 0;
+	GLuint mFramebuffer = 0;
+	int mSize = 0;
+	float mFarPlane = 1.0f;
+
+	Face mFaces[6];
+	glm::vec3 mLightPosition;
+	uint32_t mVersion = 0;
+	bool mReady = false;
+	std::vector<uint8_t> mVisible;
+
+	void setupFaces();
+};
+
+#endif
@@ -1,62 +1,126 @@
-#ifndef MODEL_H
-#define MODEL_H
-
-#include <assimp/Importer.hpp>      // C++ importer interface
-#include <assimp/scene.h>           // output data structure
-#include <assimp/postprocess.h>     // post processing flags
-
-#include "utilities.h"
-#include "ShaderProgram.h"
-#include "Texture.h"
-
-struct Mesh
-{
-    // OpenGL buffer objects
-    GLuint VBO = 0;
-    GLuint IBO = 0;
-    GLuint VAO = 0;
-    int numOfIndices = 0;
-    int numOfVertices = 0;
-    bool hasTexCoords = false;
-
-    Material material;
-    Texture texture;
-    Texture normalTexture;
-
-    glm::mat4 modelMatrix;
-
-    Mesh() : modelMatrix(1.0f)
-    {
-        material.Ka = glm::vec3(0.25f, 0.21f, 0.21f);
-        material.Kd = glm::vec3(1.0f, 0.83f, 0.83f);
-        material.Ks = glm::vec3(0.3f, 0.3f, 0.3f);
-        material.shininess = 32.0f;
-    }
-};
-
-/*****************************************************************
- * simple model class that loads the first mesh of a model
- *****************************************************************/
-
-class SimpleModel
-{
-public:
-    SimpleModel();
-    ~SimpleModel();
-
-    void loadModel(const char *filename, bool texture = false);
-    void drawModel(GLenum topology = GL_TRIANGLES);
-
-    inline Mesh* GetMesh() { return &mMesh; }
-
-    bool mIsValid = false;
-
-private:
-    
-    Mesh mMesh;
- 
-    void LoadMesh(const aiMesh *mesh);
-    void loadMeshWithTexture(const aiMesh* mesh);
-};
-
-#endif
+#ifndef MODEL_H
+#define MODEL_H
+
+#include <assimp/Importer.hpp>      // C++ importer interface
+#include <assimp/scene.h>           // output data structure
+#include <assimp/postprocess.h>     // post processing flags
+
+#include "utilities.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+
+struct Mesh
+{
+    // OpenGL buffer objects
+    GLuint VBO = 0;
+    GLuint IBO = 0;
+    GLuint VAO = 0;
+    GLuint positionVBO = 0;     // tightly packed positions for depth-only draws
+    GLuint depthVAO = 0;
+    int numOfIndices = 0;
+    int numOfVertices = 0;
+    bool hasTexCoords = false;
+
+    Material material;
+    Texture texture;
+    Texture normalTexture;
+
+    glm::mat4 modelMatrix;
+
+    // model space bounding volumes
+    glm::vec3 aabbMin;
+    glm::vec3 aabbMax;
+    glm::vec3 sphereCenter;
+    float sphereRadius = 0.0f;
+
+    Mesh() : modelMatrix(1.0f), aabbMin(0.0f), aabbMax(0.0f), sphereCenter(0.0f)
+    {
+        material.Ka = glm::vec3(0.25f, 0.21f, 0.21f);
+        material.Kd = glm::vec3(1.0f, 0.83f, 0.83f);
+        material.Ks = glm::vec3(0.3f, 0.3f, 0.3f);
+        material.emission = glm::vec3(0.0f);
+        material.shininess = 32.0f;
+    }
+};
+
+// per-instance vertex attributes for instanced draws
+struct InstanceData
+{
+	glm::mat4 modelMatrix;		// attribute locations 4-7
+	glm::mat3 normalMatrix;		// attribute locations 8-10
+	GLint materialIndex = 0;	// attribute location 11
+	GLint viewMask = ~0;		// attribute location 12, views the instance is visible in (multi-view draws)
+};
+
+/*****************************************************************
+ * simple model class that loads the first mesh of a model
+ *****************************************************************/
+
+class SimpleModel
+{
+public:
+    SimpleModel();
+    ~SimpleModel();
+
+    void loadModel(const char *filename, bool texture = false);
+    // read the model into memory without touching GL, so importing can run on any thread;
+    // upload() then creates the buffers on the GL thread. false if the model could not be read
+    bool importModel(const char *filename, bool texture = false);
+    // create the GL buffers from the imported data and free it
+    void upload();
+    void drawModel(GLenum topology = GL_TRIANGLES);
+    // draw one copy of the model per element of instances in a single draw call;
+    // with instanceDivisor > 1 each element is repeated for that many consecutive instances
+    void drawInstanced(const InstanceData* instances, int instanceCount, GLenum topology = GL_TRIANGLES, int instanceDivisor = 1);
+    // draw with the position-only stream (falls back to the full vertex format if there is none)
+    void drawDepth(GLenum topology = GL_TRIANGLES);
+    void drawDepthInstanced(const InstanceData* instances, int instanceCount, GLenum topology = GL_TRIANGLES);
+    // same, with the instance data already in a buffer (e.g. a range of a StreamBuffer) at the given offset
+    void drawInstanced(GLuint instanceBuffer, GLintptr offset, int instanceCount, GLenum topology = GL_TRIANGLES, int instanceDivisor = 1);
+    void drawDepthInstanced(GLuint instanceBuffer, GLintptr offset, int instanceCount, GLenum topology = GL_TRIANGLES);
+    // draw the model space bounding box as triangles (position only, for occlusion queries)
+    void drawBounds();
+
+    inline Mesh* GetMesh() { return &mMesh; }
+
+    // compute the mesh bounding box and sphere from interleaved vertex data
+    // (position first, stride given in floats)
+    void computeBounds(const GLfloat* vertexData, int numVertices, int stride);
+    // create the position-only stream for depth-only draws from interleaved vertex data,
+    // sharing the index buffer if there is one
+    void createPositionStream(const GLfloat* vertexData, int numVertices, int stride);
+
+    bool mIsValid = false;
+
+private:
+    
+    Mesh mMesh;
+
+    // per-instance attribute buffer, created on first instanced draw
+    GLuint mInstanceVBO = 0;
+    int mInstanceCapacity = 0;
+    int mInstanceDivisor = 1;
+    // buffer and offset the instance attributes of VAO and depthVAO currently read from
+    GLuint mInstanceSource[2] = { 0, 0 };
+    GLintptr mInstanceOffset[2] = { 0, 0 };
+
+    // bounding box geometry, created on first drawBounds()
+    GLuint mBoundsVAO = 0;
+    GLuint mBoundsVBO = 0;
+    GLuint mBoundsIBO = 0;
+
+    // interleaved vertices (position, normal and optionally texture coordinates) and indices
+    // read by importModel() and waiting for upload()
+    std::vector<GLfloat> mPendingVertices;
+    std::vector<GLint> mPendingIndices;
+    int mPendingStride = 0;     // in floats
+ 
+    void BindInstanceAttributes(GLuint VAO, GLuint buffer, GLintptr offset);
+    void SetupInstanceAttributes(GLuint VAO, GLuint buffer, GLintptr offset);
+    void UploadInstances(const InstanceData* instances, int instanceCount);
+    void DrawVertices(GLenum topology, int instanceCount);
+    void LoadMesh(const aiMesh *mesh);
+    void loadMeshWithTexture(const aiMesh* mesh);
+};
+
+#endif
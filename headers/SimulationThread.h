@@ -0,0 +1,57 @@
+#ifndef SIMULATION_THREAD_H
+#define SIMULATION_THREAD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/*****************************************************************
+ * runs the simulation step on its own thread, one frame ahead of
+ * the renderer
+ *
+ * once the renderer has taken a snapshot it calls frameConsumed()
+ * and the next step runs while the frame is drawn, so a frame
+ * costs the longer of the two instead of their sum. a simulation
+ * slower than the renderer steps back to back while the renderer
+ * keeps drawing the last snapshot. snapshots are handed over by
+ * the step function, e.g. through a TripleBuffer
+ *****************************************************************/
+
+class SimulationThread
+{
+public:
+	SimulationThread();
+	~SimulationThread();
+
+	// start calling step(seconds since the previous step) on the thread, the first step runs straight away
+	void start(const std::function<void(float)>& step);
+	// let the current step finish and end the thread
+	void stop();
+	inline bool isRunning() const { return mThread.joinable(); }
+
+	// the renderer took the last snapshot, compute the next one
+	void frameConsumed();
+
+	// cost of the last step in milliseconds
+	inline float getStepTime() const { return mStepTime.load(); }
+	inline uint64_t getStepCount() const { return mStepCount.load(); }
+
+private:
+	std::thread mThread;
+	std::function<void(float)> mStep;
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	bool mStepRequested = false;
+	bool mQuit = false;
+
+	std::atomic<float> mStepTime;
+	std::atomic<uint64_t> mStepCount;
+
+	void threadLoop();
+};
+
+#endif
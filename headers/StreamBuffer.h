@@ -0,0 +1,72 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "utilities.h"
+
+/*****************************************************************
+ * ring buffer for data written by the CPU every frame
+ *
+ * the buffer holds one region per frame in flight; per-frame data
+ * is sub-allocated from the current region and drawn from by
+ * offset, and a fence per region keeps the CPU from overwriting
+ * data the GPU has not consumed yet
+ *
+ * with GL 4.4 / ARB_buffer_storage the buffer is mapped once,
+ * persistently and coherently, and written in place; otherwise
+ * writes go to a staging copy that flush() uploads with an
+ * unsynchronised map of the (fenced, so unused) range
+ *****************************************************************/
+
+class StreamBuffer
+{
+public:
+	static const int kFrames = 3;
+
+	StreamBuffer();
+	~StreamBuffer();
+
+	// create the buffer with frameSize bytes per frame in flight
+	void create(size_t frameSize);
+
+	// move to the next region, waiting for the GPU only if it is still reading it
+	void beginFrame();
+	// reserve size bytes at a multiple of alignment, returns where to write them
+	// (nullptr if the region is full) and their offset in the buffer
+	void* allocate(size_t size, size_t alignment, GLintptr& offset);
+	// make everything allocated so far visible to the GPU, call before drawing from it
+	void flush();
+	// fence the region for the commands issued this frame
+	void endFrame();
+
+	inline GLuint getBuffer() const { return mBuffer; }
+	inline bool isValid() const { return mBuffer != 0; }
+	inline bool isPersistent() const { return mMapped != nullptr; }
+
+	// bytes used in the last completed frame, and times beginFrame() had to wait for the GPU
+	inline size_t getFrameUsage() const { return mLastUsage; }
+	inline size_t getFrameSize() const { return mFrameSize; }
+	inline int getWaitCount() const { return mWaitCount; }
+
+private:
+	GLuint mBuffer = 0;
+	size_t mFrameSize = 0;
+	uint8_t* mMapped = nullptr;		// whole buffer, when persistently mapped
+	std::vector<uint8_t> mStaging;	// current region, when not
+
+	GLsync mFences[kFrames];
+	int mFrame = 0;
+	size_t mUsed = 0;
+	size_t mFlushed = 0;
+
+	size_t mLastUsage = 0;
+	int mWaitCount = 0;
+
+	// ring buffers own GL objects and cannot be copied
+	StreamBuffer(const StreamBuffer&);
+	StreamBuffer& operator=(const StreamBuffer&);
+};
+
+#endif
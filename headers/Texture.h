@@ -1,37 +1,61 @@
-#ifndef TEXTURE_H
-#define TEXTURE_H
-
-#include "utilities.h"
-
-class Texture
-{
-public:
-	Texture();
-	~Texture();
-
-	// binds the texture for use
-	void bind();
-	// set texture parameters
-	void setFilterParams(GLuint magFilter, GLuint minFilter);
-	void setWrapParams(GLuint wrapS, GLuint wrapT);
-	// generate a 2D texture from image data
-	void generate(unsigned char* imageData, int width, int height);	
-	// generate a 2D texture from an image file
-	void generate(const std::string filename);
-	// generate a cube environment map from image files
-	void generate(const std::string fileFront, const std::string fileBack,
-		const std::string fileLeft, const std::string fileRight,
-		const std::string fileTop, const std::string fileBottom);
-
-private:
-	// texture ID and parameters
-	GLuint mTextureID = 0;
-	GLenum mTarget = 0;
-	GLuint mMagFilter = GL_LINEAR;
-	GLuint mMinFilter = GL_LINEAR_MIPMAP_LINEAR;
-	GLuint mWrapS = GL_REPEAT;
-	GLuint mWrapT = GL_REPEAT;
-};
-
-#endif
-
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include "utilities.h"
+
+class Texture
+{
+public:
+	Texture();
+	~Texture();
+
+	// binds the texture for use on a texture unit
+	void bind(int unit = 0);
+	// set texture parameters
+	void setFilterParams(GLuint magFilter, GLuint minFilter);
+	void setWrapParams(GLuint wrapS, GLuint wrapT);
+	// generate a 2D texture from image data
+	void generate(unsigned char* imageData, int width, int height);	
+	// generate a 2D texture from an image file
+	void generate(const std::string filename);
+	// generate a cube environment map from image files
+	void generate(const std::string fileFront, const std::string fileBack,
+		const std::string fileLeft, const std::string fileRight,
+		const std::string fileTop, const std::string fileBottom);
+
+	// decode image files without touching GL, so loading can run on any thread;
+	// upload() then creates the texture on the GL thread. false if an image could not be loaded
+	bool load(const std::string filename);
+	bool load(const std::string fileFront, const std::string fileBack,
+		const std::string fileLeft, const std::string fileRight,
+		const std::string fileTop, const std::string fileBottom);
+	// create the texture from the loaded images and free them
+	void upload();
+
+	// texture target (GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP), 0 if not generated
+	inline GLenum getTarget() const { return mTarget; }
+
+private:
+	// texture ID and parameters
+	GLuint mTextureID = 0;
+	GLenum mTarget = 0;
+	GLuint mMagFilter = GL_LINEAR;
+	GLuint mMinFilter = GL_LINEAR_MIPMAP_LINEAR;
+	GLuint mWrapS = GL_REPEAT;
+	GLuint mWrapT = GL_REPEAT;
+
+	// images decoded by load(), in cube map face order for cube maps
+	std::vector<unsigned char*> mPendingImages;
+	GLenum mPendingTarget = 0;
+	int mPendingWidth = 0;
+	int mPendingHeight = 0;
+
+	void freePendingImages();
+
+	// textures own GL objects and cannot be copied
+	Texture(const Texture&);
+	Texture& operator=(const Texture&);
+};
+
+#endif
+
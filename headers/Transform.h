@@ -0,0 +1,12 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// build the matrix T * R * S of a translation, rotation and scale, and its normal matrix;
+// the inverse transpose of R * S is R * S^-1, so the normal matrix needs no general inverse
+void buildTransformMatrices(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale,
+	glm::mat4& worldMatrix, glm::mat3& normalMatrix);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+/*****************************************************************
+ * lock-free triple buffer for one producer and one consumer
+ *
+ * the producer fills the back slot and swaps it with the shared
+ * middle slot; the consumer swaps the middle slot with its front
+ * slot only if something was published since. neither side ever
+ * waits, the consumer always sees the latest complete value, and
+ * values the consumer did not get to in time are dropped
+ *****************************************************************/
+
+template<typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() : mMiddle(1) {}
+
+	// slot the producer writes the next value into
+	inline T& back() { return mSlots[mBack]; }
+	// hand the back slot to the consumer
+	inline void publish()
+	{
+		mBack = mMiddle.exchange(mBack | kNewFlag, std::memory_order_acq_rel) & kIndexMask;
+	}
+
+	// take the latest published value, false if nothing was published since the last call
+	inline bool update()
+	{
+		if ((mMiddle.load(std::memory_order_relaxed) & kNewFlag) == 0)
+			return false;
+
+		mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & kIndexMask;
+		return true;
+	}
+	// value the consumer is using
+	inline const T& front() const { return mSlots[mFront]; }
+
+private:
+	static const int kIndexMask = 3;
+	static const int kNewFlag = 4;	// set in the middle index while it holds an unread value
+
+	T mSlots[3];
+	int mBack = 0;
+	int mFront = 2;
+	std::atomic<int> mMiddle;
+};
+
+#endif
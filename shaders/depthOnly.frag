@@ -0,0 +1,6 @@
+#version 330 core
+
+// depth only, no colour output
+void main()
+{
+}
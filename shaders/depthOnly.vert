@@ -0,0 +1,18 @@
+#version 330 core
+
+// input data
+layout(location = 0) in vec3 aPosition;
+
+// uniform input data
+uniform mat4 uProjViewMatrix;
+uniform mat4 uModelMatrix;
+
+// depth must match the colour pass exactly (GL_EQUAL depth test)
+invariant gl_Position;
+
+void main()
+{
+	// same transform order as the colour pass shaders
+	vec4 worldPosition = uModelMatrix * vec4(aPosition, 1.0f);
+    gl_Position = uProjViewMatrix * worldPosition;
+}
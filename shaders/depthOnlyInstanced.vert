@@ -0,0 +1,20 @@
+#version 330 core
+
+// input data
+layout(location = 0) in vec3 aPosition;
+
+// per-instance input data
+layout(location = 4) in mat4 aModelMatrix;
+
+// uniform input data
+uniform mat4 uProjViewMatrix;
+
+// depth must match the colour pass exactly (GL_EQUAL depth test)
+invariant gl_Position;
+
+void main()
+{
+	// same transform order as the colour pass shaders
+	vec4 worldPosition = aModelMatrix * vec4(aPosition, 1.0f);
+    gl_Position = uProjViewMatrix * worldPosition;
+}
@@ -1,32 +1,47 @@
-#version 330 core
-
-// input data
-layout(location = 0) in vec3 aPosition;
-layout(location = 1) in vec3 aNormal;
-layout(location = 2) in vec2 aTexCoord;
-
-// uniform input data
-uniform mat4 uMVPMatrix;
-uniform mat4 uModelMatrix;
-uniform mat3 uNormalMatrix;
-
-//add
-uniform sampler2D uTextureSampler2;
-uniform float uFactor;
-
-// output data
-out vec3 vPosition;
-out vec3 vNormal;
-out vec2 vTexCoord;
-
-void main()
-{
-	// set vertex position
-    gl_Position = uMVPMatrix * vec4(aPosition, 1.0f);
-
-	// set vertex shader output
-	// will be interpolated for each fragment
-	vPosition = (uModelMatrix * vec4(aPosition, 1.0f)).xyz;
-	vNormal = uNormalMatrix * aNormal;
-	vTexCoord = aTexCoord;
-}
+#version 330 core
+
+// input data
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoord;
+
+// uniform input data
+uniform mat4 uProjViewMatrix;
+uniform vec3 uViewpoint;
+uniform int uViewIndex;
+uniform mat4 uModelMatrix;
+uniform mat3 uNormalMatrix;
+uniform int uMaterialIndex;
+
+//add
+uniform sampler2D uTextureSampler2;
+uniform float uFactor;
+
+// output data
+out vec3 vPosition;
+out vec3 vNormal;
+out vec2 vTexCoord;
+flat out vec3 vViewpoint;
+flat out int vViewIndex;
+flat out int vMaterialIndex;
+
+// depth must match the depth pre-pass exactly (GL_EQUAL depth test)
+invariant gl_Position;
+
+void main()
+{
+	// world space vertex position
+	vec4 worldPosition = uModelMatrix * vec4(aPosition, 1.0f);
+
+	// set vertex position
+    gl_Position = uProjViewMatrix * worldPosition;
+
+	// set vertex shader output
+	// will be interpolated for each fragment
+	vPosition = worldPosition.xyz;
+	vNormal = uNormalMatrix * aNormal;
+	vTexCoord = aTexCoord;
+	vViewpoint = uViewpoint;
+	vViewIndex = uViewIndex;
+	vMaterialIndex = uMaterialIndex;
+}
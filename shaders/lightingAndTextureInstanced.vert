@@ -0,0 +1,45 @@
+#version 330 core
+
+// input data
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoord;
+
+// per-instance input data
+layout(location = 4) in mat4 aModelMatrix;
+layout(location = 8) in mat3 aNormalMatrix;
+layout(location = 11) in int aMaterialIndex;
+
+// uniform input data
+uniform mat4 uProjViewMatrix;
+uniform vec3 uViewpoint;
+uniform int uViewIndex;
+
+// output data
+out vec3 vPosition;
+out vec3 vNormal;
+out vec2 vTexCoord;
+flat out vec3 vViewpoint;
+flat out int vViewIndex;
+flat out int vMaterialIndex;
+
+// depth must match the depth pre-pass exactly (GL_EQUAL depth test)
+invariant gl_Position;
+
+void main()
+{
+	// world space vertex position
+	vec4 worldPosition = aModelMatrix * vec4(aPosition, 1.0f);
+
+	// set vertex position
+    gl_Position = uProjViewMatrix * worldPosition;
+
+	// set vertex shader output
+	// will be interpolated for each fragment
+	vPosition = worldPosition.xyz;
+	vNormal = aNormalMatrix * aNormal;
+	vTexCoord = aTexCoord;
+	vViewpoint = uViewpoint;
+	vViewIndex = uViewIndex;
+	vMaterialIndex = aMaterialIndex;
+}
@@ -0,0 +1,52 @@
+#version 330 core
+
+// input data
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoord;
+
+// per-instance input data, repeated for every view
+layout(location = 4) in mat4 aModelMatrix;
+layout(location = 8) in mat3 aNormalMatrix;
+layout(location = 11) in int aMaterialIndex;
+layout(location = 12) in int aViewMask;
+
+// uniform input data, one entry per view
+uniform int uNumViews;
+uniform mat4 uProjViewMatrices[4];
+uniform vec3 uViewpoints[4];
+
+// output data, routed to its viewport by the geometry shader
+out VertexData
+{
+	vec3 position;
+	vec3 normal;
+	vec3 tangent;
+	vec2 texCoord;
+	flat vec3 viewpoint;
+	flat int materialIndex;
+	flat int viewIndex;
+	flat int viewMask;
+} vOut;
+
+void main()
+{
+	// consecutive instances draw the same object into consecutive views
+	int view = gl_InstanceID % uNumViews;
+
+	// world space vertex position
+	vec4 worldPosition = aModelMatrix * vec4(aPosition, 1.0f);
+
+	// set vertex position
+    gl_Position = uProjViewMatrices[view] * worldPosition;
+
+	// set vertex shader output
+	vOut.position = worldPosition.xyz;
+	vOut.normal = aNormalMatrix * aNormal;
+	vOut.tangent = vec3(0.0f);
+	vOut.texCoord = aTexCoord;
+	vOut.viewpoint = uViewpoints[view];
+	vOut.materialIndex = aMaterialIndex;
+	vOut.viewIndex = view;
+	vOut.viewMask = aViewMask;
+}
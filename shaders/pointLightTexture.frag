@@ -1,91 +1,208 @@
-#version 330 core
-
-// interpolated values from the vertex shaders
-in vec3 vPosition;
-in vec3 vNormal;
-in vec2 vTexCoord;
-
-// light properties
-struct Light
-{
-	vec3 pos;
-	vec3 La;
-	vec3 Ld;
-	vec3 Ls;
-	vec3 att;	// constant, linear, quadratic
-};
-
-// material properties
-struct Material
-{
-	vec3 Ka;
-	vec3 Kd;
-	vec3 Ks;
-	float shininess;
-};
-
-// uniform input data
-uniform vec3 uViewpoint;
-uniform Light uLight;
-uniform Material uMaterial;
-uniform sampler2D uTextureSampler;
-uniform samplerCube uEnvironmentMap;
-
-uniform bool hasEnvMap;
-
-
-// output data
-out vec4 fColor;
-
-void main()
-{
-	// fragment normal
-    vec3 n = normalize(vNormal);
-
-	// vector toward the viewer
-	vec3 v = normalize(uViewpoint - vPosition);
-
-	// vector towards the light
-    vec3 l = normalize(uLight.pos - vPosition);
-
-	// halfway vector
-	vec3 h = normalize(l + v);
-
-	// calculate ambient, diffuse and specular intensities
-	vec3 Ia = uLight.La * uMaterial.Ka;
-	vec3 Id = vec3(0.0f);
-	vec3 Is = vec3(0.0f);
-	float dotLN = max(dot(l, n), 0.0f);
-
-	if(dotLN > 0.0f)
-	{
-		// attenuation
-		float dist = length(uLight.pos - vPosition);
-		float attenuation = 1.0f / (uLight.att.x + dist * uLight.att.y + dist * dist * uLight.att.z);
-
-		Id = uLight.Ld * uMaterial.Kd * dotLN * attenuation;
-		Is = uLight.Ls * uMaterial.Ks * pow(max(dot(n, h), 0.0f), uMaterial.shininess) * attenuation;
-	}
-
-	vec3 cfColor;
-
-	// intensity of reflected light
-	cfColor = Ia + Id + Is;
-
-	if(hasEnvMap)
-	{
-		vec3 reflectEnvMap = reflect(-v, n);
-
-		// modulate with environment map reflection
-		cfColor *= texture(uEnvironmentMap, reflectEnvMap).rgb;
-	}
-	else
-	{
-		// modulate with texture
-		cfColor *= texture(uTextureSampler, vTexCoord).rgb;
-	}
-
-	fColor = vec4(cfColor, 1.0f);
-
-
-}
+#version 330 core
+
+// interpolated values from the vertex shaders
+in vec3 vPosition;
+in vec3 vNormal;
+in vec2 vTexCoord;
+flat in vec3 vViewpoint;
+flat in int vViewIndex;
+flat in int vMaterialIndex;
+
+// light properties
+struct Light
+{
+	vec3 pos;
+	vec3 La;
+	vec3 Ld;
+	vec3 Ls;
+	vec3 att;	// constant, linear, quadratic
+};
+
+// material properties
+struct Material
+{
+	vec3 Ka;
+	vec3 Kd;
+	vec3 Ks;
+	vec3 emission;
+	float shininess;
+};
+
+// uniform input data
+uniform Light uLight;
+uniform sampler2D uTextureSampler;
+uniform samplerCube uEnvironmentMap;
+
+uniform bool hasEnvMap;
+
+
+// material entries, four texels each: Ka/shininess, Kd, Ks, emission
+uniform samplerBuffer uMaterials;
+
+// shadow cube map of the main light, storing distance / uShadowFar
+uniform bool uShadowsEnabled;
+uniform samplerCubeShadow uShadowMap;
+uniform float uShadowFar;
+
+// clustered lights, grid dimensions must match LightClusters
+const int kClusterTilesX = 16;
+const int kClusterTilesY = 9;
+const int kClusterSlices = 24;
+const int kClusterLightTexels = 5;
+
+uniform int uClusterLightCount;
+uniform samplerBuffer uClusterLights;		// position/type, direction/cos inner, Ld/cos outer, Ls/radius, att
+uniform usamplerBuffer uClusterGrid;		// offset and count per cluster
+uniform usamplerBuffer uClusterIndices;		// light indices of all clusters
+uniform vec4 uClusterViewports[4];			// x, y, width, height
+uniform vec4 uClusterDepthPlanes[4];		// distance along the view direction
+uniform vec3 uClusterDepthParams[4];		// slice scale, slice bias, 1 for logarithmic slices
+
+
+// output data
+out vec4 fColor;
+
+// material entry of the fragment
+Material fetchMaterial(int index)
+{
+	int base = index * 4;
+	vec4 ambientShininess = texelFetch(uMaterials, base);
+
+	Material m;
+	m.Ka = ambientShininess.rgb;
+	m.Kd = texelFetch(uMaterials, base + 1).rgb;
+	m.Ks = texelFetch(uMaterials, base + 2).rgb;
+	m.emission = texelFetch(uMaterials, base + 3).rgb;
+	m.shininess = ambientShininess.a;
+	return m;
+}
+
+// fraction of the main light reaching the fragment
+float mainLightShadow()
+{
+	if (!uShadowsEnabled)
+		return 1.0f;
+
+	// compare against the distance stored in the direction from the light, with a small bias
+	vec3 fromLight = vPosition - uLight.pos;
+	return texture(uShadowMap, vec4(fromLight, (length(fromLight) - 0.05f) / uShadowFar));
+}
+
+// add diffuse and specular light of the lights in the fragment's cluster
+void addClusterLights(vec3 n, vec3 v, Material material, inout vec3 Id, inout vec3 Is)
+{
+	if (uClusterLightCount == 0)
+		return;
+
+	// screen tile and depth slice of the fragment
+	vec4 viewport = uClusterViewports[vViewIndex];
+	vec2 tile = (gl_FragCoord.xy - viewport.xy) / viewport.zw * vec2(kClusterTilesX, kClusterTilesY);
+	float depth = dot(uClusterDepthPlanes[vViewIndex].xyz, vPosition) + uClusterDepthPlanes[vViewIndex].w;
+	vec3 params = uClusterDepthParams[vViewIndex];
+	float slice = (params.z > 0.0f ? log(max(depth, 0.0001f)) : depth) * params.x + params.y;
+	ivec3 cell = clamp(ivec3(floor(vec3(tile, slice))), ivec3(0), ivec3(kClusterTilesX - 1, kClusterTilesY - 1, kClusterSlices - 1));
+	int cluster = ((vViewIndex * kClusterSlices + cell.z) * kClusterTilesY + cell.y) * kClusterTilesX + cell.x;
+
+	uvec2 range = texelFetch(uClusterGrid, cluster).xy;
+	for (uint i = 0u; i < range.y; i++)
+	{
+		int base = int(texelFetch(uClusterIndices, int(range.x + i)).r) * kClusterLightTexels;
+		vec4 posType = texelFetch(uClusterLights, base);
+		vec4 dirInner = texelFetch(uClusterLights, base + 1);
+		vec4 diffuseOuter = texelFetch(uClusterLights, base + 2);
+		vec4 specularRadius = texelFetch(uClusterLights, base + 3);
+		vec3 att = texelFetch(uClusterLights, base + 4).xyz;
+
+		// directional lights shine along their direction, the others from their position
+		vec3 l = -dirInner.xyz;
+		float attenuation = 1.0f;
+		if (posType.w != 2.0f)
+		{
+			vec3 toLight = posType.xyz - vPosition;
+			float dist = length(toLight);
+			if (dist > specularRadius.w)
+				continue;
+
+			l = toLight / dist;
+			attenuation = 1.0f / (att.x + dist * att.y + dist * dist * att.z);
+
+			// spotlight cone
+			if (posType.w == 3.0f)
+				attenuation *= smoothstep(diffuseOuter.w, dirInner.w, dot(-l, dirInner.xyz));
+		}
+
+		float dotLN = max(dot(l, n), 0.0f);
+		if (dotLN > 0.0f)
+		{
+			vec3 h = normalize(l + v);
+			Id += diffuseOuter.rgb * material.Kd * dotLN * attenuation;
+			Is += specularRadius.rgb * material.Ks * pow(max(dot(n, h), 0.0f), material.shininess) * attenuation;
+		}
+	}
+}
+
+
+void main()
+{
+	// material of the fragment
+	Material material = fetchMaterial(vMaterialIndex);
+
+	// fragment normal
+    vec3 n = normalize(vNormal);
+
+	// vector toward the viewer
+	vec3 v = normalize(vViewpoint - vPosition);
+
+	// vector towards the light
+    vec3 l = normalize(uLight.pos - vPosition);
+
+	// halfway vector
+	vec3 h = normalize(l + v);
+
+	// calculate ambient, diffuse and specular intensities
+	vec3 Ia = uLight.La * material.Ka;
+	vec3 Id = vec3(0.0f);
+	vec3 Is = vec3(0.0f);
+	float dotLN = max(dot(l, n), 0.0f);
+
+	if(dotLN > 0.0f)
+	{
+		// attenuation
+		float dist = length(uLight.pos - vPosition);
+		float attenuation = 1.0f / (uLight.att.x + dist * uLight.att.y + dist * dist * uLight.att.z);
+
+		// shadow of the main light
+		attenuation *= mainLightShadow();
+
+		Id = uLight.Ld * material.Kd * dotLN * attenuation;
+		Is = uLight.Ls * material.Ks * pow(max(dot(n, h), 0.0f), material.shininess) * attenuation;
+	}
+
+	// lights of the fragment's cluster
+	addClusterLights(n, v, material, Id, Is);
+
+	vec3 cfColor;
+
+	// intensity of reflected light
+	cfColor = Ia + Id + Is;
+
+	if(hasEnvMap)
+	{
+		vec3 reflectEnvMap = reflect(-v, n);
+
+		// modulate with environment map reflection
+		cfColor *= texture(uEnvironmentMap, reflectEnvMap).rgb;
+	}
+	else
+	{
+		// modulate with texture
+		cfColor *= texture(uTextureSampler, vTexCoord).rgb;
+	}
+
+	// light given off by the surface itself, independent of any light source
+	cfColor += material.emission;
+
+	fColor = vec4(cfColor, 1.0f);
+
+
+}
@@ -0,0 +1,14 @@
+#version 330 core
+
+// interpolated values from the vertex shader
+in vec3 vPosition;
+
+// uniform input data
+uniform vec3 uLightPosition;
+uniform float uFarPlane;
+
+void main()
+{
+	// store the distance to the light, the same in every cube map face
+	gl_FragDepth = length(vPosition - uLightPosition) / uFarPlane;
+}
@@ -0,0 +1,20 @@
+#version 330 core
+
+// input data
+layout(location = 0) in vec3 aPosition;
+
+// uniform input data
+uniform mat4 uProjViewMatrix;	// cube map face
+uniform mat4 uModelMatrix;
+
+// output data
+out vec3 vPosition;
+
+void main()
+{
+	// world space vertex position
+	vec4 worldPosition = uModelMatrix * vec4(aPosition, 1.0f);
+
+	gl_Position = uProjViewMatrix * worldPosition;
+	vPosition = worldPosition.xyz;
+}